@@ -0,0 +1,63 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/*
+ * completion based interface for dpoll sockets
+ *
+ * instead of emulating readiness, pops and pushes are posted against a dpoll
+ * instance and their results are collected with `dpoll_reap` after
+ * `dpoll_epoll_pwait` returns. the wait keeps returning early for as long as
+ * there are unreaped completions.
+ *
+ * all functions return -1 and set errno on failure
+ */
+
+enum dpoll_opcode {
+	DPOLL_OPC_POP,
+	DPOLL_OPC_PUSH,
+};
+
+struct dpoll_op;
+
+struct dpoll_completion {
+	enum dpoll_opcode opcode;
+	int qd;
+	/// number of bytes popped or pushed, 0 on eof, negative errno on failure
+	ssize_t res;
+	void *data;
+	struct dpoll_op *op;
+};
+
+/// true if `qd` is a dpoll socket and completion mode was enabled with
+/// `DEMI_EPOLL_COMPLETION=1`
+bool dpoll_completion_enabled(int qd);
+
+/// at most one pop can be posted per socket, until its completion is released
+/// further posts fail with EALREADY
+int dpoll_post_pop(int dpollfd, int qd, void *data);
+
+/// the data is copied, so the iovs can be reused as soon as this returns
+///
+/// returns the number of bytes that will be pushed
+ssize_t dpoll_post_push(int dpollfd, int qd, const struct iovec *iov,
+                        int iovcnt, void *data);
+
+/// number of posted operations which were not reaped yet
+size_t dpoll_inflight(int dpollfd);
+
+/// returns the number of completions written into `comps`, every one of them
+/// must be handed back with `dpoll_completion_release`
+int dpoll_reap(int dpollfd, struct dpoll_completion *comps, int max);
+
+/// copies at most `len` bytes of popped data into `buf`
+///
+/// returns the number of bytes copied
+size_t dpoll_completion_read(struct dpoll_completion *comp, void *buf,
+                             size_t len);
+
+/// popped data which was not read is kept by the socket and returned by its
+/// next pop
+void dpoll_completion_release(struct dpoll_completion *comp);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stddef.h>
 #include <sys/epoll.h>
 
 int dpoll_epoll_create(int flags);
@@ -12,4 +13,71 @@ int dpoll_epoll_pwait(int dpollfd, struct epoll_event *events, int maxevents,
 /// functions only used when I want to print something
 void debug_print(void);
 
+/// scheduling classes of the ready list. ready sockets are handed out fifo
+/// within a class and higher classes go first
+enum dpoll_priority {
+	/// listening sockets are high, everything else normal
+	DPOLL_PRIO_DEFAULT = -1,
+	DPOLL_PRIO_HIGH,
+	DPOLL_PRIO_NORMAL,
+	DPOLL_PRIO_LOW,
+	DPOLL_PRIO_COUNT,
+};
+
+/// `qd` must have been added to `dpollfd`, fails with ENOENT otherwise
+int dpoll_set_priority(int dpollfd, int qd, enum dpoll_priority prio);
+
+/// limits how many events of a single wait `prio` can take while lower
+/// classes are waiting, the remaining space is still filled in priority order.
+/// 0, the default, means unlimited
+int dpoll_set_ready_budget(int dpollfd, enum dpoll_priority prio,
+                           unsigned budget);
+
+/// cheap, only reads the configuration from the environment. the libos itself
+/// is initialised by the first `dpoll_socket` call, with the arguments in
+/// `DEMI_EPOLL_LIBOS_ARGS`
 void dpoll_init(void);
+
+/// byte budgets for data held by the shim, 0 means unlimited
+///
+/// `*_recv` limits popped data which was not read yet, once it is reached no
+/// new pops are issued until the application reads. `*_send` limits pushed
+/// data which did not complete yet, writes past it are shortened or fail with
+/// EWOULDBLOCK
+struct dpoll_mem_budget {
+	size_t socket_recv;
+	size_t socket_send;
+	size_t total_recv;
+	size_t total_send;
+};
+
+struct dpoll_mem_usage {
+	size_t recv;
+	size_t send;
+};
+
+void dpoll_set_mem_budget(const struct dpoll_mem_budget *budget);
+void dpoll_get_mem_budget(struct dpoll_mem_budget *budget);
+
+/// process-wide usage
+void dpoll_get_mem_usage(struct dpoll_mem_usage *usage);
+/// usage of a single dpoll socket
+int dpoll_get_socket_mem_usage(int qd, struct dpoll_mem_usage *usage);
+
+/// wakeup channel of a dpoll instance which can be rung from any thread. a
+/// ring is only a store while the instance is busy, it turns into an eventfd
+/// write only when the instance sleeps in the kernel
+///
+/// the instance reports it as EPOLLIN on `dpoll_doorbell_fd` once that was
+/// added with `dpoll_epoll_ctl`, the fd must not be read or written directly
+struct dpoll_doorbell;
+
+/// there is at most one doorbell per instance, it is created by the first call
+///
+/// returns NULL and sets errno on failure, the doorbell stays valid until it
+/// is handed back with `dpoll_doorbell_put`, even if the instance is closed
+struct dpoll_doorbell *dpoll_doorbell_get(int dpollfd);
+void dpoll_doorbell_put(struct dpoll_doorbell *db);
+int dpoll_doorbell_fd(const struct dpoll_doorbell *db);
+/// thread safe
+void dpoll_doorbell_ring(struct dpoll_doorbell *db);
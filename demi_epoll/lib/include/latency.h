@@ -0,0 +1,60 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * latency of demikernel operations
+ *
+ * with `DEMI_EPOLL_LATENCY=1` the time from issuing a push, pop or accept to
+ * handling its successful result is recorded, per operation and additionally
+ * per listening socket for accepts. pops issued ahead of a read and pushes
+ * which wait for the application to look at them include that wait, so a
+ * growing gap between the two modes points at the application rather than the
+ * network stack
+ *
+ * values are in ns and counted in log-linear buckets, every power of two is
+ * split into `1 << DPOLL_LAT_SUB_BITS` buckets, so a bucket is at most ~6%
+ * wide. values past the last bucket are counted by it
+ */
+
+#define DPOLL_LAT_SUB_BITS 4
+#define DPOLL_LAT_SUB_BUCKETS (1 << DPOLL_LAT_SUB_BITS)
+/// covers up to 2^40 ns, about 18 minutes
+#define DPOLL_LAT_MAX_BITS 40
+#define DPOLL_LAT_BUCKETS \
+	((DPOLL_LAT_MAX_BITS - DPOLL_LAT_SUB_BITS + 2) * DPOLL_LAT_SUB_BUCKETS)
+
+enum dpoll_latency_op {
+	DPOLL_LAT_PUSH,
+	DPOLL_LAT_POP,
+	DPOLL_LAT_ACCEPT,
+	DPOLL_LAT_OP_COUNT,
+};
+
+struct dpoll_latency_hist {
+	uint64_t count;
+	uint64_t min;
+	uint64_t max;
+	uint64_t sum;
+	uint64_t buckets[DPOLL_LAT_BUCKETS];
+};
+
+/// true if recording was enabled with `DEMI_EPOLL_LATENCY=1`
+bool dpoll_latency_enabled(void);
+
+/// copies the process-wide histograms, indexed by `enum dpoll_latency_op`
+void dpoll_get_latency_histograms(struct dpoll_latency_hist *hists);
+
+/// accept latency of the listening socket `qd`
+///
+/// returns -1 and sets errno to EINVAL if `qd` is not listening, or to ENOENT
+/// if recording is disabled
+int dpoll_get_listener_latency_histogram(int qd,
+                                         struct dpoll_latency_hist *hist);
+
+/// clears the process-wide histograms and the ones of all listeners
+void dpoll_reset_latency_histograms(void);
+
+/// smallest value counted by bucket `i`
+uint64_t dpoll_latency_bucket_value(size_t i);
@@ -1,5 +1,6 @@
 #pragma once
 #include <bits/socket.h>
+#include <stdbool.h>
 
 /*
  * all functions here behave like posix socket calls (i.e. return qd or -1 and set errno on failure)
@@ -18,20 +19,43 @@ int dpoll_accept(int qd, struct sockaddr *addr, socklen_t *addrlen);
 
 int dpoll_listen(int qd, int backlog);
 
-/// the next 2 functions are not really that supported
+/// getsockname and setsockopt are not really that supported, only
+/// SO_REUSEPORT is passed on to the libos
 int dpoll_getsockname(int qd, struct sockaddr *addr, socklen_t *addrlen);
 
 int dpoll_setsockopt(int qd, int level, int optname, const void *optval,
                      socklen_t optlen);
 
+/// dpoll sockets only exist in the process which created them, passing one
+/// with SCM_RIGHTS fails with EOPNOTSUPP. processes which want to serve the
+/// same port each listen on their own socket with SO_REUSEPORT instead, which
+/// fails if the libos cannot share the port. `DEMI_EPOLL_REUSEPORT=1` sets it
+/// on every listening socket. such a socket is only bound by dpoll_listen, so
+/// that is where an address in use is reported
+///
+/// on a dpoll socket only MSG_DONTWAIT and MSG_NOSIGNAL are accepted, other
+/// flags fail with EOPNOTSUPP
 ssize_t dpoll_sendmsg(int qd, const struct msghdr *msg, int flags);
 
+/// on a dpoll socket only MSG_DONTWAIT and MSG_CMSG_CLOEXEC are accepted,
+/// other flags (e.g. MSG_PEEK or MSG_TRUNC) fail with EOPNOTSUPP
 ssize_t dpoll_recvmsg(int qd, struct msghdr *msg, int flags);
 
 int dpoll_close(int qd);
 
+/// true if `qd` was created by `dpoll_socket` or `dpoll_accept`
+bool dpoll_is_socket(int qd);
+
 ssize_t dpoll_write(int qd, const void *buf, size_t count);
 ssize_t dpoll_read(int qd, void *buf, size_t count);
 
 ssize_t dpoll_readv(int qd, struct iovec* iov, int iovcnt);
 ssize_t dpoll_writev(int qd, const struct iovec *iov, int iovcnt);
+
+/// times the connection out once the shim saw no pushes or pops for
+/// `timeout_ms`, 0 disables it. expirations are reported as
+/// EPOLLIN | EPOLLRDHUP and reads fail with ETIMEDOUT. the timing wheel ticks
+/// every 100ms, so expirations can be late by about as much
+///
+/// fails with EOPNOTSUPP for non dpoll sockets
+int dpoll_set_idle_timeout(int qd, unsigned timeout_ms);
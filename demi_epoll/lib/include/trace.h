@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+
+/*
+ * binary trace of dpoll calls
+ *
+ * with `DEMI_EPOLL_TRACE=<path>` every `dpoll_*` call and every demikernel
+ * result the shim collects is recorded into a ring buffer, which is written to
+ * `<path>` on exit. the ring keeps the last `DEMI_EPOLL_TRACE_SIZE` records
+ * (65536 by default). the file is a `struct dpoll_trace_header` followed by
+ * `count` records, oldest first
+ */
+
+#define DPOLL_TRACE_MAGIC 0x6372746c6c6f7064ULL /* "dpolltrc" */
+#define DPOLL_TRACE_VERSION 1
+
+enum dpoll_trace_call {
+	DPOLL_TR_EPOLL_CREATE,
+	/// args: op, fd, events
+	DPOLL_TR_EPOLL_CTL,
+	/// args: maxevents, timeout
+	DPOLL_TR_EPOLL_PWAIT,
+	/// args: domain, type, protocol
+	DPOLL_TR_SOCKET,
+	/// args: ipv4 address, port
+	DPOLL_TR_BIND,
+	DPOLL_TR_CONNECT,
+	DPOLL_TR_ACCEPT,
+	/// args: backlog
+	DPOLL_TR_LISTEN,
+	DPOLL_TR_CLOSE,
+	/// args: number of bytes, number of iovs
+	DPOLL_TR_READ,
+	DPOLL_TR_WRITE,
+	/// args: epoll fd
+	DPOLL_TR_POST_POP,
+	/// args: epoll fd, number of bytes, number of iovs
+	DPOLL_TR_POST_PUSH,
+	/// args: epoll fd, max
+	DPOLL_TR_REAP,
+	/// not a call, `fd` is the demikernel qd. comes before the record of the
+	/// call whose wait collected it
+	///
+	/// args: opcode, qtoken, number of bytes
+	DPOLL_TR_DEMI_RESULT,
+
+	DPOLL_TR_COUNT,
+};
+
+struct dpoll_trace_header {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t rec_size;
+	uint64_t count;
+	/// records overwritten because the ring was full
+	uint64_t dropped;
+};
+
+struct dpoll_trace_rec {
+	/// CLOCK_MONOTONIC, in ns
+	uint64_t start;
+	uint64_t end;
+	uint32_t call;
+	int32_t fd;
+	int64_t args[3];
+	int64_t ret;
+	/// errno if `ret` is negative
+	int32_t err;
+	uint32_t reserved;
+};
+
+/// writes the records collected so far, returns -1 and sets errno on failure
+int dpoll_trace_dump(const char *path);
@@ -0,0 +1,108 @@
+#include "budget.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/param.h>
+
+#include "log.h"
+
+static struct dpoll_mem_budget budget = { 0 };
+static struct dpoll_mem_usage total = { 0 };
+
+static size_t env_size(const char *const env_name)
+{
+	const char *env = getenv(env_name);
+	if (!env)
+		return 0;
+	char *end;
+	const unsigned long long v = strtoull(env, &end, 10);
+	if (end == env || *end != '\0') {
+		demi_log("ignoring invalid %s: %s\n", env_name, env);
+		return 0;
+	}
+	return v;
+}
+
+void mem_budget_init(void)
+{
+	budget = (struct dpoll_mem_budget){
+		.socket_recv = env_size("DEMI_EPOLL_SOCKET_RECV_BUDGET"),
+		.socket_send = env_size("DEMI_EPOLL_SOCKET_SEND_BUDGET"),
+		.total_recv = env_size("DEMI_EPOLL_RECV_BUDGET"),
+		.total_send = env_size("DEMI_EPOLL_SEND_BUDGET"),
+	};
+}
+
+void mem_charge_recv(socket_t *soc, size_t len)
+{
+	if (soc)
+		soc->mem.recv += len;
+	total.recv += len;
+}
+
+void mem_uncharge_recv(socket_t *soc, size_t len)
+{
+	if (soc) {
+		assert(soc->mem.recv >= len);
+		soc->mem.recv -= len;
+	}
+	assert(total.recv >= len);
+	total.recv -= len;
+}
+
+void mem_charge_send(socket_t *soc, size_t len)
+{
+	if (soc)
+		soc->mem.send += len;
+	total.send += len;
+}
+
+void mem_uncharge_send(socket_t *soc, size_t len)
+{
+	if (soc) {
+		assert(soc->mem.send >= len);
+		soc->mem.send -= len;
+	}
+	assert(total.send >= len);
+	total.send -= len;
+}
+
+static inline bool under(size_t used, size_t limit)
+{
+	return limit == 0 || used < limit;
+}
+
+static inline size_t remaining(size_t used, size_t limit)
+{
+	if (limit == 0)
+		return SIZE_MAX;
+	return used < limit ? limit - used : 0;
+}
+
+bool mem_can_pop(const socket_t *soc)
+{
+	return under(soc->mem.recv, budget.socket_recv) &&
+	       under(total.recv, budget.total_recv);
+}
+
+size_t mem_send_allowance(const socket_t *soc)
+{
+	return MIN(remaining(soc->mem.send, budget.socket_send),
+	           remaining(total.send, budget.total_send));
+}
+
+void dpoll_set_mem_budget(const struct dpoll_mem_budget *b)
+{
+	budget = *b;
+}
+
+void dpoll_get_mem_budget(struct dpoll_mem_budget *b)
+{
+	*b = budget;
+}
+
+void dpoll_get_mem_usage(struct dpoll_mem_usage *usage)
+{
+	*usage = total;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "dpoll.h"
+#include "socket_wrapper.h"
+
+/// reads the initial budgets from `DEMI_EPOLL_{SOCKET_,}{RECV,SEND}_BUDGET`
+void mem_budget_init(void);
+
+/// `soc` can be NULL, in which case only the process-wide usage changes
+void mem_charge_recv(socket_t *soc, size_t len);
+void mem_uncharge_recv(socket_t *soc, size_t len);
+void mem_charge_send(socket_t *soc, size_t len);
+void mem_uncharge_send(socket_t *soc, size_t len);
+
+/// false once either the socket or the process holds at least as many popped
+/// bytes as allowed, in which case no new pop should be issued
+bool mem_can_pop(const socket_t *soc);
+
+/// number of bytes that can still be pushed on `soc`, SIZE_MAX if unlimited
+size_t mem_send_allowance(const socket_t *soc);
@@ -0,0 +1,498 @@
+#include "completions.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <demi/libos.h>
+#include <demi/sga.h>
+#include <demi/wait.h>
+
+#include "budget.h"
+#include "histogram.h"
+#include "idle.h"
+#include "log.h"
+#include "tracer.h"
+#include "utils.h"
+
+#define op_from_ep_entry(_e) container_of((_e), struct dpoll_op, ep_entry)
+
+static struct dpoll_op *op_new(epoll_t *ep, socket_t *soc, int qd,
+                               enum dpoll_opcode opcode, void *data)
+{
+	struct dpoll_op *op = calloc(1, sizeof(*op));
+	if (!op) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	*op = (struct dpoll_op){
+		.opcode = opcode,
+		.ep = ep,
+		.soc = soc,
+		.qd = qd,
+		.data = data,
+	};
+	list_append(&soc->ops, &op->soc_entry);
+	return op;
+}
+
+/// the sga of an op is charged to its socket and the process, or only to the
+/// process once the socket was closed
+static void op_uncharge(struct dpoll_op *op)
+{
+	const size_t len = sga_total_len(&op->sga);
+	if (op->opcode == DPOLL_OPC_POP)
+		mem_uncharge_recv(op->soc, len);
+	else
+		mem_uncharge_send(op->soc, len);
+}
+
+static void op_charge_total(struct dpoll_op *op)
+{
+	const size_t len = sga_total_len(&op->sga);
+	if (op->opcode == DPOLL_OPC_POP)
+		mem_charge_recv(NULL, len);
+	else
+		mem_charge_send(NULL, len);
+}
+
+static void op_free(struct dpoll_op *op)
+{
+	if (op->sga.sga_numsegs != 0) {
+		op_uncharge(op);
+		const int ret = demi_sgafree(&op->sga);
+		if (ret)
+			demi_log("%s: %s\n", __func__, strerror(ret));
+	}
+	if (op->soc)
+		list_remove(&op->soc_entry);
+	free(op);
+}
+
+static void op_enqueue(epoll_t *ep, struct dpoll_op *op)
+{
+	list_elem_t *head = &ep->ops_inflight;
+	if (op->completed)
+		head = &ep->ops_completed;
+	else if (op->deferred)
+		head = &ep->ops_deferred;
+	list_append(head, &op->ep_entry);
+	++ep->ops_len;
+}
+
+static inline bool socket_has_leftover(const socket_t *soc)
+{
+	return soc->recv.elem.sga_numsegs != 0 && !soc->recv.base.pending;
+}
+
+struct dpoll_op *op_post_pop(epoll_t *ep, socket_t *soc, int qd, void *data)
+{
+	if (socket_is_accepting(soc)) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if (soc->pop_posted) {
+		errno = EALREADY;
+		return NULL;
+	}
+
+	struct dpoll_op *op = op_new(ep, soc, qd, DPOLL_OPC_POP, data);
+	if (!op)
+		return NULL;
+
+	struct dpoll_op *unread = NULL;
+	if (!list_is_empty(&soc->unread))
+		unread = container_of(soc->unread.next, struct dpoll_op,
+		                      soc_entry);
+
+	if (unread && unread->completed) {
+		// kept by the socket, the charge moves over with the sga
+		op->sga = unread->sga;
+		op->sga_off = unread->sga_off;
+		op->res = unread->sga.sga_numsegs != 0 ?
+		          sga_total_len(&op->sga) - op->sga_off : unread->res;
+		op->completed = true;
+		unread->sga.sga_numsegs = 0;
+		op_free(unread);
+	} else if (soc->idle.expired && !socket_has_leftover(soc)) {
+		op->res = -ETIMEDOUT;
+		op->completed = true;
+	} else if (unread) {
+		// a pop taken over from an expired op, see `op_queue_pop`
+		op->tok = unread->tok;
+		op->issued = unread->issued;
+		list_remove(&unread->ep_entry);
+		op_free(unread);
+	} else if (socket_has_leftover(soc)) {
+		// data left over from an earlier pop, hand it out right away
+		op->sga = soc->recv.elem;
+		op->sga_off = soc->recv_off;
+		op->res = sga_total_len(&op->sga) - op->sga_off;
+		op->completed = true;
+		memset(&soc->recv, 0, sizeof(soc->recv));
+		soc->recv_off = 0;
+	} else if (soc->recv.base.pending) {
+		// a pop was already issued by `maybe_read`, take it over
+		op->tok = soc->recv.base.tok;
+		op->issued = soc->recv.base.issued;
+		soc->recv.base.pending = false;
+	} else if (!mem_can_pop(soc)) {
+		demi_log("deferring pop on %u, over budget\n", soc->qd);
+		op->deferred = true;
+	} else {
+		const int ret = demi_pop(&op->tok, soc->qd);
+		if (ret != 0) {
+			op_free(op);
+			errno = ret;
+			return NULL;
+		}
+		op->issued = latency_start();
+	}
+
+	soc->pop_posted = true;
+	op_enqueue(ep, op);
+	return op;
+}
+
+struct dpoll_op *op_post_push(epoll_t *ep, socket_t *soc, int qd,
+                              const struct iovec *iov, int iovcnt, void *data)
+{
+	size_t total_size = 0;
+	for (int i = 0; i < iovcnt; ++i)
+		total_size += iov[i].iov_len;
+
+	struct dpoll_op *op = op_new(ep, soc, qd, DPOLL_OPC_PUSH, data);
+	if (!op)
+		return NULL;
+
+	if (total_size == 0) {
+		op->completed = true;
+		op_enqueue(ep, op);
+		return op;
+	}
+
+	op->sga = demi_sgaalloc(total_size);
+	if (op->sga.sga_numsegs == 0) {
+		op_free(op);
+		errno = ENOMEM;
+		return NULL;
+	}
+	copy_iovs_into_sga(iov, iovcnt, &op->sga);
+	op->res = total_size;
+	idle_touch(soc);
+	// the caller already buffers everything it wants to write, so pushes are
+	// only accounted for and never held back
+	mem_charge_send(soc, total_size);
+
+	const int ret = demi_push(&op->tok, soc->qd, &op->sga);
+	if (ret != 0) {
+		op_free(op);
+		errno = ret;
+		return NULL;
+	}
+	op->issued = latency_start();
+
+	op_enqueue(ep, op);
+	return op;
+}
+
+bool ep_complete_op(epoll_t *ep, const demi_qresult_t *res)
+{
+	list_elem_t *e;
+	for (e = ep->ops_inflight.next; e != &ep->ops_inflight; e = e->next) {
+		struct dpoll_op *op = op_from_ep_entry(e);
+		if (op->tok != res->qr_qt)
+			continue;
+
+		list_remove(e);
+		op->completed = true;
+		if (op->soc)
+			idle_touch(op->soc);
+		switch (res->qr_opcode) {
+		case DEMI_OPC_POP:
+			latency_record(DPOLL_LAT_POP, NULL, op->issued);
+			op->sga = res->qr_value.sga;
+			op->res = sga_total_len(&op->sga);
+			mem_charge_recv(op->soc, op->res);
+			break;
+		case DEMI_OPC_PUSH:
+			// `op->res` was set when posting
+			latency_record(DPOLL_LAT_PUSH, NULL, op->issued);
+			break;
+		case DEMI_OPC_FAILED:
+			demi_log("op on %u failed: %s\n", res->qr_qd,
+			         strerror(res->qr_ret));
+			op->res = -res->qr_ret;
+			break;
+		default:
+			GIVE_UP("invalid demi opcode: %d\n", res->qr_opcode);
+		}
+
+		if (!op->soc) {
+			if (!op->unread)
+				--ep->ops_len;
+			op_free(op);
+			return true;
+		}
+		if (op->unread) {
+			// kept by the socket for its next posted pop
+			LIST_HEAD_INIT(e);
+			return true;
+		}
+		list_append(&ep->ops_completed, e);
+		return true;
+	}
+	return false;
+}
+
+void ep_issue_deferred_ops(epoll_t *ep)
+{
+	while (!list_is_empty(&ep->ops_deferred)) {
+		list_elem_t *e = ep->ops_deferred.next;
+		struct dpoll_op *op = op_from_ep_entry(e);
+		if (!mem_can_pop(op->soc))
+			return;
+
+		list_remove(e);
+		op->deferred = false;
+		const int ret = demi_pop(&op->tok, op->soc->qd);
+		if (ret != 0) {
+			demi_log("deferred pop on %u failed: %s\n", op->soc->qd,
+			         strerror(ret));
+			op->res = -ret;
+			op->completed = true;
+			list_append(&ep->ops_completed, e);
+			continue;
+		}
+		op->issued = latency_start();
+		list_append(&ep->ops_inflight, e);
+	}
+}
+
+size_t ep_collect_op_tokens(epoll_t *ep, demi_qtoken_t **toks, size_t len)
+{
+	size_t count = 0;
+	list_elem_t *e;
+	for (e = ep->ops_inflight.next; e != &ep->ops_inflight; e = e->next)
+		++count;
+	if (count == 0)
+		return len;
+
+	demi_qtoken_t *t = realloc(*toks, (len + count) * sizeof(t[0]));
+	if (!t)
+		GIVE_UP("%s: out of memory\n", __func__);
+	for (e = ep->ops_inflight.next; e != &ep->ops_inflight; e = e->next)
+		t[len++] = op_from_ep_entry(e)->tok;
+	*toks = t;
+	return len;
+}
+
+int ep_reap_ops(epoll_t *ep, struct dpoll_completion *comps, int max)
+{
+	int n = 0;
+	while (n < max && !list_is_empty(&ep->ops_completed)) {
+		list_elem_t *e = ep->ops_completed.next;
+		struct dpoll_op *op = op_from_ep_entry(e);
+		list_remove(e);
+		LIST_HEAD_INIT(e);
+		--ep->ops_len;
+
+		if (!op->soc) {
+			op_free(op);
+			continue;
+		}
+		comps[n++] = (struct dpoll_completion){
+			.opcode = op->opcode,
+			.qd = op->qd,
+			.res = op->res,
+			.data = op->data,
+			.op = op,
+		};
+	}
+	return n;
+}
+
+static void free_op_list(list_elem_t *head)
+{
+	while (!list_is_empty(head)) {
+		list_elem_t *e = head->next;
+		list_remove(e);
+		op_free(op_from_ep_entry(e));
+	}
+}
+
+/// an inflight pop of an open socket goes back to the socket, like one issued
+/// by `maybe_read`, so that the data it brings is not lost and its token is
+/// collected when the socket is closed at the latest
+static bool op_return_pop(struct dpoll_op *op)
+{
+	socket_t *soc = op->soc;
+	if (op->opcode != DPOLL_OPC_POP || !soc || !soc->open ||
+	    soc->recv.elem.sga_numsegs != 0 || soc->recv.base.pending)
+		return false;
+	soc->recv.base.tok = op->tok;
+	soc->recv.base.issued = op->issued;
+	soc->recv.base.pending = true;
+	return true;
+}
+
+/// `op_return_pop` for a socket whose `recv` is taken: the token moves to an op
+/// of its own in front of `soc->unread`, which is waited for with the posted
+/// ops. its data came before whatever `recv` holds
+static bool op_queue_pop(struct dpoll_op *op)
+{
+	socket_t *soc = op->soc;
+	struct dpoll_op *taken = op_new(op->ep, soc, op->qd, DPOLL_OPC_POP,
+	                                NULL);
+	if (!taken)
+		return false;
+	taken->tok = op->tok;
+	taken->issued = op->issued;
+	taken->unread = true;
+	list_remove(&taken->soc_entry);
+	list_add(&soc->unread, &taken->soc_entry);
+	list_append(&op->ep->ops_inflight, &taken->ep_entry);
+	return true;
+}
+
+/// demikernel owns the sga of a push until it completes, so the op can only
+/// be freed after that. pops of closed sockets fail right away, other pops
+/// may never complete and are only checked for. an op which is still running
+/// after `DRAIN_TIMEOUT` is abandoned, and the sga of a push is leaked rather
+/// than freed under demikernel
+static void op_drain(struct dpoll_op *op)
+{
+	static const struct timespec zero = { 0 };
+	static const struct timespec DRAIN_TIMEOUT = {
+		.tv_nsec = 100 * 1000 * 1000,
+	};
+	const bool wait = op->opcode == DPOLL_OPC_PUSH || !op->soc;
+	demi_qresult_t res;
+
+	if (op_return_pop(op)) {
+		if (!op->unread)
+			op->soc->pop_posted = false;
+		return;
+	}
+
+	const int ret = demi_wait(&res, op->tok, wait ? &DRAIN_TIMEOUT : &zero);
+	if (ret != 0) {
+		demi_log("%s: abandoning token of %d: %s\n", __func__, op->qd,
+		         strerror(ret));
+		if (op->sga.sga_numsegs != 0) {
+			demi_log("%s: leaking %zu bytes pushed on %d\n", __func__,
+			         sga_total_len(&op->sga), op->qd);
+			op_uncharge(op);
+			op->sga.sga_numsegs = 0;
+		}
+		return;
+	}
+	trace_result(&res);
+	if (res.qr_opcode == DEMI_OPC_POP) {
+		const int err = demi_sgafree(&res.qr_value.sga);
+		if (err)
+			demi_log("%s: %s\n", __func__, strerror(err));
+	}
+}
+
+void ep_free_ops(epoll_t *ep)
+{
+	list_elem_t *e;
+	for (e = ep->ops_inflight.next; e != &ep->ops_inflight; e = e->next)
+		op_drain(op_from_ep_entry(e));
+	free_op_list(&ep->ops_deferred);
+	free_op_list(&ep->ops_inflight);
+	free_op_list(&ep->ops_completed);
+	ep->ops_len = 0;
+}
+
+size_t op_read(struct dpoll_op *op, void *buf, size_t len)
+{
+	assert(op->opcode == DPOLL_OPC_POP);
+	if (op->res <= 0)
+		return 0;
+	const ssize_t off = op->sga_off;
+	copy_sga_into_buf(buf, len, &op->sga, &op->sga_off);
+	return op->sga_off - off;
+}
+
+void op_release(struct dpoll_op *op)
+{
+	socket_t *soc = op->soc;
+	if (soc && op->opcode == DPOLL_OPC_POP) {
+		soc->pop_posted = false;
+		const bool leftover = op->res > 0 &&
+			op->sga_off < (ssize_t)sga_total_len(&op->sga);
+		if (leftover && soc->recv.elem.sga_numsegs == 0 &&
+		    !soc->recv.base.pending && list_is_empty(&soc->unread)) {
+			soc->recv.elem = op->sga;
+			soc->recv_off = op->sga_off;
+			op->sga.sga_numsegs = 0;
+		} else if (leftover) {
+			// nothing else was handed out since this data, so it
+			// goes in front of whatever the socket holds
+			op->unread = true;
+			list_remove(&op->soc_entry);
+			list_add(&soc->unread, &op->soc_entry);
+			return;
+		}
+	}
+	op_free(op);
+}
+
+void socket_expire_ops(socket_t *soc)
+{
+	list_elem_t *e;
+	for (e = soc->ops.next; e != &soc->ops; e = e->next) {
+		struct dpoll_op *op = container_of(e, struct dpoll_op, soc_entry);
+		if (op->opcode != DPOLL_OPC_POP || op->completed)
+			continue;
+		// the pop keeps running, the socket takes over its token
+		if (!op->deferred && !op_return_pop(op) && !op_queue_pop(op)) {
+			demi_log("%s: out of memory, the pop on %u stays\n",
+			         __func__, soc->qd);
+			continue;
+		}
+		list_remove(&op->ep_entry);
+		op->deferred = false;
+		op->completed = true;
+		op->res = -ETIMEDOUT;
+		list_append(&op->ep->ops_completed, &op->ep_entry);
+	}
+}
+
+void socket_orphan_ops(socket_t *soc)
+{
+	while (!list_is_empty(&soc->unread)) {
+		struct dpoll_op *op = container_of(soc->unread.next,
+		                                   struct dpoll_op, soc_entry);
+		if (op->completed) {
+			op_free(op);
+			continue;
+		}
+		// a running pop is left to the instance, like the posted ones
+		list_remove(&op->soc_entry);
+		op->soc = NULL;
+	}
+	while (!list_is_empty(&soc->ops)) {
+		list_elem_t *e = soc->ops.next;
+		struct dpoll_op *op = container_of(e, struct dpoll_op, soc_entry);
+		list_remove(e);
+		// the charge outlives the socket, so it is moved to the process
+		const bool charged = op->sga.sga_numsegs != 0;
+		if (charged)
+			op_uncharge(op);
+		op->soc = NULL;
+		if (charged)
+			op_charge_total(op);
+		// never issued or completed but not reaped yet, nobody is going
+		// to look at it
+		if ((op->deferred || op->completed) &&
+		    !list_is_empty(&op->ep_entry)) {
+			list_remove(&op->ep_entry);
+			--op->ep->ops_len;
+			op_free(op);
+		}
+	}
+	soc->pop_posted = false;
+}
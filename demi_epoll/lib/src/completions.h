@@ -0,0 +1,73 @@
+#pragma once
+
+#include <demi/types.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "completion.h"
+#include "epoll_wrapper.h"
+#include "internals/list.h"
+#include "socket_wrapper.h"
+
+struct dpoll_op {
+	/// entry in `ep->ops_deferred`, `ep->ops_inflight` or `ep->ops_completed`
+	list_elem_t ep_entry;
+	/// entry in `soc->ops`, or `soc->unread` once released, not linked once
+	/// the socket was closed
+	list_elem_t soc_entry;
+
+	enum dpoll_opcode opcode;
+	epoll_t *ep;
+	demi_qtoken_t tok;
+	/// see histogram.h
+	uint64_t issued;
+	bool completed;
+	/// pop which was not issued yet because of the recv budget
+	bool deferred;
+	/// on `soc->unread`, holding data or a pop for the next posted pop. not
+	/// counted in `ep->ops_len` and never reaped
+	bool unread;
+	/// NULL if the socket was closed before the op was released
+	socket_t *soc;
+	int qd;
+	void *data;
+
+	demi_sgarray_t sga;
+	ssize_t sga_off;
+	ssize_t res;
+};
+
+/// posts a pop on `soc`, or completes it right away if the socket still holds
+/// data from an earlier pop
+struct dpoll_op *op_post_pop(epoll_t *ep, socket_t *soc, int qd, void *data);
+struct dpoll_op *op_post_push(epoll_t *ep, socket_t *soc, int qd,
+                              const struct iovec *iov, int iovcnt, void *data);
+
+/// issues the pops deferred by the recv budget, as far as it allows
+void ep_issue_deferred_ops(epoll_t *ep);
+
+/// returns false if `res` does not belong to any op posted on `ep`
+bool ep_complete_op(epoll_t *ep, const demi_qresult_t *res);
+
+/// appends the tokens of all inflight ops to `*toks`
+///
+/// returns the new length of `*toks`
+size_t ep_collect_op_tokens(epoll_t *ep, demi_qtoken_t **toks, size_t len);
+
+int ep_reap_ops(epoll_t *ep, struct dpoll_completion *comps, int max);
+
+/// waits for the inflight pushes, whose sgas demikernel still uses, and hands
+/// inflight pops back to their sockets before freeing all ops
+void ep_free_ops(epoll_t *ep);
+
+size_t op_read(struct dpoll_op *op, void *buf, size_t len);
+void op_release(struct dpoll_op *op);
+
+/// fails the pops posted on an idle socket with ETIMEDOUT, the socket takes
+/// over the tokens of those already issued
+void socket_expire_ops(socket_t *soc);
+
+/// detaches all ops from a socket which is about to be closed, their
+/// completions are dropped
+void socket_orphan_ops(socket_t *soc);
@@ -0,0 +1,157 @@
+#include "doorbell.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "utils.h"
+
+struct dpoll_doorbell *doorbell_new(int epollfd)
+{
+	struct dpoll_doorbell *db = calloc(1, sizeof(*db));
+	if (!db) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	db->efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (db->efd < 0)
+		goto err_free;
+
+	struct epoll_event ev = {
+		.events = EPOLLIN,
+		.data.u64 = DOORBELL_KEY,
+	};
+	if (epoll_ctl(epollfd, EPOLL_CTL_ADD, db->efd, &ev))
+		goto err_close;
+
+	atomic_init(&db->refs, 1);
+	atomic_init(&db->rung, false);
+	atomic_init(&db->sleeping, false);
+	return db;
+err_close:
+	close(db->efd);
+err_free:
+	free(db);
+	return NULL;
+}
+
+void doorbell_get(struct dpoll_doorbell *db)
+{
+	atomic_fetch_add_explicit(&db->refs, 1, memory_order_relaxed);
+}
+
+void doorbell_put(struct dpoll_doorbell *db)
+{
+	if (!db || atomic_fetch_sub(&db->refs, 1) != 1)
+		return;
+	close(db->efd);
+	free(db);
+}
+
+int doorbell_ctl(struct dpoll_doorbell *db, int op,
+                 const struct epoll_event *ev)
+{
+	switch (op) {
+	case EPOLL_CTL_ADD:
+		if (db->added) {
+			errno = EEXIST;
+			return -1;
+		}
+		db->added = true;
+		db->data = ev->data;
+		return 0;
+	case EPOLL_CTL_MOD:
+		if (!db->added) {
+			errno = ENOENT;
+			return -1;
+		}
+		db->data = ev->data;
+		return 0;
+	case EPOLL_CTL_DEL:
+		if (!db->added) {
+			errno = ENOENT;
+			return -1;
+		}
+		db->added = false;
+		return 0;
+	default:
+		errno = EINVAL;
+		return -1;
+	}
+}
+
+bool doorbell_sleep(struct dpoll_doorbell *db)
+{
+	if (!db || !db->added)
+		return true;
+	// pairs with the exchange in `doorbell_ring`, either the ringer
+	// sees `sleeping` or we see `rung`
+	atomic_store(&db->sleeping, true);
+	if (atomic_load(&db->rung)) {
+		atomic_store(&db->sleeping, false);
+		return false;
+	}
+	return true;
+}
+
+void doorbell_wake(struct dpoll_doorbell *db)
+{
+	if (db)
+		atomic_store(&db->sleeping, false);
+}
+
+int doorbell_filter(struct dpoll_doorbell *db, struct epoll_event *evs, int n)
+{
+	if (!db)
+		return n;
+	int kept = 0;
+	bool kicked = false;
+	for (int i = 0; i < n; ++i) {
+		if (evs[i].data.u64 == DOORBELL_KEY) {
+			kicked = true;
+			continue;
+		}
+		evs[kept++] = evs[i];
+	}
+	if (kicked) {
+		uint64_t val;
+		if (read(db->efd, &val, sizeof(val)) < 0 && errno != EAGAIN)
+			demi_log("%s: %s\n", __func__, strerror(errno));
+	}
+	return kept;
+}
+
+int doorbell_take(struct dpoll_doorbell *db, struct epoll_event *ev)
+{
+	if (!doorbell_rang(db))
+		return 0;
+	if (!atomic_exchange(&db->rung, false))
+		return 0;
+	*ev = (struct epoll_event){
+		.events = EPOLLIN,
+		.data = db->data,
+	};
+	return 1;
+}
+
+void doorbell_ring(struct dpoll_doorbell *db)
+{
+	// already pending, the instance is going to see it anyway
+	if (atomic_exchange(&db->rung, true))
+		return;
+	if (!atomic_load(&db->sleeping))
+		return;
+
+	const uint64_t val = 1;
+	ssize_t ret;
+	do
+		ret = write(db->efd, &val, sizeof(val));
+	while (ret < 0 && errno == EINTR);
+	// EAGAIN means the counter is full, and the instance is awake anyway
+	if (ret < 0 && errno != EAGAIN)
+		GIVE_UP("%s: %s\n", __func__, strerror(errno));
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <sys/epoll.h>
+
+#include "dpoll.h"
+
+/*
+ * user space wakeup channel of a dpoll instance
+ *
+ * ringing only sets `rung`, the wait loop checks it between polls of the
+ * demikernel runtime. the eventfd is only written when the instance sleeps in
+ * the kernel leg of the wait, it is registered with the kernel epoll under
+ * `DOORBELL_KEY` and never reported to the application itself
+ */
+
+#define DOORBELL_KEY UINT64_MAX
+
+struct dpoll_doorbell {
+	/// held by the instance and every `dpoll_doorbell_get` caller, ringing
+	/// threads can outlive the instance
+	atomic_uint refs;
+	atomic_bool rung;
+	/// set while the instance is blocked in `epoll_pwait`
+	atomic_bool sleeping;
+	int efd;
+	/// added to the instance by the application, with `data`
+	bool added;
+	epoll_data_t data;
+};
+
+struct dpoll_doorbell *doorbell_new(int epollfd);
+void doorbell_get(struct dpoll_doorbell *db);
+void doorbell_put(struct dpoll_doorbell *db);
+void doorbell_ring(struct dpoll_doorbell *db);
+
+/// handles `dpoll_epoll_ctl` on the doorbell's fd
+int doorbell_ctl(struct dpoll_doorbell *db, int op,
+                 const struct epoll_event *ev);
+
+/// a doorbell which was not added to the instance is never reported, so it
+/// does not shorten waits either
+static inline bool doorbell_rang(struct dpoll_doorbell *db)
+{
+	return db && db->added &&
+	       atomic_load_explicit(&db->rung, memory_order_relaxed);
+}
+
+/// marks the instance as about to block in the kernel
+///
+/// returns false if the doorbell rang in the meantime, and the wait must not
+/// block
+bool doorbell_sleep(struct dpoll_doorbell *db);
+void doorbell_wake(struct dpoll_doorbell *db);
+
+/// removes the doorbell's own events from the `n` kernel events in `evs`,
+/// draining its eventfd if there were any
+///
+/// returns the new number of events
+int doorbell_filter(struct dpoll_doorbell *db, struct epoll_event *evs, int n);
+
+/// clears the doorbell and writes its event into `ev` if it rang and was added
+/// to the instance
+///
+/// returns the number of events written
+int doorbell_take(struct dpoll_doorbell *db, struct epoll_event *ev);
@@ -1,13 +1,17 @@
 #include "epoll_wrapper.h"
 
 #include <assert.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/param.h>
 #include <time.h>
 #include <unistd.h>
 #include <demi/wait.h>
 
+#include "completions.h"
+#include "doorbell.h"
 #include "impls.h"
 #include "log.h"
 #include "utils.h"
@@ -25,11 +29,19 @@ int ep_init(epoll_t *ep, int flags)
 		.epollfd = epollfd,
 		.items = RB_INITIALIZER(),
 		.qtokens_len = DPOLL_DEFAULT_QTOKEN_LEN,
-		.ready_list = NULL,
 		.qtokens = calloc(
 			DPOLL_DEFAULT_QTOKEN_LEN, sizeof(ep->qtokens[0])),
 	};
-	assert(ep->qtokens);
+	if (!ep->qtokens) {
+		close(epollfd);
+		errno = ENOMEM;
+		return -1;
+	}
+	for (int p = 0; p < DPOLL_PRIO_COUNT; ++p)
+		LIST_HEAD_INIT(&ep->ready_list[p]);
+	LIST_HEAD_INIT(&ep->ops_deferred);
+	LIST_HEAD_INIT(&ep->ops_inflight);
+	LIST_HEAD_INIT(&ep->ops_completed);
 
 	return 0;
 }
@@ -37,7 +49,9 @@ int ep_init(epoll_t *ep, int flags)
 void ep_close(epoll_t *ep)
 {
 	close(ep->epollfd);
+	doorbell_put(ep->doorbell);
 	free(ep->qtokens);
+	ep_free_ops(ep);
 	epoll_item_t *it;
 	RB_FOREACH(it, epoll_head, &ep->items) {
 		free(it->tree.rbe_parent);
@@ -51,10 +65,14 @@ static int epoll_add(epoll_t *ep, socket_t *soc,
 	verify_events(ev->events);
 
 	epoll_item_t *it = calloc(1, sizeof(*it));
-	assert(it);
+	if (!it) {
+		errno = ENOMEM;
+		return -1;
+	}
 	*it = (epoll_item_t){
 		.soc = socket_clone(soc),
 		.subevs = ev->events,
+		.prio = DPOLL_PRIO_DEFAULT,
 		.data = ev->data,
 	};
 	LIST_HEAD_INIT(&it->ready_list_entry);
@@ -71,8 +89,7 @@ static int epoll_del(epoll_t *ep, demi_socket_t qd)
 	socket_close(it->soc);
 	demi_log("removing %u\n", it->soc->qd);
 	RB_REMOVE(epoll_head, &ep->items, it);
-	if (!list_is_empty(&it->ready_list_entry))
-		list_remove(&it->ready_list_entry);
+	ep_unready(it);
 	free(it);
 	return 0;
 }
@@ -105,36 +122,72 @@ int ep_ctl(epoll_t *ep, int op, int fd, socket_t *soc,
 	}
 }
 
-#define next(_item_ptr) container_of((_item_ptr)->ready_list_entry.next, epoll_item_t, ready_list_entry)
+#define item_from_ready_entry(_e) container_of((_e), epoll_item_t, ready_list_entry)
 
-/// brief adds as many events from `ep->ready_list_head` into the events as possible
-///
-/// returns number of events added
-int ep_drain_ready_list(epoll_t *ep, struct epoll_event *evs, int evs_size)
+static enum dpoll_priority item_prio(const epoll_item_t *it)
 {
-	if (evs_size == 0 || ep->ready_list == NULL)
-		return 0;
+	if (it->prio != DPOLL_PRIO_DEFAULT)
+		return it->prio;
+	// new connections are cheap to hand out and keep the backlog short
+	return socket_is_accepting(it->soc) ? DPOLL_PRIO_HIGH :
+	                                      DPOLL_PRIO_NORMAL;
+}
 
-	int events_idx = 0;
-	epoll_item_t *it = container_of(ep->ready_list, epoll_item_t,
-	                                ready_list_entry);
+void ep_ready(epoll_t *ep, epoll_item_t *it)
+{
+	if (!list_is_empty(&it->ready_list_entry))
+		return;
+	list_append(&ep->ready_list[item_prio(it)], &it->ready_list_entry);
+}
+
+void ep_unready(epoll_item_t *it)
+{
+	list_remove(&it->ready_list_entry);
+	LIST_HEAD_INIT(&it->ready_list_entry);
+}
 
-	while (events_idx < evs_size) {
+bool ep_has_ready(const epoll_t *ep)
+{
+	for (int p = 0; p < DPOLL_PRIO_COUNT; ++p) {
+		if (!list_is_empty(&ep->ready_list[p]))
+			return true;
+	}
+	return false;
+}
+
+static int drain_class(list_elem_t *head, struct epoll_event *evs, int max)
+{
+	int events_idx = 0;
+	while (events_idx < max && !list_is_empty(head)) {
+		epoll_item_t *it = item_from_ready_entry(head->next);
+		ep_unready(it);
+		// the events could have been consumed since it was queued
+		const uint32_t avs = available_events(it);
+		if (avs == 0)
+			continue;
 		evs[events_idx++] = (struct epoll_event){
-			.events = available_events(it),
+			.events = avs,
 			.data = it->data,
 		};
-		if (list_is_empty(&it->ready_list_entry)) {
-			ep->ready_list = NULL;
-			break;
-		}
-		list_remove(&it->ready_list_entry);
-		it = next(it);
 	}
-	// overwrite the readylist if it's not empty
-	if (ep->ready_list)
-		ep->ready_list = &it->ready_list_entry;
+	return events_idx;
+}
 
+int ep_drain_ready_list(epoll_t *ep, struct epoll_event *evs, int evs_size)
+{
+	int events_idx = 0;
+	for (int p = 0; p < DPOLL_PRIO_COUNT; ++p) {
+		const unsigned budget = ep->ready_budget[p];
+		int max = evs_size - events_idx;
+		if (budget != 0)
+			max = MIN(max, (int)MIN(budget, INT_MAX));
+		events_idx += drain_class(&ep->ready_list[p],
+		                          evs + events_idx, max);
+	}
+	for (int p = 0; p < DPOLL_PRIO_COUNT; ++p)
+		events_idx += drain_class(&ep->ready_list[p],
+		                          evs + events_idx,
+		                          evs_size - events_idx);
 	return events_idx;
 }
 
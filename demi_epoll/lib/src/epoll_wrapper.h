@@ -1,20 +1,27 @@
 #pragma once
 
 #include "internals/tree.h"
+#include <stdbool.h>
 #include <sys/epoll.h>
+#include "dpoll.h"
 #include "socket_wrapper.h"
 #include "internals/list.h"
 
 #define DPOLL_DEFAULT_QTOKEN_LEN 32
 
+/// maximum number of demikernel results handled by a single wait
+#define DPOLL_MAX_REAP 64
+
 /// this is quite bad, but i cant think of a different way of doing this
 #define DPOLL_DEFAULT_READ_SIZE 1024
 
 typedef struct epoll_item {
 	RB_ENTRY(epoll_item) tree;
 
+	/// entry in one of `ep->ready_list`, self linked if not queued
 	list_elem_t ready_list_entry;
 	uint32_t subevs;
+	enum dpoll_priority prio;
 	socket_t *soc;
 
 	epoll_data_t data;
@@ -25,8 +32,20 @@ typedef struct epoll {
 
 	demi_qtoken_t *qtokens;
 	size_t qtokens_len;
-	list_elem_t *ready_list;
+	/// one fifo per priority class
+	list_elem_t ready_list[DPOLL_PRIO_COUNT];
+	/// events a class can take in one wait before lower ones get a turn
+	unsigned ready_budget[DPOLL_PRIO_COUNT];
 	int epollfd;
+
+	/// ops posted through the completion interface, see completions.h
+	list_elem_t ops_deferred;
+	list_elem_t ops_inflight;
+	list_elem_t ops_completed;
+	size_t ops_len;
+
+	/// NULL until requested with `dpoll_doorbell_get`, see doorbell.h
+	struct dpoll_doorbell *doorbell;
 } epoll_t;
 
 int ep_init(epoll_t *ep, int flags);
@@ -44,7 +63,15 @@ int ep_ctl(epoll_t *ep, int op, int fd, socket_t *soc,
 /// caller must hold mutex
 epoll_item_t *ep_find_item(epoll_t *ep, demi_socket_t qd);
 
-/// tries to add all events from `ev->read_list_head` into the array
+/// queues `it` at the tail of its class, unless it is queued already
+void ep_ready(epoll_t *ep, epoll_item_t *it);
+void ep_unready(epoll_item_t *it);
+bool ep_has_ready(const epoll_t *ep);
+
+/// hands out the ready items in priority order and fifo within a class, every
+/// class first gets up to its budget and the rest of `evs` is then filled in
+/// priority order. items which were not handed out stay at the head of their
+/// class for the next call
 ///
 /// returns the number of events added
 int ep_drain_ready_list(epoll_t *ep, struct epoll_event *evs, int evs_size);
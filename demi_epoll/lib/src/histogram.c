@@ -0,0 +1,121 @@
+#include "histogram.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internals/list.h"
+#include "log.h"
+
+bool latency_enabled = false;
+
+static struct dpoll_latency_hist hists[DPOLL_LAT_OP_COUNT];
+
+struct latency_listener {
+	/// entry in `listeners`
+	list_elem_t entry;
+	struct dpoll_latency_hist hist;
+};
+
+static list_elem_t listeners;
+
+void latency_init(void)
+{
+	LIST_HEAD_INIT(&listeners);
+	const char *env = getenv("DEMI_EPOLL_LATENCY");
+	latency_enabled = env && strcmp(env, "1") == 0;
+}
+
+/// values below `DPOLL_LAT_SUB_BUCKETS` get a bucket each, every following
+/// power of two is split into `DPOLL_LAT_SUB_BUCKETS` buckets
+static size_t bucket_index(uint64_t v)
+{
+	if (v < DPOLL_LAT_SUB_BUCKETS)
+		return v;
+	const int msb = 63 - __builtin_clzll(v);
+	if (msb > DPOLL_LAT_MAX_BITS)
+		return DPOLL_LAT_BUCKETS - 1;
+	const size_t group = msb - DPOLL_LAT_SUB_BITS + 1;
+	const size_t sub = (v >> (msb - DPOLL_LAT_SUB_BITS)) &
+	                   (DPOLL_LAT_SUB_BUCKETS - 1);
+	return group * DPOLL_LAT_SUB_BUCKETS + sub;
+}
+
+uint64_t dpoll_latency_bucket_value(size_t i)
+{
+	if (i < DPOLL_LAT_SUB_BUCKETS)
+		return i;
+	const size_t group = i / DPOLL_LAT_SUB_BUCKETS;
+	const size_t sub = i % DPOLL_LAT_SUB_BUCKETS;
+	const int shift = group - 1;
+	return ((uint64_t)DPOLL_LAT_SUB_BUCKETS + sub) << shift;
+}
+
+static void hist_record(struct dpoll_latency_hist *h, uint64_t v)
+{
+	if (h->count == 0 || v < h->min)
+		h->min = v;
+	if (v > h->max)
+		h->max = v;
+	++h->count;
+	h->sum += v;
+	++h->buckets[bucket_index(v)];
+}
+
+void latency_record_slow(enum dpoll_latency_op op, struct latency_listener *l,
+                         uint64_t issued)
+{
+	const uint64_t now = trace_now();
+	const uint64_t v = now > issued ? now - issued : 0;
+	hist_record(&hists[op], v);
+	if (l)
+		hist_record(&l->hist, v);
+}
+
+struct latency_listener *latency_listener_new(void)
+{
+	if (!latency_enabled)
+		return NULL;
+	struct latency_listener *l = calloc(1, sizeof(*l));
+	if (!l) {
+		demi_log("no memory for a listener histogram\n");
+		return NULL;
+	}
+	list_append(&listeners, &l->entry);
+	return l;
+}
+
+void latency_listener_free(struct latency_listener *l)
+{
+	if (!l)
+		return;
+	list_remove(&l->entry);
+	free(l);
+}
+
+const struct dpoll_latency_hist *
+latency_listener_hist(const struct latency_listener *l)
+{
+	return &l->hist;
+}
+
+bool dpoll_latency_enabled(void)
+{
+	return latency_enabled;
+}
+
+void dpoll_get_latency_histograms(struct dpoll_latency_hist *out)
+{
+	memcpy(out, hists, sizeof(hists));
+}
+
+void dpoll_reset_latency_histograms(void)
+{
+	memset(hists, 0, sizeof(hists));
+	list_elem_t *e;
+	for (e = listeners.next; e != &listeners; e = e->next) {
+		struct latency_listener *l =
+			container_of(e, struct latency_listener, entry);
+		memset(&l->hist, 0, sizeof(l->hist));
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "latency.h"
+#include "tracer.h"
+
+extern bool latency_enabled;
+
+/// reads `DEMI_EPOLL_LATENCY`
+void latency_init(void);
+
+/// issue time of an operation, 0 while recording is disabled
+static inline uint64_t latency_start(void)
+{
+	return latency_enabled ? trace_now() : 0;
+}
+
+/// accept latency of a single listening socket
+struct latency_listener;
+
+/// returns NULL while recording is disabled
+struct latency_listener *latency_listener_new(void);
+void latency_listener_free(struct latency_listener *l);
+const struct dpoll_latency_hist *
+latency_listener_hist(const struct latency_listener *l);
+
+void latency_record_slow(enum dpoll_latency_op op, struct latency_listener *l,
+                         uint64_t issued);
+
+/// records an operation issued at `issued`, and for accepts also into the
+/// histogram of its listener `l`, which may be NULL
+static inline void latency_record(enum dpoll_latency_op op,
+                                  struct latency_listener *l, uint64_t issued)
+{
+	// issued before recording was enabled
+	if (issued != 0)
+		latency_record_slow(op, l, issued);
+}
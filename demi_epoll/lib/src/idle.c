@@ -0,0 +1,108 @@
+#include "idle.h"
+
+#include <sys/param.h>
+
+#include "completions.h"
+#include "log.h"
+
+static list_elem_t wheel[IDLE_WHEEL_SLOTS];
+static bool wheel_init = false;
+/// the next tick to be processed
+static uint64_t wheel_tick = 0;
+static size_t armed = 0;
+
+/// `min_tick` keeps the socket from landing behind the hand, where it would
+/// wait for a full turn
+static void wheel_insert(socket_t *soc, uint64_t min_tick)
+{
+	uint64_t tick = (soc->idle.last + soc->idle.timeout) / IDLE_TICK_MS;
+	tick = MAX(tick, min_tick);
+	list_append(&wheel[tick % IDLE_WHEEL_SLOTS], &soc->idle.entry);
+}
+
+void idle_set(socket_t *soc, uint32_t timeout_ms)
+{
+	if (!wheel_init) {
+		for (size_t i = 0; i < IDLE_WHEEL_SLOTS; ++i)
+			LIST_HEAD_INIT(&wheel[i]);
+		wheel_tick = idle_now() / IDLE_TICK_MS;
+		wheel_init = true;
+	}
+
+	idle_cancel(soc);
+	soc->idle.expired = false;
+	soc->idle.timeout = timeout_ms;
+	if (timeout_ms == 0)
+		return;
+
+	soc->idle.last = idle_now();
+	wheel_insert(soc, wheel_tick);
+	++armed;
+}
+
+void idle_cancel(socket_t *soc)
+{
+	if (list_is_empty(&soc->idle.entry))
+		return;
+	list_remove(&soc->idle.entry);
+	LIST_HEAD_INIT(&soc->idle.entry);
+	--armed;
+}
+
+static void expire_slot(uint64_t tick, uint64_t now)
+{
+	list_elem_t *slot = &wheel[tick % IDLE_WHEEL_SLOTS];
+	list_elem_t pending;
+	LIST_HEAD_INIT(&pending);
+	// move the slot aside first, sockets which are still alive are put
+	// back into the wheel
+	if (!list_is_empty(slot)) {
+		pending.next = slot->next;
+		pending.prev = slot->prev;
+		pending.next->prev = &pending;
+		pending.prev->next = &pending;
+		LIST_HEAD_INIT(slot);
+	}
+
+	while (!list_is_empty(&pending)) {
+		socket_t *soc = container_of(pending.next, socket_t,
+		                             idle.entry);
+		list_remove(&soc->idle.entry);
+		if (soc->idle.last + soc->idle.timeout > now) {
+			wheel_insert(soc, tick + 1);
+			continue;
+		}
+
+		LIST_HEAD_INIT(&soc->idle.entry);
+		--armed;
+		demi_log("%u was idle for %u ms\n", soc->qd, soc->idle.timeout);
+		soc->idle.expired = true;
+		socket_expire_ops(soc);
+	}
+}
+
+void idle_advance(void)
+{
+	if (armed == 0)
+		return;
+
+	const uint64_t now = idle_now();
+	const uint64_t now_tick = now / IDLE_TICK_MS;
+	if (wheel_tick > now_tick)
+		return;
+	// after a long pause every slot has to be looked at once, at most
+	if (now_tick - wheel_tick > IDLE_WHEEL_SLOTS)
+		wheel_tick = now_tick - IDLE_WHEEL_SLOTS;
+	for (; wheel_tick <= now_tick && armed > 0; ++wheel_tick)
+		expire_slot(wheel_tick, now);
+	wheel_tick = MAX(wheel_tick, now_tick + 1);
+}
+
+int idle_clamp_timeout(int timeout)
+{
+	if (armed == 0)
+		return timeout;
+	if (timeout < 0 || timeout > IDLE_TICK_MS)
+		return IDLE_TICK_MS;
+	return timeout;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "socket_wrapper.h"
+
+/*
+ * idle timeouts of dpoll sockets
+ *
+ * armed sockets sit in a coarse timing wheel, activity only updates
+ * `soc->idle.last` and a socket is moved to a later slot when its slot comes up
+ * before it actually expired. expired sockets report EPOLLIN | EPOLLRDHUP and
+ * their reads and pops fail with ETIMEDOUT
+ */
+
+#define IDLE_TICK_MS 100
+#define IDLE_WHEEL_SLOTS 512
+
+static inline uint64_t idle_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static inline void idle_touch(socket_t *soc)
+{
+	if (soc->idle.timeout != 0)
+		soc->idle.last = idle_now();
+}
+
+/// 0 disarms the timeout, re-arming it clears an earlier expiration
+void idle_set(socket_t *soc, uint32_t timeout_ms);
+void idle_cancel(socket_t *soc);
+
+/// expires every socket whose timeout passed since the last call
+void idle_advance(void);
+
+/// shortens `timeout` so the wait returns in time for the next tick, if any
+/// socket is armed
+int idle_clamp_timeout(int timeout);
@@ -1,12 +1,20 @@
 #include "impls.h"
+#include "budget.h"
+#include "completions.h"
+#include "doorbell.h"
+#include "histogram.h"
+#include "idle.h"
 #include "internals/buffer.h"
 #include "log.h"
 #include "socket_wrapper.h"
+#include "tracer.h"
 #include "utils.h"
 #include <demi/libos.h>
 #include <demi/wait.h>
 #include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/param.h>
 #include <unistd.h>
@@ -19,19 +27,29 @@ typedef socket_t *socket_ptr;
 BUFFER_DEF(soc_buf, socket_ptr, soc_buf)
 BUFFER_DEF(epoll_buf, epoll_t, epoll_buf)
 
+static bool completion_mode = false;
+/// every listening socket is bound with SO_REUSEPORT, so that the processes
+/// of a cluster, which inherit the environment, can each listen on the same
+/// port. only listen knows that a socket listens, so bind is deferred until
+/// then
+static bool reuseport_mode = false;
+
 uint32_t available_events(const epoll_item_t *it)
 {
 	const socket_t *soc = it->soc;
 	return check_event(it->subevs, EPOLLIN,
 	                   socket_is_accepting(soc) ? socket_can_accept(soc) :
-	                   socket_can_read(soc)) ||
-	       check_event(it->subevs, EPOLLOUT, socket_can_write(soc));
+	                   socket_can_read(soc)) |
+	       check_event(it->subevs, EPOLLOUT, socket_can_write(soc)) |
+	       // like EPOLLHUP, reported without being asked for
+	       (soc->idle.expired ? EPOLLRDHUP : 0);
 }
 
-/// a small helpful macro for making sure that a call fail due to EWOULDBLOCK
-#define schedule(_func) do {	\
-	int _ret = _func;	\
-	assert(_ret < 0 && errno == EWOULDBLOCK); \
+/// issues an accept or a pop through a call which is expected to fail with
+/// EWOULDBLOCK, any other failure is kept for the next call on the socket
+#define schedule(_soc, _func) do {			\
+	if ((_func) < 0 && errno != EWOULDBLOCK)	\
+		(_soc)->err = errno;			\
 	} while (0)
 
 /// iterates over all items in `ep->items` and adds them to the readylist if at
@@ -41,88 +59,176 @@ static size_t check_and_schedule_evs(epoll_t *ep, demi_qtoken_t **toks_dest)
 	epoll_item_t *it;
 	size_t tok_count = 0;
 	demi_qtoken_t *toks = NULL;
-	list_elem_t *delete_list = NULL;
+	list_elem_t delete_list;
+	LIST_HEAD_INIT(&delete_list);
 	RB_FOREACH(it, epoll_head, &ep->items) {
 		demi_log("looking at %u\n", it->soc->qd);
 		if (!it->soc->open) {
 			demi_log("it's not open\n");
-			assert(list_is_empty(&it->ready_list_entry));
-			list_add_to_head(&delete_list, &it->ready_list_entry);
+			ep_unready(it);
+			list_append(&delete_list, &it->ready_list_entry);
 			// never schedule a closed socket
 			continue;
 		}
+		socket_t *soc = it->soc;
 		const uint32_t avs = available_events(it);
-		if (avs != 0) {
-			list_add_to_head(&ep->ready_list,
-			                 &it->ready_list_entry);
-		}
-		const uint32_t rem = avs ^ it->subevs;
-		if (rem == 0)
+		if (avs != 0)
+			ep_ready(ep, it);
+		const uint32_t rem = it->subevs & ~avs;
+		// a pending push is waited for whatever the item asks for, its
+		// sga and its share of the send budget are given back as soon
+		// as it completes
+		const bool push = soc->send.base.pending;
+		if (rem == 0 && !push)
 			// no more events to process
 			continue;
 
-		const int schedule_count = __builtin_popcount(rem);
+		const int schedule_count = __builtin_popcount(rem & EPOLLIN) +
+		                           push;
 		toks = realloc(
 			toks, (tok_count + schedule_count) * sizeof(toks[0]));
-		assert(toks);
+		// there is no way to wait on a part of the sockets
+		if (!toks)
+			GIVE_UP("%s: out of memory\n", __func__);
 
-		socket_t *soc = it->soc;
 		verify_events(rem);
 		if (rem & EPOLLIN) {
 			if (!soc->recv.base.pending) {
 				if (socket_is_accepting(soc)) {
-					schedule(maybe_accept(soc, NULL));
-				} else {
-					schedule(maybe_read(soc, NULL,
+					schedule(soc, maybe_accept(soc, NULL));
+				} else if (mem_can_pop(soc)) {
+					schedule(soc, maybe_read(soc, NULL,
 						DPOLL_DEFAULT_READ_SIZE));
+				} else {
+					demi_log("not popping on %u, over budget\n",
+					         soc->qd);
 				}
 			}
-			assert(soc->recv.base.pending);
-			toks[tok_count++] = soc->recv.base.tok;
-			demi_log("waiting for EPOLLIN on %u with tok: %lu\n",
-			         soc->qd, soc->recv.base.tok);
+			if (soc->recv.base.pending) {
+				toks[tok_count++] = soc->recv.base.tok;
+				demi_log("waiting for EPOLLIN on %u with tok: %lu\n",
+				         soc->qd, soc->recv.base.tok);
+			}
 		}
-		if (rem & EPOLLOUT) {
-			assert(soc->send.base.pending);
+		// without a pending push a socket waiting for EPOLLOUT waits
+		// for other sockets to give back some of the send budget
+		if (push) {
 			toks[tok_count++] = soc->send.base.tok;
-			demi_log("waiting for EPOLLOUT on %u with tok: %lu\n",
+			demi_log("waiting for the push on %u with tok: %lu\n",
 			         soc->qd, soc->send.base.tok);
 		}
 	}
 
-	if (delete_list) {
-		it = container_of(delete_list, epoll_item_t, ready_list_entry);
-
-		do {
-			epoll_item_t *tmp = it;
-			demi_log("removing %u from epoll tree\n", it->soc->qd);
-			it = container_of(delete_list, epoll_item_t,
-			                  ready_list_entry);
-			RB_REMOVE(epoll_head, &ep->items, tmp);
-			socket_close(tmp->soc);
-			free(tmp);
-		} while (it != container_of(delete_list, epoll_item_t,
-		                            ready_list_entry));
+	while (!list_is_empty(&delete_list)) {
+		it = container_of(delete_list.next, epoll_item_t,
+		                  ready_list_entry);
+		ep_unready(it);
+		demi_log("removing %u from epoll tree\n", it->soc->qd);
+		RB_REMOVE(epoll_head, &ep->items, it);
+		socket_close(it->soc);
+		free(it);
 	}
 
 	*toks_dest = toks;
 	return tok_count;
 }
 
-void dpoll_init(void)
+#define LIBOS_MAX_ARGS 32
+
+static pthread_once_t libos_once = PTHREAD_ONCE_INIT;
+static int libos_err = 0;
+
+/// splits `DEMI_EPOLL_LIBOS_ARGS` on whitespace, the strings are kept alive for
+/// the lifetime of the process since the libos might hold on to them
+static int libos_args_from_env(char **argv, int max)
 {
+	int argc = 0;
+	argv[argc++] = "demi_epoll";
+	const char *env = getenv("DEMI_EPOLL_LIBOS_ARGS");
+	if (!env)
+		return argc;
+
+	char *args = strdup(env);
+	if (!args)
+		return -1;
+	char *save = NULL;
+	for (char *arg = strtok_r(args, " \t", &save); arg;
+	     arg = strtok_r(NULL, " \t", &save)) {
+		if (argc == max - 1) {
+			demi_log("ignoring libos args after %s\n", arg);
+			break;
+		}
+		argv[argc++] = arg;
+	}
+	return argc;
+}
+
+static void libos_init(void)
+{
+	static char *argv[LIBOS_MAX_ARGS] = { 0 };
+	const int argc = libos_args_from_env(argv, LIBOS_MAX_ARGS);
+	if (argc < 0) {
+		libos_err = ENOMEM;
+		return;
+	}
 	struct demi_args args = {
-		.argc = 0,
-		.argv = NULL,
+		.argc = argc,
+		.argv = argv,
 	};
 
-	assert(demi_init(&args) == 0);
+	libos_err = demi_init(&args);
+	if (libos_err)
+		demi_log("demi_init failed: %s\n", strerror(libos_err));
+}
+
+/// the libos is only initialised once the first dpoll socket is created, so
+/// that processes which never open one do not pay for it
+static int ensure_libos(void)
+{
+	const int ret = pthread_once(&libos_once, libos_init);
+	if (ret != 0) {
+		errno = ret;
+		return -1;
+	}
+	if (libos_err) {
+		errno = libos_err;
+		return -1;
+	}
+	return 0;
+}
+
+void dpoll_init(void)
+{
 	demi_log_init();
+	mem_budget_init();
+	trace_init();
+	latency_init();
+
+	const char *env = getenv("DEMI_EPOLL_COMPLETION");
+	completion_mode = env && strcmp(env, "1") == 0;
+	env = getenv("DEMI_EPOLL_REUSEPORT");
+	reuseport_mode = env && strcmp(env, "1") == 0;
+}
+
+/// a process must not believe it shares a port when the libos did not agree,
+/// so unlike the other options this one is passed on
+static int socket_set_reuseport(socket_t *soc, const void *optval,
+                                socklen_t optlen)
+{
+	int ret = demi_setsockopt(soc->qd, SOL_SOCKET, SO_REUSEPORT, optval,
+	                          optlen);
+	DEMI_ERR(ret, "setting SO_REUSEPORT on %u\n", soc->qd);
+	return 0;
 }
 
 int dpoll_socket_impl(void)
 {
+	if (ensure_libos())
+		return -1;
+
 	int fd = soc_buf_next();
+	if (fd < 0)
+		return -1;
 	socket_t *soc = socket_init();
 	if (!soc)
 		goto err_close_soc;
@@ -143,10 +249,18 @@ int dpoll_bind_impl(int qd, const struct sockaddr *addr, socklen_t addrlen)
 		demi_log(
 			"addr cannot be 0.0.0.0, for some reason demikernel does not support this\n");
 	}
+	if (addrlen != sizeof(soc->addr)) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (reuseport_mode) {
+		memcpy(&soc->addr, addr, addrlen);
+		soc->bind_deferred = true;
+		return 0;
+	}
 	int ret = demi_bind(soc->qd, addr, addrlen);
-	assert(addrlen == sizeof(soc->addr));
-	memcpy(&soc->addr, addr, addrlen);
 	DEMI_ERR(ret, "binding\n");
+	memcpy(&soc->addr, addr, addrlen);
 	return 0;
 }
 
@@ -159,9 +273,21 @@ int dpoll_listen_impl(int qd, int backlog)
 {
 	socket_t *soc = *soc_buf_get(qd);
 	assert(soc->open);
-	int ret = demi_listen(soc->qd, backlog);
+	int ret;
+	if (soc->bind_deferred) {
+		const int on = 1;
+		if (socket_set_reuseport(soc, &on, sizeof(on)))
+			return -1;
+		ret = demi_bind(soc->qd, (const struct sockaddr *)&soc->addr,
+		                sizeof(soc->addr));
+		DEMI_ERR(ret, "binding\n");
+		soc->bind_deferred = false;
+	}
+	ret = demi_listen(soc->qd, backlog);
 	DEMI_ERR(ret, "listen\n");
 	soc->recv_off = -1;
+	if (!soc->lat)
+		soc->lat = latency_listener_new();
 	return 0;
 }
 
@@ -176,17 +302,21 @@ int dpoll_accept_impl(int qd, struct sockaddr *addr, socklen_t *addrlen)
 	if (!result_is_ok(ret))
 		return -1;
 	int fd = dpoll_socket_impl();
-	assert(fd >= 0);
+	if (fd < 0) {
+		const int err = errno;
+		demi_close(soc_from_result(ret));
+		errno = err;
+		return -1;
+	}
 
 	socket_t *new_soc = *soc_buf_get(fd);
 	new_soc->qd = soc_from_result(ret);
 	new_soc->addr = ad;
 
 	if (addr) {
-		const size_t size = sizeof(ad);
-		assert(*addrlen >= size);
-		memcpy(addr, &ad, size);
-		*addrlen = size;
+		// truncated like accept(2), `*addrlen` tells the real size
+		memcpy(addr, &ad, MIN((size_t)*addrlen, sizeof(ad)));
+		*addrlen = sizeof(ad);
 	}
 
 	return fd;
@@ -209,17 +339,43 @@ int dpoll_setsockopt_impl(int qd, int level, int optname, const void *optval,
                           socklen_t optlen)
 {
 	demi_log("qd: %d, level: %d, optname: %d\n", qd, level, optname);
+	if (level == SOL_SOCKET && optname == SO_REUSEPORT) {
+		socket_t *soc = *soc_buf_get(qd);
+		assert(soc->open);
+		return socket_set_reuseport(soc, optval, optlen);
+	}
 	return 0;
 }
 
+// ancillary data cannot be carried by a demikernel socket, the rest works
+// like writev and readv. the sockets never block and never raise SIGPIPE, any
+// other flag (MSG_PEEK, MSG_TRUNC, MSG_OOB, ...) would be silently ignored, so
+// it is refused instead
+
+#define SENDMSG_FLAGS (MSG_DONTWAIT | MSG_NOSIGNAL)
+#define RECVMSG_FLAGS (MSG_DONTWAIT | MSG_CMSG_CLOEXEC)
+
 ssize_t dpoll_sendmsg_impl(int qd, const struct msghdr *msg, int flags)
 {
-	UNIMPLEMENTED();
+	if (msg->msg_controllen != 0 || (flags & ~SENDMSG_FLAGS)) {
+		errno = EOPNOTSUPP;
+		return -1;
+	}
+	return dpoll_writev_impl(qd, msg->msg_iov, msg->msg_iovlen);
 }
 
 ssize_t dpoll_recvmsg_impl(int qd, struct msghdr *msg, int flags)
 {
-	UNIMPLEMENTED();
+	if (flags & ~RECVMSG_FLAGS) {
+		errno = EOPNOTSUPP;
+		return -1;
+	}
+	const ssize_t ret = dpoll_readv_impl(qd, msg->msg_iov, msg->msg_iovlen);
+	if (ret >= 0) {
+		msg->msg_controllen = 0;
+		msg->msg_flags = 0;
+	}
+	return ret;
 }
 
 int dpoll_close_impl(int qd)
@@ -235,6 +391,8 @@ int dpoll_close_impl(int qd)
 	qd = get_socket_fd(qd);
 	socket_t *soc = *soc_buf_get(qd);
 	demi_log("closing %u\n", soc->qd);
+	socket_orphan_ops(soc);
+	idle_cancel(soc);
 	soc->open = false;
 	socket_close(soc);
 	// soc_buf_free(qd);
@@ -244,6 +402,8 @@ int dpoll_close_impl(int qd)
 int dpoll_create_impl(int flags)
 {
 	int fd = epoll_buf_next();
+	if (fd < 0)
+		return -1;
 	int ret = ep_init(&epoll_buf.items[fd].it, flags);
 	if (ret < 0)
 		goto err;
@@ -257,6 +417,11 @@ int dpoll_ctl_impl(int dpollfd, int op, int fd, struct epoll_event *event)
 {
 	epoll_t *ep = epoll_buf_get(dpollfd);
 	int ret;
+	if (ep->doorbell && fd == ep->doorbell->efd) {
+		// already in the kernel set under its own key
+		ret = doorbell_ctl(ep->doorbell, op, event);
+		goto defer;
+	}
 	if (!qd_is_dpoll(fd)) {
 		// fd must be processed by linux' epoll
 		ret = epoll_ctl(ep->epollfd, op, fd, event);
@@ -271,15 +436,73 @@ defer:
 	return ret;
 }
 
-int dpoll_pwait_impl(int dpollfd, struct epoll_event *events, int maxevents,
-                     int timeout, const sigset_t *sigmask)
+static const struct timespec ZERO = { 0 };
+
+/// routes a demikernel result either to a posted op, or to the readiness
+/// state of the socket it belongs to
+static void handle_result(epoll_t *ep, const demi_qresult_t *res)
+{
+	trace_result(res);
+	if (ep_complete_op(ep, res))
+		return;
+
+	demi_log("looking for %u because %lu\n", res->qr_qd, res->qr_qt);
+	epoll_item_t *it = ep_find_item(ep, res->qr_qd);
+	if (!it) {
+		demi_log("did not find it, here's the tree in some order\n");
+		RB_FOREACH(it, epoll_head, &ep->items) {
+			demi_log("in the tree: %u\n", it->soc->qd);
+		}
+		return;
+	}
+
+	demi_log("found %u\n", it->soc->qd);
+	assert(res->qr_qd == it->soc->qd);
+	socket_handle_event(it->soc, res);
+	ep_ready(ep, it);
+}
+
+/// `demi_wait_any`, but while the doorbell is added to the instance the
+/// demikernel runtime is polled from here, the way a demikernel wait polls it
+/// too, so that a ring is noticed right away
+///
+/// returns ETIMEDOUT if the doorbell rang
+static int wait_any(epoll_t *ep, demi_qresult_t *res, int *offset,
+                    demi_qtoken_t *tokens, size_t tokens_len,
+                    const struct timespec *timeout)
+{
+	struct dpoll_doorbell *db = ep->doorbell;
+	if (!db || !db->added ||
+	    (timeout && timeout->tv_sec == 0 && timeout->tv_nsec == 0))
+		return demi_wait_any(res, offset, tokens, tokens_len, timeout);
+
+	uint64_t deadline = UINT64_MAX;
+	if (timeout)
+		deadline = trace_now() + timeout->tv_sec * 1000000000ull +
+		           timeout->tv_nsec;
+	for (;;) {
+		if (doorbell_rang(db))
+			return ETIMEDOUT;
+		const int ret =
+			demi_wait_any(res, offset, tokens, tokens_len, &ZERO);
+		if (ret != ETIMEDOUT || trace_now() >= deadline)
+			return ret;
+	}
+}
+
+/// `*stale` is set if the wait woke up for something with nothing to report:
+/// a push the application does not wait for, or the doorbell's eventfd while
+/// it had not rung. see `dpoll_pwait_impl`
+static int pwait_once(epoll_t *ep, struct epoll_event *events, int maxevents,
+                      int timeout, const sigset_t *sigmask, bool *stale)
 {
-	epoll_t *ep = epoll_buf_get(dpollfd);
 	int epoll_timeout = 0;
 	demi_log("%s: sigmask is not used atm\n", __func__);
 	// TODO: keep track of the maximum amount of qtokens required, and store the qtoken buffer to limit the allocations
 	demi_qtoken_t *tokens = NULL;
-	const size_t tokens_len = check_and_schedule_evs(ep, &tokens);
+	size_t tokens_len = check_and_schedule_evs(ep, &tokens);
+	ep_issue_deferred_ops(ep);
+	tokens_len = ep_collect_op_tokens(ep, &tokens, tokens_len);
 	demi_log("waiting on %lu tokens\n", tokens_len);
 	if (tokens_len == 1)
 		demi_log("waiting on token %lu\n", tokens[0]);
@@ -287,58 +510,69 @@ int dpoll_pwait_impl(int dpollfd, struct epoll_event *events, int maxevents,
 		epoll_timeout = timeout;
 		goto add_epoll_events;
 	}
-	if (ep->ready_list) {
+	if (ep_has_ready(ep) || !list_is_empty(&ep->ops_completed) ||
+	    doorbell_rang(ep->doorbell)) {
 		demi_log("ready list is not empty, so not going to wait\n");
 		timeout = 0; // we already have some events ready, just poll
 	}
 
 	const struct timespec ts = ms_timeout_to_timespec(timeout);
-	demi_qresult_t res;
-	int offset;
-	int ret = demi_wait_any(&res, &offset, tokens, tokens_len,
-	                        (timeout >= 0) ? &ts : NULL);
-	if (ret == ETIMEDOUT)
-		goto add_epoll_events;
-
-	if (ret != 0) {
-		demi_log("%s: %s\nsearched for: \n", __func__, strerror(ret));
-		for (size_t i = 0; i < tokens_len; ++i) {
-			demi_log("%lu\n", tokens[i]);
-		}
-	}
-	assert(ret == 0);
-	demi_log("looking for %u because %lu\n", res.qr_qd, res.qr_qt);
-	epoll_item_t *it = ep_find_item(ep, res.qr_qd);
-	if (!it) {
-		demi_log("did not find it, here's the tree in some order\n");
-		RB_FOREACH(it, epoll_head, &ep->items) {
-			demi_log("in the tree: %u\n", it->soc->qd);
+	const struct timespec *wait_ts = (timeout >= 0) ? &ts : NULL;
+	int ret;
+	// keep collecting results which are already done, so a single call can
+	// hand out more than one completion
+	for (int reaped = 0; reaped < DPOLL_MAX_REAP && tokens_len > 0;
+	     ++reaped) {
+		demi_qresult_t res;
+		int offset;
+		ret = wait_any(ep, &res, &offset, tokens, tokens_len, wait_ts);
+		if (ret == ETIMEDOUT)
+			break;
+
+		if (ret != 0) {
+			demi_log("%s: %s\nsearched for: \n", __func__,
+			         strerror(ret));
+			for (size_t i = 0; i < tokens_len; ++i) {
+				demi_log("%lu\n", tokens[i]);
+			}
+			errno = ret;
+			ret = -1;
+			goto cleanup;
 		}
-		goto add_epoll_events;
+		tokens[offset] = tokens[--tokens_len];
+		wait_ts = &ZERO;
+		handle_result(ep, &res);
+		*stale = true;
 	}
 
-	demi_log("found %u\n", it->soc->qd);
-	assert(res.qr_qd == it->soc->qd);
-	socket_handle_event(it->soc, &res);
-	if (!list_contains_elem(ep->ready_list, &it->ready_list_entry))
-		list_add_to_head(&ep->ready_list,
-		                 &it->ready_list_entry);
-
 add_epoll_events:
+	if (!list_is_empty(&ep->ops_completed))
+		epoll_timeout = 0;
 	int events_added = ep_drain_ready_list(ep, events, maxevents);
 	assert(events_added <= maxevents);
 
 	if (maxevents - events_added > 0) {
+		if (epoll_timeout != 0 && !doorbell_sleep(ep->doorbell))
+			epoll_timeout = 0;
 		ret = epoll_pwait(ep->epollfd, events + events_added,
 		                  maxevents - events_added, epoll_timeout,
 		                  sigmask);
+		doorbell_wake(ep->doorbell);
 		if (ret < 0) {
-			perror("epoll_wait");
-			assert(errno == ETIMEDOUT);
+			demi_log("epoll_pwait: %s\n", strerror(errno));
 			goto cleanup;
 		}
-		events_added += ret;
+		const int kept = doorbell_filter(ep->doorbell,
+		                                 events + events_added, ret);
+		*stale |= ret > 0 && kept == 0;
+		events_added += kept;
 	}
+	// a full batch leaves the doorbell rung for the next wait
+	if (events_added < maxevents)
+		events_added += doorbell_take(ep->doorbell,
+		                              events + events_added);
+	if (events_added != 0 || !list_is_empty(&ep->ops_completed))
+		*stale = false;
 	ret = events_added;
 
 cleanup:
@@ -346,10 +580,132 @@ cleanup:
 	return ret;
 }
 
+int dpoll_pwait_impl(int dpollfd, struct epoll_event *events, int maxevents,
+                     int timeout, const sigset_t *sigmask)
+{
+	epoll_t *ep = epoll_buf_get(dpollfd);
+	const uint64_t start = idle_now();
+	for (;;) {
+		idle_advance();
+		int left = timeout;
+		if (timeout > 0)
+			left = MAX(0, timeout - (int)(idle_now() - start));
+		const int wait = idle_clamp_timeout(left);
+		bool stale = false;
+		const int ret =
+			pwait_once(ep, events, maxevents, wait, sigmask, &stale);
+		// a wait shortened for the timing wheel which came back empty
+		// only means the wheel has to be looked at again. so does one
+		// woken early by a result without an event, or by the eventfd
+		// write of a ring whose `rung` an earlier wait already took
+		if (ret != 0 || (wait == left && !stale))
+			return ret;
+	}
+}
+
+int dpoll_set_idle_timeout_impl(int qd, unsigned timeout_ms)
+{
+	socket_t *soc = *soc_buf_get(qd);
+	idle_set(soc, timeout_ms);
+	return 0;
+}
+
 void debug_print(void)
 {
 }
 
+int dpoll_set_priority_impl(int dpollfd, int socfd, enum dpoll_priority prio)
+{
+	epoll_t *ep = epoll_buf_get(dpollfd);
+	const socket_t *soc = *soc_buf_get(socfd);
+	epoll_item_t *it = ep_find_item(ep, soc->qd);
+	if (!it) {
+		// not added to this instance
+		errno = ENOENT;
+		return -1;
+	}
+	it->prio = prio;
+	// requeue, so it is handed out with its new class
+	if (!list_is_empty(&it->ready_list_entry)) {
+		ep_unready(it);
+		ep_ready(ep, it);
+	}
+	return 0;
+}
+
+int dpoll_set_ready_budget_impl(int dpollfd, enum dpoll_priority prio,
+                                unsigned budget)
+{
+	epoll_buf_get(dpollfd)->ready_budget[prio] = budget;
+	return 0;
+}
+
+int dpoll_get_listener_latency_histogram_impl(int qd,
+                                              struct dpoll_latency_hist *hist)
+{
+	const socket_t *soc = *soc_buf_get(qd);
+	if (!socket_is_accepting(soc)) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (!soc->lat) {
+		errno = ENOENT;
+		return -1;
+	}
+	*hist = *latency_listener_hist(soc->lat);
+	return 0;
+}
+
+int dpoll_get_socket_mem_usage_impl(int qd, struct dpoll_mem_usage *usage)
+{
+	const socket_t *soc = *soc_buf_get(qd);
+	*usage = soc->mem;
+	return 0;
+}
+
+bool dpoll_completion_enabled_impl(int qd)
+{
+	return completion_mode && qd_is_dpoll(qd) && !qd_is_epoll(qd);
+}
+
+int dpoll_post_pop_impl(int dpollfd, int qd, int socfd, void *data)
+{
+	epoll_t *ep = epoll_buf_get(dpollfd);
+	socket_t *soc = *soc_buf_get(socfd);
+	assert(soc->open);
+	return op_post_pop(ep, soc, qd, data) ? 0 : -1;
+}
+
+ssize_t dpoll_post_push_impl(int dpollfd, int qd, int socfd,
+                             const struct iovec *iov, int iovcnt, void *data)
+{
+	epoll_t *ep = epoll_buf_get(dpollfd);
+	socket_t *soc = *soc_buf_get(socfd);
+	assert(soc->open);
+	struct dpoll_op *op = op_post_push(ep, soc, qd, iov, iovcnt, data);
+	return op ? op->res : -1;
+}
+
+struct dpoll_doorbell *dpoll_doorbell_get_impl(int dpollfd)
+{
+	epoll_t *ep = epoll_buf_get(dpollfd);
+	if (!ep->doorbell)
+		ep->doorbell = doorbell_new(ep->epollfd);
+	if (ep->doorbell)
+		doorbell_get(ep->doorbell);
+	return ep->doorbell;
+}
+
+size_t dpoll_inflight_impl(int dpollfd)
+{
+	return epoll_buf_get(dpollfd)->ops_len;
+}
+
+int dpoll_reap_impl(int dpollfd, struct dpoll_completion *comps, int max)
+{
+	return ep_reap_ops(epoll_buf_get(dpollfd), comps, max);
+}
+
 ssize_t dpoll_write_impl(int qd, const void *buf, size_t count)
 {
 	socket_t *soc = *soc_buf_get(qd);
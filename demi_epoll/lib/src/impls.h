@@ -2,7 +2,9 @@
 
 #include <assert.h>
 #include <sys/socket.h>
+#include "completion.h"
 #include "epoll_wrapper.h"
+#include "latency.h"
 #include <stdbool.h>
 #include <sys/epoll.h>
 
@@ -66,4 +68,28 @@ ssize_t dpoll_read_impl(int qd, void *buf, size_t count);
 ssize_t dpoll_readv_impl(int qd, struct iovec *iov, int iovcnt);
 ssize_t dpoll_writev_impl(int qd, const struct iovec *iov, int iovcnt);
 
+int dpoll_set_idle_timeout_impl(int qd, unsigned timeout_ms);
+
+int dpoll_set_priority_impl(int dpollfd, int socfd, enum dpoll_priority prio);
+int dpoll_set_ready_budget_impl(int dpollfd, enum dpoll_priority prio,
+                                unsigned budget);
+
+int dpoll_get_socket_mem_usage_impl(int qd, struct dpoll_mem_usage *usage);
+
+int dpoll_get_listener_latency_histogram_impl(int qd,
+                                              struct dpoll_latency_hist *hist);
+
+bool dpoll_completion_enabled_impl(int qd);
+
+int dpoll_post_pop_impl(int dpollfd, int qd, int socfd, void *data);
+
+ssize_t dpoll_post_push_impl(int dpollfd, int qd, int socfd,
+                             const struct iovec *iov, int iovcnt, void *data);
+
+size_t dpoll_inflight_impl(int dpollfd);
+
+int dpoll_reap_impl(int dpollfd, struct dpoll_completion *comps, int max);
+
+struct dpoll_doorbell *dpoll_doorbell_get_impl(int dpollfd);
+
 uint32_t available_events(const epoll_item_t *it);
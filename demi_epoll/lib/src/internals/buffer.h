@@ -2,6 +2,7 @@
 
 #include <stddef.h>
 #include <assert.h>
+#include <errno.h>
 #include <stdlib.h>
 
 #define BUFFER_DEF(name, type, buf_name)			\
@@ -20,11 +21,15 @@ static int name ## _next(void) {				\
 		buf_name.next_free = buf_name.items[fd].next_free;\
 		return fd;					\
 	}							\
-	const size_t size = sizeof(buf_name.items[0]) * (++buf_name.size);	\
+	const size_t size = sizeof(buf_name.items[0]) * (buf_name.size + 1);	\
 	/* NOLINTNEXTLINE */ 					\
-	buf_name.items = realloc(buf_name.items, size);		\
-	assert(buf_name.items);					\
-	return buf_name.size - 1;				\
+	__auto_type items = realloc(buf_name.items, size);	\
+	if (!items) {						\
+		errno = ENOMEM;					\
+		return -1;					\
+	}							\
+	buf_name.items = items;					\
+	return buf_name.size++;					\
 }								\
 static void name ## _free(int fd) {				\
 	assert(fd < buf_name.size);				\
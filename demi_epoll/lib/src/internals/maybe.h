@@ -5,6 +5,8 @@
 struct maybe_prefix {
 	demi_qtoken_t tok;
 	_Bool pending;
+	/// see histogram.h
+	uint64_t issued;
 	int ret;
 };
 
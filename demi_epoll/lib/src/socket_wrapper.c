@@ -9,6 +9,10 @@
 #include <stdio.h>
 #include <sys/param.h>
 
+#include "budget.h"
+#include "histogram.h"
+#include "idle.h"
+#include "tracer.h"
 #include "utils.h"
 
 const struct timespec ZERO = { 0 };
@@ -43,17 +47,93 @@ static void sga_free(struct sga *sga)
 	// sga->base.tok = 0;
 }
 
-static void sga_new(struct sga *sga, size_t size)
+static bool sga_new(struct sga *sga, size_t size)
 {
 	sga->elem = demi_sgaalloc(size);
-	assert(!sga_is_empty(sga));
+	return !sga_is_empty(sga);
+}
+
+static void recv_free(socket_t *soc)
+{
+	mem_uncharge_recv(soc, sga_total_len(&soc->recv.elem));
+	sga_free(&soc->recv);
+}
+
+static void send_free(socket_t *soc)
+{
+	mem_uncharge_send(soc, sga_total_len(&soc->send.elem));
+	sga_free(&soc->send);
+}
+
+static int send_new(socket_t *soc, size_t size)
+{
+	if (!sga_new(&soc->send, size)) {
+		errno = ENOMEM;
+		return -1;
+	}
+	mem_charge_send(soc, sga_total_len(&soc->send.elem));
+	return 0;
+}
+
+/// pushes the send sga, which is dropped again if that fails
+static int send_push(socket_t *soc)
+{
+	const int ret = demi_push(&soc->send.base.tok, soc->qd, &soc->send.elem);
+	if (ret != 0) {
+		demi_log("push on %u failed: %s\n", soc->qd, strerror(ret));
+		send_free(soc);
+		errno = ret;
+		return -1;
+	}
+	soc->send.base.pending = true;
+	soc->send.base.issued = latency_start();
+	return 0;
+}
+
+/// waits for the pending push without blocking, and releases its sga
+///
+/// returns -1 with EWOULDBLOCK if it is still running
+static int send_complete(socket_t *soc)
+{
+	demi_qresult_t res;
+	const int ret = demi_wait(&res, soc->send.base.tok, &ZERO);
+	if (ret == ETIMEDOUT) {
+		errno = EWOULDBLOCK;
+		return -1;
+	}
+	soc->send.base.pending = false;
+	send_free(soc);
+	if (ret != 0) {
+		errno = ret;
+		return -1;
+	}
+	trace_result(&res);
+	if (res.qr_opcode == DEMI_OPC_FAILED) {
+		soc->err = res.qr_ret;
+		errno = res.qr_ret;
+		return -1;
+	}
+	assert(res.qr_opcode == DEMI_OPC_PUSH);
+	latency_record(DPOLL_LAT_PUSH, NULL, soc->send.base.issued);
+	return 0;
 }
 
 demi_result_t maybe_accept(socket_t *soc, struct sockaddr_in *addr)
 {
-	if (accept_is_empty(&soc->accept)) {
-		assert(demi_accept(&soc->accept.base.tok, soc->qd) == 0);
+	// unlike on a connection, a failed accept does not break the socket
+	if (soc->err) {
+		errno = soc->err;
+		soc->err = 0;
+		return -1;
+	}
+	if (accept_is_empty(&soc->accept) && !soc->accept.base.pending) {
+		const int ret = demi_accept(&soc->accept.base.tok, soc->qd);
+		if (ret != 0) {
+			errno = ret;
+			return -1;
+		}
 		soc->accept.base.pending = true;
+		soc->accept.base.issued = latency_start();
 		errno = EWOULDBLOCK;
 		return -1;
 	}
@@ -64,10 +144,17 @@ demi_result_t maybe_accept(socket_t *soc, struct sockaddr_in *addr)
 			errno = EWOULDBLOCK;
 			return -1;
 		}
-		assert(ret == 0);
+		soc->accept.base.pending = false;
+		if (ret != 0) {
+			errno = ret;
+			return -1;
+		}
+		trace_result(&res);
 		assert(res.qr_opcode == DEMI_OPC_ACCEPT ||
 			res.qr_opcode == DEMI_OPC_FAILED);
 		if (res.qr_opcode == DEMI_OPC_ACCEPT) {
+			latency_record(DPOLL_LAT_ACCEPT, soc->lat,
+			               soc->accept.base.issued);
 			soc->accept.elem = res.qr_value.ares;
 		} else {
 			demi_log("accept failed with reason: %s\n",
@@ -86,23 +173,22 @@ demi_result_t maybe_accept(socket_t *soc, struct sockaddr_in *addr)
 
 ssize_t maybe_write(socket_t *soc, const void *buf, size_t len)
 {
-	demi_qresult_t res;
-	if (soc->send.base.pending) {
-		const int ret = demi_wait(&res, soc->send.base.tok, &ZERO);
-		if (ret == ETIMEDOUT)
-			goto would_block;
-
-		assert(ret == 0);
-		sga_free(&soc->send);
+	if (soc->err) {
+		errno = soc->err;
+		return -1;
 	}
+	if (soc->send.base.pending && send_complete(soc))
+		return -1;
 	if (sga_is_empty(&soc->send)) {
-		sga_new(&soc->send, len);
+		len = MIN(len, mem_send_allowance(soc));
+		if (len == 0)
+			goto would_block;
+		if (send_new(soc, len))
+			return -1;
+		idle_touch(soc);
 		size_t ret = copy_buf_into_sga(buf, len, &soc->send.elem);
-		assert(
-			demi_push(&soc->send.base.tok, soc->qd, &soc->send.elem)
-			==
-			0);
-		soc->send.base.pending = true;
+		if (send_push(soc))
+			return -1;
 		return ret;
 	}
 
@@ -116,9 +202,24 @@ would_block:
 
 ssize_t maybe_read(socket_t *soc, void *buf, size_t len)
 {
+	if (soc->idle.expired && sga_is_empty(&soc->recv)) {
+		errno = ETIMEDOUT;
+		return -1;
+	}
+	// data popped before the failure is still handed out
+	if (soc->err && sga_is_empty(&soc->recv) && !soc->recv.base.pending) {
+		errno = soc->err;
+		return -1;
+	}
 	if (sga_is_empty(&soc->recv) && !soc->recv.base.pending) {
+		const int ret = demi_pop(&soc->recv.base.tok, soc->qd);
+		if (ret != 0) {
+			soc->err = ret;
+			errno = ret;
+			return -1;
+		}
 		soc->recv.base.pending = true;
-		assert(demi_pop(&soc->recv.base.tok, soc->qd) == 0);
+		soc->recv.base.issued = latency_start();
 		goto would_block;
 	}
 
@@ -127,18 +228,29 @@ ssize_t maybe_read(socket_t *soc, void *buf, size_t len)
 		const int ret = demi_wait(&res, soc->recv.base.tok, &ZERO);
 		if (ret == ETIMEDOUT)
 			goto would_block;
-		assert(ret == 0);
 		soc->recv.base.pending = false;
+		if (ret != 0) {
+			errno = ret;
+			return -1;
+		}
+		trace_result(&res);
+		if (res.qr_opcode == DEMI_OPC_FAILED) {
+			soc->err = res.qr_ret;
+			errno = res.qr_ret;
+			return -1;
+		}
+		latency_record(DPOLL_LAT_POP, NULL, soc->recv.base.issued);
 		soc->recv_off = 0;
-		// TODO: error handling
 		soc->recv.elem = res.qr_value.sga;
+		mem_charge_recv(soc, sga_total_len(&soc->recv.elem));
 	}
 	assert(!sga_is_empty(&soc->recv));
+	idle_touch(soc);
 	const size_t off = soc->recv_off;
 	bool emptied = copy_sga_into_buf(buf, len, &soc->recv.elem,
 	                                 &soc->recv_off);
 	if (emptied) {
-		sga_free(&soc->recv);
+		recv_free(soc);
 	}
 	return (ssize_t)(soc->recv_off - off);
 
@@ -150,8 +262,14 @@ would_block:
 socket_t *socket_init(void)
 {
 	socket_t *soc = calloc(1, sizeof(*soc));
-	assert(soc);
+	if (!soc) {
+		errno = ENOMEM;
+		return NULL;
+	}
 	accept_free(&soc->accept);
+	LIST_HEAD_INIT(&soc->ops);
+	LIST_HEAD_INIT(&soc->unread);
+	LIST_HEAD_INIT(&soc->idle.entry);
 	soc->ref_counter = 1;
 	soc->open = true;
 
@@ -164,6 +282,25 @@ socket_t *socket_init(void)
 	return soc;
 }
 
+/// collects the result of the pending pop, and frees whatever it popped
+static void recv_drain(socket_t *soc)
+{
+	demi_qresult_t res;
+	const int ret = demi_wait(&res, soc->recv.base.tok, NULL);
+	soc->recv.base.pending = false;
+	if (ret != 0) {
+		demi_log("draining the pop of %u: %s\n", soc->qd, strerror(ret));
+		return;
+	}
+	trace_result(&res);
+	if (res.qr_opcode == DEMI_OPC_POP) {
+		const int err = demi_sgafree(&res.qr_value.sga);
+		if (err)
+			demi_log("draining the pop of %u: %s\n", soc->qd,
+			         strerror(err));
+	}
+}
+
 static void socket_flush_and_close(socket_t *soc)
 {
 	struct sga *sgas[2] = { &soc->send, &soc->recv };
@@ -173,22 +310,33 @@ static void socket_flush_and_close(socket_t *soc)
 		if (!sga_is_empty(sgas[i])) {
 			// TODO: do this better
 			if (sgas[i]->base.pending) {
-				assert(
-					demi_wait(&res, sgas[i]->base.tok, NULL)
-					==
-					0);
+				const int ret = demi_wait(&res,
+				                          sgas[i]->base.tok,
+				                          NULL);
+				if (ret == 0)
+					trace_result(&res);
+				if (ret != 0)
+					demi_log("flushing %u: %s\n", soc->qd,
+					         strerror(ret));
+				else if (res.qr_opcode == DEMI_OPC_FAILED)
+					demi_log("flushing %u: %s\n", soc->qd,
+					         strerror(res.qr_ret));
 			}
-			//assert(res.qr_opcode == DEMI_OPC_PUSH || res.qr_opcode == DEMI_OPC_POP || );
-			assert(
-				res.qr_opcode != DEMI_OPC_FAILED || res.
-				qr_opcode != DEMI_OPC_INVALID);
 			if (i == 0) {
 				demi_log("just finished writing\n");
+				send_free(soc);
+			} else {
+				recv_free(soc);
 			}
-			sga_free(sgas[i]);
 		}
 	}
-	assert(demi_close(soc->qd) == 0);
+	const int ret = demi_close(soc->qd);
+	if (ret != 0)
+		demi_log("closing %u: %s\n", soc->qd, strerror(ret));
+	// a pop which never brought anything, e.g. one taken over from an
+	// expired op, fails once the queue is closed
+	if (!socket_is_accepting(soc) && soc->recv.base.pending)
+		recv_drain(soc);
 }
 
 socket_t *socket_clone(socket_t *soc)
@@ -203,93 +351,94 @@ void socket_close(socket_t *soc)
 		socket_flush_and_close(soc);
 	}
 	if (--soc->ref_counter == 0) {
+		latency_listener_free(soc->lat);
 		free(soc);
 	}
 }
 
+// a failed socket is readable and writable, the call reports the error
+
 bool socket_can_write(const socket_t *soc)
 {
-	return sga_is_empty(&soc->send) && !soc->send.base.pending;
+	return (sga_is_empty(&soc->send) && !soc->send.base.pending &&
+	        mem_send_allowance(soc) > 0) || soc->err;
 }
 
 bool socket_can_read(const socket_t *soc)
 {
-	return !soc->recv.base.pending && !sga_is_empty(&soc->recv);
+	// an expired socket is readable, the read reports the timeout
+	return (!soc->recv.base.pending && !sga_is_empty(&soc->recv)) ||
+	       soc->idle.expired || soc->err;
 }
 
 bool socket_can_accept(const socket_t *soc)
 {
-	return !soc->accept.base.pending && !accept_is_empty(&soc->accept);
+	return (!soc->accept.base.pending && !accept_is_empty(&soc->accept)) ||
+	       soc->err;
+}
+
+/// a failed result carries no opcode, so it is matched by its token
+static void socket_handle_failure(socket_t *soc, const demi_qresult_t *res)
+{
+	demi_log("op on %u failed: %s\n", soc->qd, strerror(res->qr_ret));
+	soc->err = res->qr_ret;
+	if (socket_is_accepting(soc)) {
+		if (soc->accept.base.tok == res->qr_qt)
+			soc->accept.base.pending = false;
+		return;
+	}
+	if (soc->recv.base.pending && soc->recv.base.tok == res->qr_qt) {
+		soc->recv.base.pending = false;
+	} else if (soc->send.base.pending &&
+	           soc->send.base.tok == res->qr_qt) {
+		soc->send.base.pending = false;
+		send_free(soc);
+	}
 }
 
 void socket_handle_event(socket_t *soc, const demi_qresult_t *res)
 {
 	const demi_opcode_t opcode = res->qr_opcode;
-	assert(
-		opcode == DEMI_OPC_ACCEPT || opcode == DEMI_OPC_PUSH || opcode
-		== DEMI_OPC_POP);
 
+	idle_touch(soc);
 	switch (opcode) {
+	case DEMI_OPC_FAILED:
+		socket_handle_failure(soc, res);
+		break;
 	case DEMI_OPC_ACCEPT:
 		assert(socket_is_accepting(soc));
+		latency_record(DPOLL_LAT_ACCEPT, soc->lat, soc->accept.base.issued);
 		soc->accept.base.pending = false;
 		soc->accept.elem = res->qr_value.ares;
 		demi_log("socket %d can accept a new con\n", soc->qd);
 		break;
 	case DEMI_OPC_POP:
 		assert(!socket_is_accepting(soc));
+		latency_record(DPOLL_LAT_POP, NULL, soc->recv.base.issued);
 		soc->recv.base.pending = false;
 		soc->recv_off = 0;
 		soc->recv.elem = res->qr_value.sga;
+		mem_charge_recv(soc, sga_total_len(&soc->recv.elem));
 		break;
 	case DEMI_OPC_PUSH:
+		// the pushed sga is our own, release it (and its budget) now
+		latency_record(DPOLL_LAT_PUSH, NULL, soc->send.base.issued);
 		soc->send.base.pending = false;
-		soc->send.elem = res->qr_value.sga;
+		send_free(soc);
 		break;
 	default:
 		GIVE_UP("invalid demi opcode: %d\n", opcode);
 	}
 }
 
-static void copy_iovs_into_sga(const struct iovec *iov, int iov_cnt,
-                               struct sga *sga)
-{
-	const demi_sgarray_t *s = &sga->elem;
-	size_t buf_off = 0;
-	size_t seg_off = 0;
-	for (int i = 0; i < iov_cnt; ++i) {
-		struct iovec v = iov[i];
-		size_t copied = 0;
-		while (copied < v.iov_len) {
-			demi_sgaseg_t seg = s->sga_segs[seg_off];
-			size_t to_copy = MIN(v.iov_len,
-			                     seg.sgaseg_len - buf_off);
-			memcpy(seg.sgaseg_buf + buf_off, v.iov_base + copied,
-			       to_copy);
-			copied += to_copy;
-			buf_off += to_copy;
-			if (buf_off >= seg.sgaseg_len) {
-				++seg_off;
-				buf_off = 0;
-			}
-		}
-	}
-}
-
 ssize_t maybe_writev(socket_t *soc, const struct iovec *iov, int iov_cnt)
 {
-	if (soc->send.base.pending) {
-		demi_qresult_t res;
-		const int ret = demi_wait(&res, soc->send.base.tok, &ZERO);
-		if (ret == ETIMEDOUT) {
-			errno = EWOULDBLOCK;
-			return -1;
-		}
-
-		assert(ret == 0);
-		assert(res.qr_opcode == DEMI_OPC_PUSH);
-		sga_free(&soc->send);
+	if (soc->err) {
+		errno = soc->err;
+		return -1;
 	}
+	if (soc->send.base.pending && send_complete(soc))
+		return -1;
 	assert(sga_is_empty(&soc->send));
 	size_t total_size = 0;
 	for (int i = 0; i < iov_cnt; ++i) {
@@ -297,12 +446,17 @@ ssize_t maybe_writev(socket_t *soc, const struct iovec *iov, int iov_cnt)
 	}
 	if (total_size == 0)
 		return 0;
-	sga_new(&soc->send, total_size);
-	copy_iovs_into_sga(iov, iov_cnt, &soc->send);
-	// TODO: actually push data
-
-	assert(demi_push(&soc->send.base.tok, soc->qd, &soc->send.elem) == 0);
-	soc->send.base.pending = true;
+	total_size = MIN(total_size, mem_send_allowance(soc));
+	if (total_size == 0) {
+		errno = EWOULDBLOCK;
+		return -1;
+	}
+	if (send_new(soc, total_size))
+		return -1;
+	idle_touch(soc);
+	copy_iovs_into_sga(iov, iov_cnt, &soc->send.elem);
+	if (send_push(soc))
+		return -1;
 	return total_size;
 }
 
@@ -313,9 +467,9 @@ ssize_t maybe_readv(socket_t *soc, struct iovec *iovs, int iovs_cnt)
 		struct iovec iov = iovs[i];
 		ssize_t r = maybe_read(soc, iov.iov_base, iov.iov_len);
 		if (r < 0) {
+			// the error is reported again by the next read
 			if (read == 0)
 				return -1;
-			assert(errno == EWOULDBLOCK);
 			break;
 		}
 		read += r;
@@ -1,11 +1,14 @@
 #pragma once
 
 #include <stddef.h>
+#include "internals/list.h"
 #include "internals/maybe.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <netinet/in.h>
 #include <sys/types.h>
 #include "demi_socket.h"
+#include "dpoll.h"
 
 #include <demi/sga.h>
 
@@ -20,6 +23,8 @@ typedef struct socket {
 	uint32_t ref_counter;
 	bool open;
 	struct sockaddr_in addr;
+	/// `addr` still has to be bound, which listen does in reuseport mode
+	bool bind_deferred;
 
 	struct sga send;
 	// -1 if accepting
@@ -29,6 +34,32 @@ typedef struct socket {
 		struct sga recv;
 		struct accept accept;
 	};
+
+	/// failure of a pop, push or accept which completed in the background,
+	/// reported as errno by the next call on the socket
+	int err;
+
+	/// completion ops posted on this socket
+	list_elem_t ops;
+	bool pop_posted;
+	/// released pops whose unread data could not go back into `recv`, oldest
+	/// data first. the next posted pops hand them out before anything else
+	list_elem_t unread;
+
+	/// bytes held by the shim on behalf of this socket, see budget.h
+	struct dpoll_mem_usage mem;
+
+	/// accept latency, only set on listening sockets, see histogram.h
+	struct latency_listener *lat;
+
+	/// see idle.h
+	struct {
+		/// entry in the timing wheel, self linked if not armed
+		list_elem_t entry;
+		uint32_t timeout;
+		uint64_t last;
+		bool expired;
+	} idle;
 } socket_t;
 
 socket_t *socket_init(void);
@@ -0,0 +1,120 @@
+#include "tracer.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+#include "utils.h"
+
+#define TRACE_DEFAULT_SIZE (1 << 16)
+
+bool trace_enabled = false;
+
+static struct dpoll_trace_rec *ring = NULL;
+static size_t ring_cap = 0;
+/// total number of records, the newest one is at `(ring_count - 1) % ring_cap`.
+/// applications may call in from several threads, so slots are taken with an
+/// atomic increment
+static _Atomic uint64_t ring_count = 0;
+static char *trace_path = NULL;
+
+static void trace_dump_at_exit(void)
+{
+	if (dpoll_trace_dump(trace_path))
+		demi_log("could not write the trace to %s: %s\n", trace_path,
+		         strerror(errno));
+}
+
+void trace_init(void)
+{
+	const char *path = getenv("DEMI_EPOLL_TRACE");
+	if (!path || *path == '\0')
+		return;
+
+	ring_cap = TRACE_DEFAULT_SIZE;
+	const char *size = getenv("DEMI_EPOLL_TRACE_SIZE");
+	if (size) {
+		char *end;
+		const unsigned long v = strtoul(size, &end, 10);
+		if (end != size && *end == '\0' && v > 0)
+			ring_cap = v;
+		else
+			demi_log("ignoring invalid DEMI_EPOLL_TRACE_SIZE: %s\n",
+			         size);
+	}
+
+	ring = calloc(ring_cap, sizeof(ring[0]));
+	trace_path = strdup(path);
+	if (!ring || !trace_path) {
+		demi_log("not enough memory for %zu trace records\n", ring_cap);
+		free(ring);
+		free(trace_path);
+		return;
+	}
+	atexit(trace_dump_at_exit);
+	trace_enabled = true;
+}
+
+void trace_record(enum dpoll_trace_call call, uint64_t start, int fd,
+                  int64_t a0, int64_t a1, int64_t a2, int64_t ret)
+{
+	const uint64_t end = trace_now();
+	const uint64_t slot =
+		atomic_fetch_add_explicit(&ring_count, 1, memory_order_relaxed);
+	ring[slot % ring_cap] = (struct dpoll_trace_rec){
+		.start = start ? start : end,
+		.end = end,
+		.call = call,
+		.fd = fd,
+		.args = { a0, a1, a2 },
+		.ret = ret,
+		// demikernel results carry their own error
+		.err = ret >= 0 ? 0 : call == DPOLL_TR_DEMI_RESULT ? -ret : errno,
+	};
+}
+
+void trace_demi_result(const demi_qresult_t *res)
+{
+	trace_record(DPOLL_TR_DEMI_RESULT, 0, res->qr_qd, res->qr_opcode,
+	             res->qr_qt,
+	             res->qr_opcode == DEMI_OPC_POP ?
+	             sga_total_len(&res->qr_value.sga) : 0,
+	             res->qr_opcode == DEMI_OPC_FAILED ? -res->qr_ret : 0);
+}
+
+int dpoll_trace_dump(const char *path)
+{
+	if (!trace_enabled) {
+		errno = EINVAL;
+		return -1;
+	}
+	FILE *f = fopen(path, "wb");
+	if (!f)
+		return -1;
+
+	const uint64_t total = atomic_load(&ring_count);
+	const uint64_t count = total < ring_cap ? total : ring_cap;
+	const struct dpoll_trace_header header = {
+		.magic = DPOLL_TRACE_MAGIC,
+		.version = DPOLL_TRACE_VERSION,
+		.rec_size = sizeof(struct dpoll_trace_rec),
+		.count = count,
+		.dropped = total - count,
+	};
+	// oldest first, the ring might have wrapped around
+	const size_t first = (total - count) % ring_cap;
+	const size_t tail = count < ring_cap - first ? count : ring_cap - first;
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+	          fwrite(ring + first, sizeof(ring[0]), tail, f) == tail &&
+	          fwrite(ring, sizeof(ring[0]), count - tail, f) == count - tail;
+	const int err = errno;
+	ok = fclose(f) == 0 && ok;
+	if (!ok) {
+		errno = err;
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <demi/types.h>
+
+#include "trace.h"
+
+extern bool trace_enabled;
+
+/// reads `DEMI_EPOLL_TRACE` and `DEMI_EPOLL_TRACE_SIZE`
+void trace_init(void);
+
+static inline uint64_t trace_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/// returns 0 while tracing is disabled, so the disabled path costs a branch
+static inline uint64_t trace_start(void)
+{
+	return trace_enabled ? trace_now() : 0;
+}
+
+void trace_record(enum dpoll_trace_call call, uint64_t start, int fd,
+                  int64_t a0, int64_t a1, int64_t a2, int64_t ret);
+
+/// records a call started at `start`, errno is left untouched
+#define trace_call(_call, _start, _fd, _a0, _a1, _a2, _ret) do { \
+	if (trace_enabled) \
+		trace_record((_call), (_start), (_fd), (_a0), (_a1), (_a2), \
+		             (_ret)); \
+} while (0)
+
+void trace_demi_result(const demi_qresult_t *res);
+
+/// records a demikernel result, whichever wait handed it out. the replay feeds
+/// these back in place of the libos
+#define trace_result(_res) do { \
+	if (trace_enabled) \
+		trace_demi_result(_res); \
+} while (0)
@@ -19,6 +19,33 @@ size_t copy_buf_into_sga(const void *buf, size_t len, demi_sgarray_t *sga)
 	return copied;
 }
 
+void copy_iovs_into_sga(const struct iovec *iov, int iov_cnt,
+                        demi_sgarray_t *sga)
+{
+	size_t buf_off = 0;
+	size_t seg_off = 0;
+	for (int i = 0; i < iov_cnt; ++i) {
+		struct iovec v = iov[i];
+		size_t copied = 0;
+		while (copied < v.iov_len) {
+			// the sga can be shorter than the iovs
+			if (seg_off >= sga->sga_numsegs)
+				return;
+			demi_sgaseg_t seg = sga->sga_segs[seg_off];
+			size_t to_copy = MIN(v.iov_len - copied,
+			                     seg.sgaseg_len - buf_off);
+			memcpy(seg.sgaseg_buf + buf_off, v.iov_base + copied,
+			       to_copy);
+			copied += to_copy;
+			buf_off += to_copy;
+			if (buf_off >= seg.sgaseg_len) {
+				++seg_off;
+				buf_off = 0;
+			}
+		}
+	}
+}
+
 bool copy_sga_into_buf(void *buf, size_t buf_len, const demi_sgarray_t *sga,
                        ssize_t *offset)
 {
@@ -61,6 +88,14 @@ bool copy_sga_into_buf(void *buf, size_t buf_len, const demi_sgarray_t *sga,
 	return true;
 }
 
+size_t sga_total_len(const demi_sgarray_t *sga)
+{
+	size_t len = 0;
+	for (unsigned i = 0; i < sga->sga_numsegs; ++i)
+		len += sga->sga_segs[i].sgaseg_len;
+	return len;
+}
+
 struct timespec ms_timeout_to_timespec(int ms_timeout)
 {
 	struct timespec ts = { 0 };
@@ -7,6 +7,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <sys/epoll.h>
+#include <sys/uio.h>
 
 #define DEMI_ERR(_ret, msg, ...) do { if (_ret != 0) { errno = _ret; demi_log(msg, ##__VA_ARGS__); return -1; } } while(0)
 
@@ -28,7 +29,13 @@ static inline void verify_events(uint32_t events)
 /// atm it will panic if the sga cannot fit the entire buf
 size_t copy_buf_into_sga(const void *buf, size_t len, demi_sgarray_t *sga);
 
+/// copies as much as fits into the sga
+void copy_iovs_into_sga(const struct iovec *iov, int iov_cnt,
+                        demi_sgarray_t *sga);
+
 bool copy_sga_into_buf(void *buf, size_t buf_len, const demi_sgarray_t *sga,
                        ssize_t *offset);
 
+size_t sga_total_len(const demi_sgarray_t *sga);
+
 struct timespec ms_timeout_to_timespec(int ms_timeout);
@@ -1,38 +1,73 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/uio.h>
+#include <errno.h>
+#include <string.h>
+#include <arpa/inet.h>
 
 #include "impls.h"
 #include "log.h"
 #include "sockets.h"
+#include "completion.h"
+#include "completions.h"
+#include "doorbell.h"
+#include "tracer.h"
 
 static inline int maybe_add(int ret, int off)
 {
 	return ret > -1 ? ret + off : -1;
 }
 
+/// ipv4 address and port for the trace
+static inline int64_t addr_arg(const struct sockaddr *addr, int i)
+{
+	const struct sockaddr_in *a = (const void *)addr;
+	if (!a || a->sin_family != AF_INET)
+		return 0;
+	return i == 0 ? ntohl(a->sin_addr.s_addr) : ntohs(a->sin_port);
+}
+
+static inline size_t iovs_len(const struct iovec *iov, int iovcnt)
+{
+	size_t len = 0;
+	for (int i = 0; i < iovcnt; ++i)
+		len += iov[i].iov_len;
+	return len;
+}
+
 int dpoll_epoll_create(int flags)
 {
-	return maybe_add(dpoll_create_impl(flags), DPOLL_EPOLL_OFFSET);
+	const uint64_t t = trace_start();
+	const int ret = maybe_add(dpoll_create_impl(flags), DPOLL_EPOLL_OFFSET);
+	trace_call(DPOLL_TR_EPOLL_CREATE, t, -1, flags, 0, 0, ret);
+	return ret;
 }
 
 int dpoll_epoll_ctl(int dpollfd, int op, int fd, struct epoll_event *event)
 {
 	assert(qd_is_dpoll(dpollfd));
-	return dpoll_ctl_impl(get_epoll_fd(dpollfd), op, fd,
-	                      event);
+	const uint64_t t = trace_start();
+	const int ret = dpoll_ctl_impl(get_epoll_fd(dpollfd), op, fd, event);
+	trace_call(DPOLL_TR_EPOLL_CTL, t, dpollfd, op, fd,
+	           event ? event->events : 0, ret);
+	return ret;
 }
 
 int dpoll_epoll_pwait(int dpollfd, struct epoll_event *events, int maxevents,
                       int timeout, const sigset_t *sigmask)
 {
 	assert(qd_is_dpoll(dpollfd));
-	return dpoll_pwait_impl(get_epoll_fd(dpollfd), events, maxevents,
-	                        timeout, sigmask);
+	const uint64_t t = trace_start();
+	const int ret = dpoll_pwait_impl(get_epoll_fd(dpollfd), events,
+	                                 maxevents, timeout, sigmask);
+	trace_call(DPOLL_TR_EPOLL_PWAIT, t, dpollfd, maxevents, timeout, 0,
+	           ret);
+	return ret;
 }
 
 int dpoll_socket(int domain, int type, int protocol)
 {
+	const uint64_t t = trace_start();
 	demi_log("domain: %d, type: %d\n", domain, type);
 	if (domain == AF_INET6) {
 		demi_log("domain requested is IPV4, we do not support this\n");
@@ -44,37 +79,60 @@ int dpoll_socket(int domain, int type, int protocol)
 	else
 		fd = socket(domain, type, protocol);
 	demi_log("socket: %d\n", fd);
+	trace_call(DPOLL_TR_SOCKET, t, -1, domain, type, protocol, fd);
 	return fd;
 }
 
 int dpoll_bind(int qd, const struct sockaddr *addr, socklen_t addrlen)
 {
+	const uint64_t t = trace_start();
+	int ret;
 	if (qd_is_dpoll(qd))
-		return dpoll_bind_impl(get_socket_fd(qd), addr, addrlen);
-	return bind(qd, addr, addrlen);
+		ret = dpoll_bind_impl(get_socket_fd(qd), addr, addrlen);
+	else
+		ret = bind(qd, addr, addrlen);
+	trace_call(DPOLL_TR_BIND, t, qd, addr_arg(addr, 0), addr_arg(addr, 1),
+	           0, ret);
+	return ret;
 }
 
 int dpoll_connect(int qd, const struct sockaddr *addr, socklen_t size)
 {
+	const uint64_t t = trace_start();
+	int ret;
 	if (qd_is_dpoll(qd))
-		return dpoll_connect_impl(get_socket_fd(qd), addr, size);
-	return connect(qd, addr, size);
+		ret = dpoll_connect_impl(get_socket_fd(qd), addr, size);
+	else
+		ret = connect(qd, addr, size);
+	trace_call(DPOLL_TR_CONNECT, t, qd, addr_arg(addr, 0),
+	           addr_arg(addr, 1), 0, ret);
+	return ret;
 }
 
 int dpoll_accept(int qd, struct sockaddr *addr, socklen_t *addrlen)
 {
+	const uint64_t t = trace_start();
+	int ret;
 	if (qd_is_dpoll(qd))
-		return maybe_add(
+		ret = maybe_add(
 			dpoll_accept_impl(get_socket_fd(qd), addr, addrlen),
 			DPOLL_SOCKET_OFFSET);
-	return accept(qd, addr, addrlen);
+	else
+		ret = accept(qd, addr, addrlen);
+	trace_call(DPOLL_TR_ACCEPT, t, qd, 0, 0, 0, ret);
+	return ret;
 }
 
 int dpoll_listen(int qd, int backlog)
 {
+	const uint64_t t = trace_start();
+	int ret;
 	if (qd_is_dpoll(qd))
-		return dpoll_listen_impl(get_socket_fd(qd), backlog);
-	return listen(qd, backlog);
+		ret = dpoll_listen_impl(get_socket_fd(qd), backlog);
+	else
+		ret = listen(qd, backlog);
+	trace_call(DPOLL_TR_LISTEN, t, qd, backlog, 0, 0, ret);
+	return ret;
 }
 
 int dpoll_getsockname(int qd, struct sockaddr *addr, socklen_t *addrlen)
@@ -94,51 +152,262 @@ int dpoll_setsockopt(int qd, int level, int optname, const void *optval,
 	return setsockopt(qd, level, optname, optval, optlen);
 }
 
+/// true if `msg` tries to pass a dpoll descriptor to another process, which
+/// cannot work as they only exist in this one
+static bool msg_passes_dpoll_fds(const struct msghdr *msg)
+{
+	struct msghdr *m = (struct msghdr *)msg;
+	struct cmsghdr *cmsg;
+	for (cmsg = CMSG_FIRSTHDR(m); cmsg; cmsg = CMSG_NXTHDR(m, cmsg)) {
+		if (cmsg->cmsg_level != SOL_SOCKET ||
+		    cmsg->cmsg_type != SCM_RIGHTS)
+			continue;
+		const size_t n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		for (size_t i = 0; i < n; ++i) {
+			int fd;
+			memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(fd), sizeof(fd));
+			if (qd_is_dpoll(fd))
+				return true;
+		}
+	}
+	return false;
+}
+
+bool dpoll_is_socket(int qd)
+{
+	return qd_is_dpoll(qd) && !qd_is_epoll(qd);
+}
+
 ssize_t dpoll_sendmsg(int qd, const struct msghdr *msg, int flags)
 {
-	if (qd_is_dpoll(qd))
-		return dpoll_sendmsg_impl(get_socket_fd(qd), msg, flags);
-	return sendmsg(qd, msg, flags);
+	const uint64_t t = trace_start();
+	ssize_t ret;
+	if (qd_is_dpoll(qd)) {
+		ret = dpoll_sendmsg_impl(get_socket_fd(qd), msg, flags);
+	} else if (msg_passes_dpoll_fds(msg)) {
+		errno = EOPNOTSUPP;
+		ret = -1;
+	} else {
+		ret = sendmsg(qd, msg, flags);
+	}
+	trace_call(DPOLL_TR_WRITE, t, qd,
+	           iovs_len(msg->msg_iov, msg->msg_iovlen), msg->msg_iovlen, 0,
+	           ret);
+	return ret;
 }
 
 ssize_t dpoll_recvmsg(int qd, struct msghdr *msg, int flags)
 {
+	const uint64_t t = trace_start();
+	ssize_t ret;
 	if (qd_is_dpoll(qd))
-		return dpoll_recvmsg_impl(get_socket_fd(qd), msg, flags);
-	return recvmsg(qd, msg, flags);
+		ret = dpoll_recvmsg_impl(get_socket_fd(qd), msg, flags);
+	else
+		ret = recvmsg(qd, msg, flags);
+	trace_call(DPOLL_TR_READ, t, qd,
+	           iovs_len(msg->msg_iov, msg->msg_iovlen), msg->msg_iovlen, 0,
+	           ret);
+	return ret;
 }
 
 int dpoll_close(int qd)
 {
+	const uint64_t t = trace_start();
+	int ret;
 	if (qd_is_dpoll(qd))
-		return dpoll_close_impl(qd);
-	return close(qd);
+		ret = dpoll_close_impl(qd);
+	else
+		ret = close(qd);
+	trace_call(DPOLL_TR_CLOSE, t, qd, 0, 0, 0, ret);
+	return ret;
 }
 
 ssize_t dpoll_write(int qd, const void *buf, size_t count)
 {
+	const uint64_t t = trace_start();
+	ssize_t ret;
 	if (qd_is_dpoll(qd))
-		return dpoll_write_impl(get_socket_fd(qd), buf, count);
-	return write(qd, buf, count);
+		ret = dpoll_write_impl(get_socket_fd(qd), buf, count);
+	else
+		ret = write(qd, buf, count);
+	trace_call(DPOLL_TR_WRITE, t, qd, count, 1, 0, ret);
+	return ret;
 }
 
 ssize_t dpoll_read(int qd, void *buf, size_t count)
 {
+	const uint64_t t = trace_start();
+	ssize_t ret;
 	if (qd_is_dpoll(qd))
-		return dpoll_read_impl(get_socket_fd(qd), buf, count);
-	return read(qd, buf, count);
+		ret = dpoll_read_impl(get_socket_fd(qd), buf, count);
+	else
+		ret = read(qd, buf, count);
+	trace_call(DPOLL_TR_READ, t, qd, count, 1, 0, ret);
+	return ret;
 }
 
 ssize_t dpoll_readv(int qd, struct iovec *iov, int iovcnt)
 {
+	const uint64_t t = trace_start();
+	ssize_t ret;
 	if (qd_is_dpoll(qd))
-		return dpoll_readv_impl(get_socket_fd(qd), iov, iovcnt);
-	return readv(qd, iov, iovcnt);
+		ret = dpoll_readv_impl(get_socket_fd(qd), iov, iovcnt);
+	else
+		ret = readv(qd, iov, iovcnt);
+	trace_call(DPOLL_TR_READ, t, qd, iovs_len(iov, iovcnt), iovcnt, 0,
+	           ret);
+	return ret;
 }
 
 ssize_t dpoll_writev(int qd, const struct iovec *iov, int iovcnt)
 {
+	const uint64_t t = trace_start();
+	ssize_t ret;
 	if (qd_is_dpoll(qd))
-		return dpoll_writev_impl(get_socket_fd(qd), iov, iovcnt);
-	return writev(qd, iov, iovcnt);
+		ret = dpoll_writev_impl(get_socket_fd(qd), iov, iovcnt);
+	else
+		ret = writev(qd, iov, iovcnt);
+	trace_call(DPOLL_TR_WRITE, t, qd, iovs_len(iov, iovcnt), iovcnt, 0,
+	           ret);
+	return ret;
+}
+
+int dpoll_set_idle_timeout(int qd, unsigned timeout_ms)
+{
+	if (!qd_is_dpoll(qd) || qd_is_epoll(qd)) {
+		errno = EOPNOTSUPP;
+		return -1;
+	}
+	return dpoll_set_idle_timeout_impl(get_socket_fd(qd), timeout_ms);
+}
+
+int dpoll_set_priority(int dpollfd, int qd, enum dpoll_priority prio)
+{
+	assert(qd_is_dpoll(dpollfd));
+	if (!qd_is_dpoll(qd) || qd_is_epoll(qd)) {
+		errno = EBADF;
+		return -1;
+	}
+	if (prio < DPOLL_PRIO_DEFAULT || prio >= DPOLL_PRIO_COUNT) {
+		errno = EINVAL;
+		return -1;
+	}
+	return dpoll_set_priority_impl(get_epoll_fd(dpollfd), get_socket_fd(qd),
+	                               prio);
+}
+
+int dpoll_set_ready_budget(int dpollfd, enum dpoll_priority prio,
+                           unsigned budget)
+{
+	assert(qd_is_dpoll(dpollfd));
+	if (prio < 0 || prio >= DPOLL_PRIO_COUNT) {
+		errno = EINVAL;
+		return -1;
+	}
+	return dpoll_set_ready_budget_impl(get_epoll_fd(dpollfd), prio, budget);
+}
+
+int dpoll_get_socket_mem_usage(int qd, struct dpoll_mem_usage *usage)
+{
+	if (!qd_is_dpoll(qd) || qd_is_epoll(qd)) {
+		errno = EBADF;
+		return -1;
+	}
+	return dpoll_get_socket_mem_usage_impl(get_socket_fd(qd), usage);
+}
+
+int dpoll_get_listener_latency_histogram(int qd,
+                                         struct dpoll_latency_hist *hist)
+{
+	if (!qd_is_dpoll(qd) || qd_is_epoll(qd)) {
+		errno = EBADF;
+		return -1;
+	}
+	return dpoll_get_listener_latency_histogram_impl(get_socket_fd(qd),
+	                                                 hist);
+}
+
+bool dpoll_completion_enabled(int qd)
+{
+	return dpoll_completion_enabled_impl(qd);
+}
+
+int dpoll_post_pop(int dpollfd, int qd, void *data)
+{
+	assert(qd_is_epoll(dpollfd));
+	if (!dpoll_completion_enabled(qd)) {
+		errno = EBADF;
+		return -1;
+	}
+	const uint64_t t = trace_start();
+	const int ret = dpoll_post_pop_impl(get_epoll_fd(dpollfd), qd,
+	                                    get_socket_fd(qd), data);
+	trace_call(DPOLL_TR_POST_POP, t, qd, dpollfd, 0, 0, ret);
+	return ret;
+}
+
+ssize_t dpoll_post_push(int dpollfd, int qd, const struct iovec *iov,
+                        int iovcnt, void *data)
+{
+	assert(qd_is_epoll(dpollfd));
+	if (!dpoll_completion_enabled(qd)) {
+		errno = EBADF;
+		return -1;
+	}
+	const uint64_t t = trace_start();
+	const ssize_t ret = dpoll_post_push_impl(get_epoll_fd(dpollfd), qd,
+	                                         get_socket_fd(qd), iov, iovcnt,
+	                                         data);
+	trace_call(DPOLL_TR_POST_PUSH, t, qd, dpollfd, iovs_len(iov, iovcnt),
+	           iovcnt, ret);
+	return ret;
+}
+
+size_t dpoll_inflight(int dpollfd)
+{
+	assert(qd_is_epoll(dpollfd));
+	return dpoll_inflight_impl(get_epoll_fd(dpollfd));
+}
+
+int dpoll_reap(int dpollfd, struct dpoll_completion *comps, int max)
+{
+	assert(qd_is_epoll(dpollfd));
+	const uint64_t t = trace_start();
+	const int ret = dpoll_reap_impl(get_epoll_fd(dpollfd), comps, max);
+	trace_call(DPOLL_TR_REAP, t, -1, dpollfd, max, 0, ret);
+	return ret;
+}
+
+size_t dpoll_completion_read(struct dpoll_completion *comp, void *buf,
+                             size_t len)
+{
+	return op_read(comp->op, buf, len);
+}
+
+void dpoll_completion_release(struct dpoll_completion *comp)
+{
+	op_release(comp->op);
+	comp->op = NULL;
+}
+
+struct dpoll_doorbell *dpoll_doorbell_get(int dpollfd)
+{
+	assert(qd_is_epoll(dpollfd));
+	return dpoll_doorbell_get_impl(get_epoll_fd(dpollfd));
+}
+
+void dpoll_doorbell_put(struct dpoll_doorbell *db)
+{
+	doorbell_put(db);
+}
+
+int dpoll_doorbell_fd(const struct dpoll_doorbell *db)
+{
+	return db->efd;
+}
+
+void dpoll_doorbell_ring(struct dpoll_doorbell *db)
+{
+	// not traced, rings come from other threads
+	doorbell_ring(db);
 }
@@ -0,0 +1,289 @@
+#include "libos.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <demi/libos.h>
+#include <demi/sga.h>
+#include <demi/wait.h>
+
+#define MAX_QDS (1 << 20)
+/// results no wait asks for are given up on once this many are queued
+#define MAX_PENDING 4096
+
+struct op {
+	int qd;
+	demi_opcode_t opcode;
+};
+
+/// ops by qtoken - 1
+static struct op *ops = NULL;
+static size_t ops_len = 0;
+static size_t ops_cap = 0;
+/// indices of unused entries of `ops`
+static size_t *ops_free = NULL;
+static size_t ops_free_len = 0;
+
+/// replayed qd of each recorded one, -1 until they are tied
+static int *replayed_qd;
+/// recorded qd of each replayed one, -1 until they are tied
+static int *recorded_qd;
+static int next_qd = 0;
+
+/// results fed but not handed out yet, delivered ones are NULL
+static const struct dpoll_trace_rec **pending = NULL;
+static size_t pending_head = 0;
+static size_t pending_len = 0;
+static size_t pending_cap = 0;
+
+static struct libos_stats stats;
+
+void libos_init(void)
+{
+	replayed_qd = malloc(MAX_QDS * sizeof(replayed_qd[0]));
+	recorded_qd = malloc(MAX_QDS * sizeof(recorded_qd[0]));
+	assert(replayed_qd && recorded_qd);
+	for (int qd = 0; qd < MAX_QDS; ++qd)
+		replayed_qd[qd] = recorded_qd[qd] = -1;
+}
+
+static void pending_skip_delivered(void)
+{
+	while (pending_head < pending_len && !pending[pending_head])
+		++pending_head;
+	if (pending_head == pending_len)
+		pending_head = pending_len = 0;
+}
+
+void libos_feed(const struct dpoll_trace_rec *r)
+{
+	if (pending_len - pending_head >= MAX_PENDING) {
+		pending[pending_head] = NULL;
+		++stats.undelivered;
+		pending_skip_delivered();
+	}
+	if (pending_len == pending_cap) {
+		pending_cap = pending_cap ? 2 * pending_cap : MAX_PENDING;
+		pending = realloc(pending, pending_cap * sizeof(pending[0]));
+		assert(pending);
+	}
+	pending[pending_len++] = r;
+}
+
+void libos_stats(struct libos_stats *out)
+{
+	*out = stats;
+	for (size_t i = pending_head; i < pending_len; ++i)
+		out->undelivered += pending[i] != NULL;
+}
+
+static int new_qd(void)
+{
+	return next_qd < MAX_QDS ? next_qd++ : -1;
+}
+
+static demi_qtoken_t op_new(int qd, demi_opcode_t opcode)
+{
+	size_t i;
+	if (ops_free_len > 0) {
+		i = ops_free[--ops_free_len];
+	} else {
+		if (ops_len == ops_cap) {
+			ops_cap = ops_cap ? 2 * ops_cap : 1024;
+			ops = realloc(ops, ops_cap * sizeof(ops[0]));
+			ops_free = realloc(ops_free,
+			                   ops_cap * sizeof(ops_free[0]));
+			assert(ops && ops_free);
+		}
+		i = ops_len++;
+	}
+	ops[i] = (struct op){ .qd = qd, .opcode = opcode };
+	return i + 1;
+}
+
+static struct op *op_get(demi_qtoken_t qt)
+{
+	if (qt == 0 || qt > ops_len || ops[qt - 1].opcode == DEMI_OPC_INVALID)
+		return NULL;
+	return ops + qt - 1;
+}
+
+static void op_free(demi_qtoken_t qt)
+{
+	ops[qt - 1].opcode = DEMI_OPC_INVALID;
+	ops_free[ops_free_len++] = qt - 1;
+}
+
+/// a recorded qd seen for the first time goes with any replayed one which
+/// has not been tied yet. sockets are told apart by the order they get their
+/// results in, which is good enough as long as the replay does not diverge
+static bool matches(const struct dpoll_trace_rec *r, const struct op *op)
+{
+	const demi_opcode_t opcode = r->args[0];
+	if (opcode != DEMI_OPC_FAILED && opcode != op->opcode)
+		return false;
+	if (r->fd < 0 || r->fd >= MAX_QDS)
+		return false;
+	if (replayed_qd[r->fd] >= 0)
+		return replayed_qd[r->fd] == op->qd;
+	return recorded_qd[op->qd] < 0;
+}
+
+static void untie(int qd)
+{
+	if (recorded_qd[qd] >= 0)
+		replayed_qd[recorded_qd[qd]] = -1;
+	recorded_qd[qd] = -1;
+}
+
+static void complete(demi_qresult_t *qr_out, demi_qtoken_t qt,
+                     demi_opcode_t opcode, int err, size_t nbytes)
+{
+	const struct op *op = op_get(qt);
+	*qr_out = (demi_qresult_t){
+		.qr_opcode = opcode,
+		.qr_qd = op->qd,
+		.qr_qt = qt,
+		.qr_ret = opcode == DEMI_OPC_FAILED ? err : 0,
+	};
+	if (opcode == DEMI_OPC_POP) {
+		qr_out->qr_value.sga = demi_sgaalloc(nbytes);
+	} else if (opcode == DEMI_OPC_ACCEPT) {
+		qr_out->qr_value.ares.qd = new_qd();
+		qr_out->qr_value.ares.addr.sin_family = AF_INET;
+		if (qr_out->qr_value.ares.qd < 0) {
+			qr_out->qr_opcode = DEMI_OPC_FAILED;
+			qr_out->qr_ret = EMFILE;
+		}
+	}
+	op_free(qt);
+}
+
+static void deliver(demi_qresult_t *qr_out, size_t i, demi_qtoken_t qt)
+{
+	const struct dpoll_trace_rec *r = pending[i];
+	const int qd = op_get(qt)->qd;
+	recorded_qd[qd] = r->fd;
+	replayed_qd[r->fd] = qd;
+	complete(qr_out, qt, r->args[0], r->err, r->args[2]);
+	pending[i] = NULL;
+	pending_skip_delivered();
+	++stats.delivered;
+}
+
+int demi_init(const struct demi_args *args)
+{
+	return 0;
+}
+
+int demi_socket(int *sockqd_out, int domain, int type, int protocol)
+{
+	*sockqd_out = new_qd();
+	return *sockqd_out < 0 ? EMFILE : 0;
+}
+
+int demi_listen(int sockqd, int backlog)
+{
+	return 0;
+}
+
+int demi_bind(int sockqd, const struct sockaddr *addr, socklen_t size)
+{
+	return 0;
+}
+
+int demi_setsockopt(int qd, int level, int optname, const void *optval,
+                    socklen_t optlen)
+{
+	return 0;
+}
+
+int demi_accept(demi_qtoken_t *qt_out, int sockqd)
+{
+	*qt_out = op_new(sockqd, DEMI_OPC_ACCEPT);
+	return 0;
+}
+
+int demi_close(int qd)
+{
+	untie(qd);
+	return 0;
+}
+
+int demi_push(demi_qtoken_t *qt_out, int qd, const demi_sgarray_t *sga)
+{
+	*qt_out = op_new(qd, DEMI_OPC_PUSH);
+	return 0;
+}
+
+int demi_pop(demi_qtoken_t *qt_out, int qd)
+{
+	*qt_out = op_new(qd, DEMI_OPC_POP);
+	return 0;
+}
+
+demi_sgarray_t demi_sgaalloc(size_t size)
+{
+	demi_sgarray_t sga = { 0 };
+	void *buf = calloc(1, size ? size : 1);
+	if (!buf)
+		return sga;
+	sga.sga_buf = buf;
+	sga.sga_numsegs = 1;
+	sga.sga_segs[0].sgaseg_buf = buf;
+	sga.sga_segs[0].sgaseg_len = size;
+	return sga;
+}
+
+int demi_sgafree(demi_sgarray_t *sga)
+{
+	free(sga->sga_buf);
+	return 0;
+}
+
+/// the replay never blocks: a wait without a timeout is only used to collect
+/// an op while closing, so if the trace has no result for it, the push is
+/// taken to be done and anything else to be cancelled
+int demi_wait(demi_qresult_t *qr_out, demi_qtoken_t qt,
+              const struct timespec *timeout)
+{
+	const struct op *op = op_get(qt);
+	if (!op)
+		return EINVAL;
+	for (size_t i = pending_head; i < pending_len; ++i) {
+		if (pending[i] && matches(pending[i], op)) {
+			deliver(qr_out, i, qt);
+			return 0;
+		}
+	}
+	if (timeout)
+		return ETIMEDOUT;
+	++stats.made_up;
+	if (op->opcode == DEMI_OPC_PUSH)
+		complete(qr_out, qt, DEMI_OPC_PUSH, 0, 0);
+	else
+		complete(qr_out, qt, DEMI_OPC_FAILED, ECANCELED, 0);
+	return 0;
+}
+
+int demi_wait_any(demi_qresult_t *qr_out, int *ready_offset,
+                  const demi_qtoken_t qts[], int num_qts,
+                  const struct timespec *timeout)
+{
+	for (size_t i = pending_head; i < pending_len; ++i) {
+		if (!pending[i])
+			continue;
+		for (int j = 0; j < num_qts; ++j) {
+			const struct op *op = op_get(qts[j]);
+			if (op && matches(pending[i], op)) {
+				*ready_offset = j;
+				deliver(qr_out, i, qts[j]);
+				return 0;
+			}
+		}
+	}
+	return ETIMEDOUT;
+}
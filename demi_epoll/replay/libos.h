@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "trace.h"
+
+/*
+ * stand-in for the demikernel libos, which hands the shim the results of the
+ * recorded run instead of going to the network
+ *
+ * the replay executable exports the `demi_*` functions the shim calls, so they
+ * take precedence over the ones of libdemikernel. qds and qtokens are made up,
+ * a recorded qd is tied to a replayed one when its first result is handed
+ * out. written data is dropped, popped data is zeroed
+ */
+
+struct libos_stats {
+	/// recorded results handed to the shim
+	size_t delivered;
+	/// recorded results no wait of the replay asked for
+	size_t undelivered;
+	/// blocking waits the trace had no result for
+	size_t made_up;
+};
+
+void libos_init(void);
+
+/// queues a `DPOLL_TR_DEMI_RESULT` record, the waits of the call it was
+/// recorded during can then take it
+void libos_feed(const struct dpoll_trace_rec *r);
+
+void libos_stats(struct libos_stats *stats);
@@ -0,0 +1,340 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <arpa/inet.h>
+
+#include <demi/types.h>
+
+#include "completion.h"
+#include "dpoll.h"
+#include "libos.h"
+#include "sockets.h"
+#include "trace.h"
+
+/*
+ * reads a trace written with DEMI_EPOLL_TRACE and either summarises it, or
+ * issues the recorded calls against the shim again, one after the other, and
+ * compares both timings
+ *
+ * the shim is not run against a real libos, the demikernel results of the
+ * recorded run are handed back to it instead, see libos.h. waits never block,
+ * epoll_pwait is replayed with a zero timeout and gets whatever the recorded
+ * call got. written data is zeroed and the recorded fds are mapped to the ones
+ * returned during the replay. traces of the completion interface need
+ * DEMI_EPOLL_COMPLETION=1 for the replay as well
+ */
+
+#define MAX_FDS (1 << 20)
+#define MAX_EVENTS 1024
+
+static const char *const call_names[DPOLL_TR_COUNT] = {
+	[DPOLL_TR_EPOLL_CREATE] = "epoll_create",
+	[DPOLL_TR_EPOLL_CTL] = "epoll_ctl",
+	[DPOLL_TR_EPOLL_PWAIT] = "epoll_pwait",
+	[DPOLL_TR_SOCKET] = "socket",
+	[DPOLL_TR_BIND] = "bind",
+	[DPOLL_TR_CONNECT] = "connect",
+	[DPOLL_TR_ACCEPT] = "accept",
+	[DPOLL_TR_LISTEN] = "listen",
+	[DPOLL_TR_CLOSE] = "close",
+	[DPOLL_TR_READ] = "read",
+	[DPOLL_TR_WRITE] = "write",
+	[DPOLL_TR_POST_POP] = "post_pop",
+	[DPOLL_TR_POST_PUSH] = "post_push",
+	[DPOLL_TR_REAP] = "reap",
+	[DPOLL_TR_DEMI_RESULT] = "demi_result",
+};
+
+struct durations {
+	uint64_t *ns;
+	size_t len;
+};
+
+static struct dpoll_trace_rec *load(const char *path, size_t *count)
+{
+	FILE *f = fopen(path, "rb");
+	if (!f) {
+		perror(path);
+		exit(1);
+	}
+	struct dpoll_trace_header h;
+	if (fread(&h, sizeof(h), 1, f) != 1 || h.magic != DPOLL_TRACE_MAGIC ||
+	    h.version != DPOLL_TRACE_VERSION ||
+	    h.rec_size != sizeof(struct dpoll_trace_rec)) {
+		fprintf(stderr, "%s is not a dpoll trace\n", path);
+		exit(1);
+	}
+	if (h.dropped)
+		printf("%lu records were dropped while tracing\n", h.dropped);
+
+	struct dpoll_trace_rec *recs = calloc(h.count, sizeof(recs[0]));
+	assert(recs || h.count == 0);
+	if (fread(recs, sizeof(recs[0]), h.count, f) != h.count) {
+		fprintf(stderr, "%s is truncated\n", path);
+		exit(1);
+	}
+	fclose(f);
+	*count = h.count;
+	return recs;
+}
+
+static void durations_add(struct durations *d, uint64_t ns)
+{
+	uint64_t *tmp = realloc(d->ns, (d->len + 1) * sizeof(d->ns[0]));
+	assert(tmp);
+	d->ns = tmp;
+	d->ns[d->len++] = ns;
+}
+
+static int cmp_u64(const void *l, const void *r)
+{
+	const uint64_t a = *(const uint64_t *)l, b = *(const uint64_t *)r;
+	return (a > b) - (a < b);
+}
+
+static uint64_t percentile(const struct durations *d, unsigned p)
+{
+	return d->ns[(d->len - 1) * p / 100];
+}
+
+static void print_durations(const char *title, struct durations *d)
+{
+	printf("%s:\n", title);
+	printf("  %-14s %10s %10s %10s %10s\n", "call", "count", "p50 us",
+	       "p99 us", "max us");
+	for (int c = 0; c < DPOLL_TR_COUNT; ++c) {
+		if (d[c].len == 0 || c == DPOLL_TR_DEMI_RESULT)
+			continue;
+		qsort(d[c].ns, d[c].len, sizeof(d[c].ns[0]), cmp_u64);
+		printf("  %-14s %10zu %10.1f %10.1f %10.1f\n", call_names[c],
+		       d[c].len, percentile(&d[c], 50) / 1e3,
+		       percentile(&d[c], 99) / 1e3,
+		       d[c].ns[d[c].len - 1] / 1e3);
+	}
+}
+
+static void stats(const struct dpoll_trace_rec *recs, size_t count)
+{
+	struct durations d[DPOLL_TR_COUNT] = { 0 };
+	size_t results[DEMI_OPC_FAILED + 1] = { 0 };
+	size_t failed = 0;
+	for (size_t i = 0; i < count; ++i) {
+		const struct dpoll_trace_rec *r = recs + i;
+		if (r->call >= DPOLL_TR_COUNT)
+			continue;
+		if (r->call == DPOLL_TR_DEMI_RESULT) {
+			if (r->args[0] >= 0 && r->args[0] <= DEMI_OPC_FAILED)
+				++results[r->args[0]];
+			continue;
+		}
+		if (r->ret < 0 && r->err != EWOULDBLOCK)
+			++failed;
+		durations_add(&d[r->call], r->end - r->start);
+	}
+	if (count > 0)
+		printf("%zu records over %.3f s, %zu calls failed\n", count,
+		       (recs[count - 1].end - recs[0].start) / 1e9, failed);
+	printf("demikernel results: %zu pushes, %zu pops, %zu accepts, %zu failed\n",
+	       results[DEMI_OPC_PUSH], results[DEMI_OPC_POP],
+	       results[DEMI_OPC_ACCEPT], results[DEMI_OPC_FAILED]);
+	print_durations("recorded", d);
+}
+
+/// live fd for each recorded one, -1 if the replay did not create it
+static int *fd_map;
+
+static int map_fd(int fd)
+{
+	if (fd < 0 || fd >= MAX_FDS)
+		return -1;
+	return fd_map[fd];
+}
+
+static void set_fd(int recorded, int live)
+{
+	if (recorded >= 0 && recorded < MAX_FDS)
+		fd_map[recorded] = live >= 0 ? live : -1;
+}
+
+/// false if the record uses an fd which the replay did not create, e.g. one
+/// opened before tracing started. passing its number on would hit whatever
+/// this process has open under it
+static bool fds_mapped(const struct dpoll_trace_rec *r)
+{
+	switch (r->call) {
+	case DPOLL_TR_EPOLL_CREATE:
+	case DPOLL_TR_SOCKET:
+		return true;
+	case DPOLL_TR_EPOLL_CTL:
+		return map_fd(r->fd) >= 0 && map_fd(r->args[1]) >= 0;
+	case DPOLL_TR_POST_POP:
+	case DPOLL_TR_POST_PUSH:
+		return map_fd(r->fd) >= 0 && map_fd(r->args[0]) >= 0;
+	case DPOLL_TR_REAP:
+		return map_fd(r->args[0]) >= 0;
+	default:
+		return map_fd(r->fd) >= 0;
+	}
+}
+
+static int64_t issue(const struct dpoll_trace_rec *r, char *buf, size_t len)
+{
+	const int fd = map_fd(r->fd);
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_addr.s_addr = htonl(r->args[0]),
+		.sin_port = htons(r->args[1]),
+	};
+	struct epoll_event evs[MAX_EVENTS];
+	struct dpoll_completion comps[MAX_EVENTS];
+	struct iovec iov = { .iov_base = buf, .iov_len = 0 };
+	int64_t ret;
+
+	switch (r->call) {
+	case DPOLL_TR_EPOLL_CREATE:
+		ret = dpoll_epoll_create(r->args[0]);
+		break;
+	case DPOLL_TR_EPOLL_CTL: {
+		struct epoll_event ev = {
+			.events = r->args[2],
+			.data.fd = map_fd(r->args[1]),
+		};
+		ret = dpoll_epoll_ctl(fd, r->args[0], map_fd(r->args[1]), &ev);
+		break;
+	}
+	case DPOLL_TR_EPOLL_PWAIT:
+		ret = dpoll_epoll_pwait(fd, evs,
+		                        r->args[0] < MAX_EVENTS ? r->args[0] :
+		                        MAX_EVENTS,
+		                        0, NULL);
+		break;
+	case DPOLL_TR_SOCKET:
+		ret = dpoll_socket(r->args[0], r->args[1], r->args[2]);
+		break;
+	case DPOLL_TR_BIND:
+		ret = dpoll_bind(fd, (void *)&addr, sizeof(addr));
+		break;
+	case DPOLL_TR_CONNECT:
+		ret = dpoll_connect(fd, (void *)&addr, sizeof(addr));
+		break;
+	case DPOLL_TR_ACCEPT:
+		ret = dpoll_accept(fd, NULL, NULL);
+		break;
+	case DPOLL_TR_LISTEN:
+		ret = dpoll_listen(fd, r->args[0]);
+		break;
+	case DPOLL_TR_CLOSE:
+		ret = dpoll_close(fd);
+		break;
+	case DPOLL_TR_READ:
+		ret = dpoll_read(fd, buf, r->args[0] < len ? r->args[0] : len);
+		break;
+	case DPOLL_TR_WRITE:
+		ret = dpoll_write(fd, buf, r->args[0] < len ? r->args[0] : len);
+		break;
+	case DPOLL_TR_POST_POP:
+		ret = dpoll_post_pop(map_fd(r->args[0]), fd, NULL);
+		break;
+	case DPOLL_TR_POST_PUSH:
+		iov.iov_len = r->args[1] < len ? r->args[1] : len;
+		ret = dpoll_post_push(map_fd(r->args[0]), fd, &iov, 1, NULL);
+		break;
+	case DPOLL_TR_REAP:
+		ret = dpoll_reap(map_fd(r->args[0]), comps,
+		                 r->args[1] < MAX_EVENTS ? r->args[1] :
+		                 MAX_EVENTS);
+		for (int64_t i = 0; i < ret; ++i)
+			dpoll_completion_release(comps + i);
+		break;
+	default:
+		errno = EINVAL;
+		return -1;
+	}
+	return ret;
+}
+
+static uint64_t now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void run(const struct dpoll_trace_rec *recs, size_t count)
+{
+	const size_t len = 1 << 20;
+	char *buf = calloc(1, len);
+	fd_map = malloc(MAX_FDS * sizeof(fd_map[0]));
+	assert(buf && fd_map);
+	for (int fd = 0; fd < MAX_FDS; ++fd)
+		fd_map[fd] = -1;
+
+	libos_init();
+	dpoll_init();
+	struct durations d[DPOLL_TR_COUNT] = { 0 };
+	size_t diverged = 0;
+	size_t skipped = 0;
+	const uint64_t start = now();
+	for (size_t i = 0; i < count; ++i) {
+		const struct dpoll_trace_rec *r = recs + i;
+		if (r->call >= DPOLL_TR_COUNT)
+			continue;
+		// results are recorded before the call they were handed to
+		if (r->call == DPOLL_TR_DEMI_RESULT) {
+			libos_feed(r);
+			continue;
+		}
+		if (!fds_mapped(r)) {
+			++skipped;
+			printf("record %zu (%s on %d): skipped, uses an fd not created by the replay\n",
+			       i, call_names[r->call], r->fd);
+			continue;
+		}
+		const uint64_t t = now();
+		const int64_t ret = issue(r, buf, len);
+		durations_add(&d[r->call], now() - t);
+
+		// fds only have to line up, their values can differ
+		if (r->call == DPOLL_TR_EPOLL_CREATE ||
+		    r->call == DPOLL_TR_SOCKET || r->call == DPOLL_TR_ACCEPT)
+			set_fd(r->ret, ret);
+		else if (r->call == DPOLL_TR_CLOSE)
+			set_fd(r->fd, -1);
+		if ((ret < 0) != (r->ret < 0) ||
+		    (ret < 0 && errno != r->err)) {
+			++diverged;
+			printf("record %zu (%s on %d): returned %ld, recorded %ld\n",
+			       i, call_names[r->call], r->fd, ret, r->ret);
+		}
+	}
+	printf("replayed %zu records in %.3f s, %zu diverged, %zu skipped\n",
+	       count, (now() - start) / 1e9, diverged, skipped);
+	struct libos_stats ls;
+	libos_stats(&ls);
+	printf("demikernel results: %zu handed back, %zu never waited for, %zu made up\n",
+	       ls.delivered, ls.undelivered, ls.made_up);
+	print_durations("replayed", d);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc != 3 ||
+	    (strcmp(argv[1], "stats") != 0 && strcmp(argv[1], "run") != 0)) {
+		fprintf(stderr, "usage: %s stats|run <trace>\n", argv[0]);
+		return 1;
+	}
+
+	size_t count;
+	struct dpoll_trace_rec *recs = load(argv[2], &count);
+	stats(recs, count);
+	if (strcmp(argv[1], "run") == 0)
+		run(recs, count);
+	return 0;
+}
@@ -6,13 +6,20 @@
 #include "dpoll.h"
 #include "sockets.h"
 #include "log.h"
+#include "tests.h"
 #include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define spin(func, tmp) do { tmp = func; if (tmp >= 0) break; if  (tmp < 0 && errno == EWOULDBLOCK) continue; perror(#func); abort(); } while (1);
 
-int main(void)
+int main(int argc, char **argv)
 {
+	if (argc > 1 && strcmp(argv[1], "reuseport") == 0)
+		return test_reuseport(argv[0]);
+	if (argc > 2 && strcmp(argv[1], "reuseport-worker") == 0)
+		return reuseport_worker(argv[2]);
+
 	dpoll_init();
 
 	int s = dpoll_socket(AF_INET, SOCK_STREAM, 0);
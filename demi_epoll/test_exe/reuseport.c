@@ -0,0 +1,104 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include "dpoll.h"
+#include "sockets.h"
+#include "tests.h"
+
+/// unlike assert, also checks in release builds
+#define check(cond) do { if (!(cond)) { perror(#cond); abort(); } } while (0)
+
+#define REUSEPORT_PORT "2138"
+#define REUSEPORT_WORKERS 2
+
+struct worker {
+	pid_t pid;
+	/// written by the worker once it listens, closed by it on failure
+	int ready;
+	/// closed to stop the worker
+	int stop;
+};
+
+static void worker_start(struct worker *w, const char *self)
+{
+	int ready[2], stop[2];
+	check(pipe(ready) == 0);
+	check(pipe(stop) == 0);
+
+	w->pid = fork();
+	check(w->pid >= 0);
+	if (w->pid == 0) {
+		dup2(stop[0], STDIN_FILENO);
+		dup2(ready[1], STDOUT_FILENO);
+		close(ready[0]);
+		close(ready[1]);
+		close(stop[0]);
+		close(stop[1]);
+		setenv("DEMI_EPOLL_REUSEPORT", "1", 1);
+		execl(self, self, "reuseport-worker", REUSEPORT_PORT, NULL);
+		perror("execl");
+		_exit(127);
+	}
+	close(ready[1]);
+	close(stop[0]);
+	w->ready = ready[0];
+	w->stop = stop[1];
+}
+
+int test_reuseport(const char *self)
+{
+	struct worker workers[REUSEPORT_WORKERS];
+
+	// the second worker only starts once the first one listens, so it has
+	// to share the port to listen as well
+	for (int i = 0; i < REUSEPORT_WORKERS; i++) {
+		worker_start(&workers[i], self);
+		char c = 0;
+		check(read(workers[i].ready, &c, 1) == 1 && c == 'y');
+		printf("worker %d listens on %s\n", i, REUSEPORT_PORT);
+	}
+
+	for (int i = 0; i < REUSEPORT_WORKERS; i++) {
+		close(workers[i].stop);
+		int status;
+		check(waitpid(workers[i].pid, &status, 0) == workers[i].pid);
+		check(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+		close(workers[i].ready);
+	}
+	printf("reuseport done :)\n");
+	return 0;
+}
+
+int reuseport_worker(const char *port)
+{
+	dpoll_init();
+
+	int s = dpoll_socket(AF_INET, SOCK_STREAM, 0);
+	check(s > -1);
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_addr.s_addr = htonl(0x7f000001),
+		.sin_port = htons(atoi(port)),
+	};
+	// bind is deferred in reuseport mode, listen reports a port in use
+	check(dpoll_bind(s, (void *)&addr, sizeof(addr)) == 0);
+	if (dpoll_listen(s, 16)) {
+		perror("dpoll_listen");
+		return 1;
+	}
+	check(write(STDOUT_FILENO, "y", 1) == 1);
+
+	char c;
+	ssize_t n;
+	do
+		n = read(STDIN_FILENO, &c, 1);
+	while (n > 0 || (n < 0 && errno == EINTR));
+	dpoll_close(s);
+	return 0;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+/// starts two worker processes with `DEMI_EPOLL_REUSEPORT=1`, which both have
+/// to listen on the same port
+int test_reuseport(const char *self);
+/// the worker of test_reuseport, listens on `port` until stdin is closed
+int reuseport_worker(const char *port);
@@ -604,6 +604,7 @@ UV_EXTERN int uv_tcp_keepalive(uv_tcp_t* handle,
                                int enable,
                                unsigned int delay);
 UV_EXTERN int uv_tcp_simultaneous_accepts(uv_tcp_t* handle, int enable);
+UV_EXTERN int uv_tcp_idle_timeout(uv_tcp_t* handle, unsigned int timeout);
 
 enum uv_tcp_flags {
   /* Used with uv_tcp_bind, when an IPv6 address is used. */
@@ -1423,7 +1424,8 @@ typedef enum {
   UV_FS_CLOSEDIR,
   UV_FS_STATFS,
   UV_FS_MKSTEMP,
-  UV_FS_LUTIME
+  UV_FS_LUTIME,
+  UV_FS_BATCH
 } uv_fs_type;
 
 struct uv_dir_s {
@@ -1603,6 +1605,19 @@ UV_EXTERN int uv_fs_lutime(uv_loop_t* loop,
                            double atime,
                            double mtime,
                            uv_fs_cb cb);
+/*
+ * Runs `reqs` one after another in a single threadpool work item and calls
+ * `cb` once when all of them are done. Each request is prepared by calling
+ * its uv_fs_*() function with a NULL loop and a non-NULL callback, which
+ * copies the arguments but doesn't run anything. Results end up in the
+ * requests themselves, their callbacks are never called and each of them
+ * still needs uv_fs_req_cleanup().
+ */
+UV_EXTERN int uv_fs_batch(uv_loop_t* loop,
+                          uv_fs_t* req,
+                          uv_fs_t reqs[],
+                          unsigned int nreqs,
+                          uv_fs_cb cb);
 UV_EXTERN int uv_fs_lstat(uv_loop_t* loop,
                           uv_fs_t* req,
                           const char* path,
@@ -38,6 +38,7 @@
 #include <sys/eventfd.h>
 #endif
 
+#include <demi_epoll/dpoll.h>
 #include <demi_epoll/sockets.h>
 
 #if UV__KQUEUE_EVFILT_USER
@@ -171,6 +172,9 @@ static void uv__async_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
 
 #if UV__KQUEUE_EVFILT_USER
   for (;!kqueue_evfilt_user_support;) {
+#elif defined(__linux__)
+  /* The doorbell is cleared by dpoll when it reports it. */
+  for (;uv__get_internal_fields(loop)->doorbell == NULL;) {
 #else
   for (;;) {
 #endif
@@ -213,6 +217,9 @@ static void uv__async_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
 
 
 static void uv__async_send(uv_loop_t* loop) {
+#if defined(__linux__)
+  struct dpoll_doorbell* doorbell;
+#endif
   const void* buf;
   ssize_t len;
   int fd;
@@ -223,6 +230,13 @@ static void uv__async_send(uv_loop_t* loop) {
   fd = loop->async_wfd;
 
 #if defined(__linux__)
+  /* Only a store while the loop is polling, no syscall on either side. */
+  doorbell = uv__get_internal_fields(loop)->doorbell;
+  if (doorbell != NULL) {
+    dpoll_doorbell_ring(doorbell);
+    return;
+  }
+
   if (fd == -1) {
     static const uint64_t val = 1;
     buf = &val;
@@ -258,6 +272,9 @@ static void uv__async_send(uv_loop_t* loop) {
 
 
 static int uv__async_start(uv_loop_t* loop) {
+#ifdef __linux__
+  struct dpoll_doorbell* doorbell;
+#endif
   int pipefd[2];
   int err;
 #if UV__KQUEUE_EVFILT_USER
@@ -268,9 +285,15 @@ static int uv__async_start(uv_loop_t* loop) {
     return 0;
 
 #ifdef __linux__
-  err = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
-  if (err < 0)
-    return UV__ERR(errno);
+  doorbell = dpoll_doorbell_get(loop->backend_fd);
+  if (doorbell != NULL) {
+    uv__get_internal_fields(loop)->doorbell = doorbell;
+    err = dpoll_doorbell_fd(doorbell);
+  } else {
+    err = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (err < 0)
+      return UV__ERR(errno);
+  }
 
   pipefd[0] = err;
   pipefd[1] = -1;
@@ -325,6 +348,26 @@ static int uv__async_start(uv_loop_t* loop) {
 }
 
 
+static void uv__async_close_fd(uv_loop_t* loop) {
+#ifdef __linux__
+  uv__loop_internal_fields_t* lfields;
+
+  /* The doorbell's fd belongs to dpoll, it is closed with the last reference.
+   * The doorbell may outlive the backend fd, which is closed first. */
+  lfields = uv__get_internal_fields(loop);
+  if (lfields->doorbell != NULL) {
+    dpoll_doorbell_put(lfields->doorbell);
+    lfields->doorbell = NULL;
+    loop->async_io_watcher.fd = -1;
+    return;
+  }
+#endif
+
+  uv__close(loop->async_io_watcher.fd);
+  loop->async_io_watcher.fd = -1;
+}
+
+
 void uv__async_stop(uv_loop_t* loop) {
   struct uv__queue queue;
   struct uv__queue* q;
@@ -354,8 +397,7 @@ void uv__async_stop(uv_loop_t* loop) {
   }
 
   uv__io_stop(loop, &loop->async_io_watcher, POLLIN);
-  uv__close(loop->async_io_watcher.fd);
-  loop->async_io_watcher.fd = -1;
+  uv__async_close_fd(loop);
 }
 
 
@@ -394,8 +436,7 @@ int uv__async_fork(uv_loop_t* loop) {
   }
 
   uv__io_stop(loop, &loop->async_io_watcher, POLLIN);
-  uv__close(loop->async_io_watcher.fd);
-  loop->async_io_watcher.fd = -1;
+  uv__async_close_fd(loop);
 
   return uv__async_start(loop);
 }
@@ -0,0 +1,105 @@
+/* Copyright libuv project contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Completion based I/O for streams backed by demikernel sockets.
+ *
+ * Instead of waiting for the emulated POLLIN/POLLOUT readiness of a dpoll
+ * socket and then reading or writing it, uv_read_start() posts a pop and
+ * uv_write() posts a push of the request's buffers.  Their completions are
+ * collected by uv__demi_poll() right after the backend wait in uv__io_poll()
+ * and passed straight to the stream.
+ *
+ * Only used when the shim runs in completion mode (DEMI_EPOLL_COMPLETION=1),
+ * listening sockets keep using readiness.
+ */
+
+#include "uv.h"
+#include "internal.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <sys/uio.h>
+
+#include <demi_epoll/completion.h>
+
+/* Same as the number of epoll events handled per uv__io_poll() iteration. */
+#define UV__DEMI_MAX_COMPLETIONS 1024
+
+
+int uv__demi_stream(const uv_stream_t* stream) {
+  return stream->type == UV_TCP &&
+         dpoll_completion_enabled(uv__stream_fd(stream));
+}
+
+
+int uv__demi_read_start(uv_stream_t* stream) {
+  if (dpoll_post_pop(stream->loop->backend_fd, uv__stream_fd(stream), stream))
+    /* A pop is still outstanding from before uv_read_stop(), keep using it. */
+    if (errno != EALREADY)
+      return UV__ERR(errno);
+
+  return 0;
+}
+
+
+int uv__demi_write(uv_stream_t* stream, uv_write_t* req) {
+  ssize_t n;
+
+  n = dpoll_post_push(stream->loop->backend_fd,
+                      uv__stream_fd(stream),
+                      (const struct iovec*) (req->bufs + req->write_index),
+                      req->nbufs - req->write_index,
+                      req);
+  if (n < 0)
+    return UV__ERR(errno);
+
+  return 0;
+}
+
+
+int uv__demi_poll(uv_loop_t* loop) {
+  struct dpoll_completion comps[UV__DEMI_MAX_COMPLETIONS];
+  struct dpoll_completion* c;
+  uv_write_t* req;
+  ssize_t res;
+  int n;
+  int i;
+
+  n = dpoll_reap(loop->backend_fd, comps, ARRAY_SIZE(comps));
+
+  for (i = 0; i < n; i++) {
+    c = comps + i;
+
+    if (c->opcode == DPOLL_OPC_POP) {
+      uv__metrics_update_idle_time(loop);
+      uv__stream_demi_read(c->data, c);
+      continue;
+    }
+
+    req = c->data;
+    res = c->res;
+    dpoll_completion_release(c);
+    uv__metrics_update_idle_time(loop);
+    uv__stream_demi_write(req, res);
+  }
+
+  return n;
+}
@@ -139,6 +139,8 @@ extern char *mkdtemp(char *template); /* See issue #740 on AIX < 7 */
 #define POST                                                                  \
   do {                                                                        \
     if (cb != NULL) {                                                         \
+      if (loop == NULL)                                                       \
+        return 0;  /* Prepared for uv_fs_batch(). */                          \
       uv__req_register(loop);                                                 \
       uv__work_submit(loop,                                                   \
                       &req->work_req,                                         \
@@ -1692,6 +1694,24 @@ static ssize_t uv__fs_write_all(uv_fs_t* req) {
 }
 
 
+static void uv__fs_work(struct uv__work* w);
+
+
+static ssize_t uv__fs_batch(uv_fs_t* req) {
+  uv_fs_t* reqs;
+  unsigned int i;
+
+  reqs = req->ptr;
+  for (i = 0; i < req->nbufs; i++) {
+    /* Needed by uv__fs_open() and friends for the cloexec lock. */
+    reqs[i].loop = req->loop;
+    uv__fs_work(&reqs[i].work_req);
+  }
+
+  return 0;
+}
+
+
 static void uv__fs_work(struct uv__work* w) {
   int retry_on_eintr;
   uv_fs_t* req;
@@ -1699,7 +1719,8 @@ static void uv__fs_work(struct uv__work* w) {
 
   req = container_of(w, uv_fs_t, work_req);
   retry_on_eintr = !(req->fs_type == UV_FS_CLOSE ||
-                     req->fs_type == UV_FS_READ);
+                     req->fs_type == UV_FS_READ ||
+                     req->fs_type == UV_FS_BATCH);
 
   do {
     errno = 0;
@@ -1711,6 +1732,7 @@ static void uv__fs_work(struct uv__work* w) {
 
     switch (req->fs_type) {
     X(ACCESS, access(req->path, req->flags));
+    X(BATCH, uv__fs_batch(req));
     X(CHMOD, chmod(req->path, req->mode));
     X(CHOWN, chown(req->path, req->uid, req->gid));
     X(CLOSE, uv__fs_close(req->file));
@@ -1830,7 +1852,7 @@ int uv_fs_chown(uv_loop_t* loop,
 int uv_fs_close(uv_loop_t* loop, uv_fs_t* req, uv_file file, uv_fs_cb cb) {
   INIT(CLOSE);
   req->file = file;
-  if (cb != NULL)
+  if (cb != NULL && loop != NULL)
     if (uv__iou_fs_close(loop, req))
       return 0;
   POST;
@@ -1880,7 +1902,7 @@ int uv_fs_lchown(uv_loop_t* loop,
 int uv_fs_fdatasync(uv_loop_t* loop, uv_fs_t* req, uv_file file, uv_fs_cb cb) {
   INIT(FDATASYNC);
   req->file = file;
-  if (cb != NULL)
+  if (cb != NULL && loop != NULL)
     if (uv__iou_fs_fsync_or_fdatasync(loop, req, /* IORING_FSYNC_DATASYNC */ 1))
       return 0;
   POST;
@@ -1890,7 +1912,7 @@ int uv_fs_fdatasync(uv_loop_t* loop, uv_fs_t* req, uv_file file, uv_fs_cb cb) {
 int uv_fs_fstat(uv_loop_t* loop, uv_fs_t* req, uv_file file, uv_fs_cb cb) {
   INIT(FSTAT);
   req->file = file;
-  if (cb != NULL)
+  if (cb != NULL && loop != NULL)
     if (uv__iou_fs_statx(loop, req, /* is_fstat */ 1, /* is_lstat */ 0))
       return 0;
   POST;
@@ -1900,7 +1922,7 @@ int uv_fs_fstat(uv_loop_t* loop, uv_fs_t* req, uv_file file, uv_fs_cb cb) {
 int uv_fs_fsync(uv_loop_t* loop, uv_fs_t* req, uv_file file, uv_fs_cb cb) {
   INIT(FSYNC);
   req->file = file;
-  if (cb != NULL)
+  if (cb != NULL && loop != NULL)
     if (uv__iou_fs_fsync_or_fdatasync(loop, req, /* no flags */ 0))
       return 0;
   POST;
@@ -1915,7 +1937,7 @@ int uv_fs_ftruncate(uv_loop_t* loop,
   INIT(FTRUNCATE);
   req->file = file;
   req->off = off;
-  if (cb != NULL)
+  if (cb != NULL && loop != NULL)
     if (uv__iou_fs_ftruncate(loop, req))
       return 0;
   POST;
@@ -1949,10 +1971,32 @@ int uv_fs_lutime(uv_loop_t* loop,
 }
 
 
+int uv_fs_batch(uv_loop_t* loop,
+                uv_fs_t* req,
+                uv_fs_t reqs[],
+                unsigned int nreqs,
+                uv_fs_cb cb) {
+  unsigned int i;
+
+  INIT(BATCH);
+
+  if (loop == NULL || cb == NULL || (reqs == NULL && nreqs > 0))
+    return UV_EINVAL;
+
+  for (i = 0; i < nreqs; i++)
+    if (reqs[i].type != UV_FS || reqs[i].loop != NULL || reqs[i].cb == NULL)
+      return UV_EINVAL;
+
+  req->ptr = reqs;
+  req->nbufs = nreqs;
+  POST;
+}
+
+
 int uv_fs_lstat(uv_loop_t* loop, uv_fs_t* req, const char* path, uv_fs_cb cb) {
   INIT(LSTAT);
   PATH;
-  if (cb != NULL)
+  if (cb != NULL && loop != NULL)
     if (uv__iou_fs_statx(loop, req, /* is_fstat */ 0, /* is_lstat */ 1))
       return 0;
   POST;
@@ -1966,7 +2010,7 @@ int uv_fs_link(uv_loop_t* loop,
                uv_fs_cb cb) {
   INIT(LINK);
   PATH2;
-  if (cb != NULL)
+  if (cb != NULL && loop != NULL)
     if (uv__iou_fs_link(loop, req))
       return 0;
   POST;
@@ -1981,7 +2025,7 @@ int uv_fs_mkdir(uv_loop_t* loop,
   INIT(MKDIR);
   PATH;
   req->mode = mode;
-  if (cb != NULL)
+  if (cb != NULL && loop != NULL)
     if (uv__iou_fs_mkdir(loop, req))
       return 0;
   POST;
@@ -2022,7 +2066,7 @@ int uv_fs_open(uv_loop_t* loop,
   PATH;
   req->flags = flags;
   req->mode = mode;
-  if (cb != NULL)
+  if (cb != NULL && loop != NULL)
     if (uv__iou_fs_open(loop, req))
       return 0;
   POST;
@@ -2057,8 +2101,9 @@ int uv_fs_read(uv_loop_t* loop, uv_fs_t* req,
 
   memcpy(req->bufs, bufs, nbufs * sizeof(*bufs));
 
-  if (uv__iou_fs_read_or_write(loop, req, /* is_read */ 1))
-    return 0;
+  if (loop != NULL)
+    if (uv__iou_fs_read_or_write(loop, req, /* is_read */ 1))
+      return 0;
 
 post:
   POST;
@@ -2138,7 +2183,7 @@ int uv_fs_rename(uv_loop_t* loop,
                  uv_fs_cb cb) {
   INIT(RENAME);
   PATH2;
-  if (cb != NULL)
+  if (cb != NULL && loop != NULL)
     if (uv__iou_fs_rename(loop, req))
       return 0;
   POST;
@@ -2171,7 +2216,7 @@ int uv_fs_sendfile(uv_loop_t* loop,
 int uv_fs_stat(uv_loop_t* loop, uv_fs_t* req, const char* path, uv_fs_cb cb) {
   INIT(STAT);
   PATH;
-  if (cb != NULL)
+  if (cb != NULL && loop != NULL)
     if (uv__iou_fs_statx(loop, req, /* is_fstat */ 0, /* is_lstat */ 0))
       return 0;
   POST;
@@ -2187,7 +2232,7 @@ int uv_fs_symlink(uv_loop_t* loop,
   INIT(SYMLINK);
   PATH2;
   req->flags = flags;
-  if (cb != NULL)
+  if (cb != NULL && loop != NULL)
     if (uv__iou_fs_symlink(loop, req))
       return 0;
   POST;
@@ -2197,7 +2242,7 @@ int uv_fs_symlink(uv_loop_t* loop,
 int uv_fs_unlink(uv_loop_t* loop, uv_fs_t* req, const char* path, uv_fs_cb cb) {
   INIT(UNLINK);
   PATH;
-  if (cb != NULL)
+  if (cb != NULL && loop != NULL)
     if (uv__iou_fs_unlink(loop, req))
       return 0;
   POST;
@@ -2244,7 +2289,7 @@ int uv_fs_write(uv_loop_t* loop,
 
   req->off = off;
 
-  if (cb != NULL)
+  if (cb != NULL && loop != NULL)
     if (uv__iou_fs_read_or_write(loop, req, /* is_read */ 0))
       return 0;
 
@@ -2279,7 +2324,10 @@ void uv_fs_req_cleanup(uv_fs_t* req) {
     uv__free(req->bufs);
   req->bufs = NULL;
 
-  if (req->fs_type != UV_FS_OPENDIR && req->ptr != &req->statbuf)
+  /* The sub-requests of a batch belong to the caller. */
+  if (req->fs_type != UV_FS_OPENDIR &&
+      req->fs_type != UV_FS_BATCH &&
+      req->ptr != &req->statbuf)
     uv__free(req->ptr);
   req->ptr = NULL;
 }
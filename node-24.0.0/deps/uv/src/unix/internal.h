@@ -291,6 +291,15 @@ int uv__dup2_cloexec(int oldfd, int newfd);
 int uv__open_cloexec(const char* path, int flags);
 int uv__slurp(const char* filename, char* buf, size_t len);
 
+/* demi */
+struct dpoll_completion;
+int uv__demi_stream(const uv_stream_t* stream);
+int uv__demi_read_start(uv_stream_t* stream);
+int uv__demi_write(uv_stream_t* stream, uv_write_t* req);
+int uv__demi_poll(uv_loop_t* loop);
+void uv__stream_demi_read(uv_stream_t* stream, struct dpoll_completion* c);
+void uv__stream_demi_write(uv_write_t* req, ssize_t res);
+
 /* tcp */
 int uv__tcp_listen(uv_tcp_t* tcp, int backlog, uv_connection_cb cb);
 int uv__tcp_nodelay(int fd, int on);
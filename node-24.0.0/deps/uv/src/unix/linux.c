@@ -26,6 +26,7 @@
 #include "uv.h"
 #include "internal.h"
 
+#include <demi_epoll/completion.h>
 #include <demi_epoll/dpoll.h>
 #include <inttypes.h>
 #include <stdatomic.h>
@@ -1367,6 +1368,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
   uint64_t base;
   int have_iou_events;
   int have_signals;
+  int ncompletions;
   int nevents;
   int epollfd;
   int count;
@@ -1444,7 +1446,8 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
   for (;;) {
     if (loop->nfds == 0)
       if (iou->in_flight == 0)
-        break;
+        if (dpoll_inflight(epollfd) == 0)
+          break;
 
     /* All event mask mutations should be visible to the kernel before
      * we enter epoll_pwait().
@@ -1473,12 +1476,26 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
      */
     SAVE_ERRNO(uv__update_time(loop));
 
+    /* Completed demikernel operations don't show up as epoll events, the
+     * wait only returns early because of them.
+     */
+    ncompletions = 0;
+    if (nfds != -1)
+      ncompletions = uv__demi_poll(loop);
+
     if (nfds == -1)
       assert(errno == EINTR);
-    else if (nfds == 0)
+    else if (nfds == 0 && ncompletions == 0)
       /* Unlimited timeout should only return with events or signal. */
       assert(timeout != -1);
 
+    if (nfds == 0 && ncompletions != 0) {
+      uv__metrics_inc_events(loop, ncompletions);
+      if (reset_timeout != 0)
+        uv__metrics_inc_events_waiting(loop, ncompletions);
+      return;
+    }
+
     if (nfds == 0 || nfds == -1) {
       if (reset_timeout != 0) {
         timeout = user_timeout;
@@ -1493,7 +1510,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
 
     have_iou_events = 0;
     have_signals = 0;
-    nevents = 0;
+    nevents = ncompletions;
 
     inv.nfds = nfds;
     lfields->inv = &inv;
@@ -33,6 +33,7 @@
 #include <assert.h>
 #include <errno.h>
 
+#include <demi_epoll/completion.h>
 #include <demi_epoll/sockets.h>
 
 #include <sys/types.h>
@@ -83,6 +84,12 @@ union uv__cmsg {
 
 STATIC_ASSERT(256 == sizeof(union uv__cmsg));
 
+/* Limits for gathering the buffers of consecutive write requests into one
+ * writev().  A request that exceeds them on its own is written on its own.
+ */
+#define UV__WRITE_GATHER_BUFS 64
+#define UV__WRITE_GATHER_BYTES (64 * 1024)
+
 static void uv__stream_connect(uv_stream_t*);
 static void uv__write(uv_stream_t* stream);
 static void uv__read(uv_stream_t* stream);
@@ -850,7 +857,87 @@ static int uv__try_write(uv_stream_t* stream,
   return UV__ERR(errno);
 }
 
+/* Copies the unwritten buffers of the requests at the head of the write queue
+ * into `bufs`, stopping at the first request that passes a handle or that does
+ * not fit anymore.  Returns the number of requests gathered.
+ */
+static unsigned int uv__write_gather(uv_stream_t* stream,
+                                     uv_buf_t* bufs,
+                                     unsigned int* nbufs) {
+  struct uv__queue* q;
+  uv_write_t* req;
+  unsigned int nreqs;
+  unsigned int n;
+  size_t size;
+  size_t reqsize;
+  int iovmax;
+
+  iovmax = uv__getiovmax();
+  if (iovmax > UV__WRITE_GATHER_BUFS)
+    iovmax = UV__WRITE_GATHER_BUFS;
+
+  nreqs = 0;
+  size = 0;
+  *nbufs = 0;
+
+  uv__queue_foreach(q, &stream->write_queue) {
+    req = uv__queue_data(q, uv_write_t, queue);
+    if (req->send_handle != NULL)
+      break;
+
+    n = req->nbufs - req->write_index;
+    if (*nbufs + n > (unsigned int) iovmax)
+      break;
+
+    reqsize = uv__count_bufs(req->bufs + req->write_index, n);
+    if (nreqs > 0 && size + reqsize > UV__WRITE_GATHER_BYTES)
+      break;
+
+    memcpy(bufs + *nbufs, req->bufs + req->write_index, n * sizeof(*bufs));
+    *nbufs += n;
+    size += reqsize;
+    nreqs++;
+  }
+
+  return nreqs;
+}
+
+
+/* Attributes `n` written bytes to the first `nreqs` requests of the write
+ * queue, in order.  Returns 1 if all of them were written completely.
+ */
+static int uv__write_gather_update(uv_stream_t* stream,
+                                   unsigned int nreqs,
+                                   size_t n) {
+  uv_write_t* req;
+  size_t size;
+
+  while (nreqs-- > 0) {
+    req = uv__queue_data(uv__queue_head(&stream->write_queue),
+                         uv_write_t,
+                         queue);
+    size = uv__write_req_size(req);
+
+    if (n < size) {
+      if (n > 0)
+        uv__write_req_update(stream, req, n);
+      return 0;
+    }
+
+    stream->write_queue_size -= size;
+    req->write_index = req->nbufs;
+    uv__write_req_finish(req);
+    n -= size;
+  }
+
+  return 1;
+}
+
+
 static void uv__write(uv_stream_t* stream) {
+  uv_buf_t bufs[UV__WRITE_GATHER_BUFS];
+  unsigned int nbufs;
+  unsigned int nreqs;
   struct uv__queue* q;
   uv_write_t* req;
   ssize_t n;
@@ -858,6 +945,12 @@ static void uv__write(uv_stream_t* stream) {
 
   assert(uv__stream_fd(stream) >= 0);
 
+  /* Requests of demikernel streams were posted by uv_write2() already, they
+   * sit in the write queue until their push completes.
+   */
+  if (uv__demi_stream(stream))
+    return;
+
   /* Prevent loop starvation when the consumer of this stream read as fast as
    * (or faster than) we can write it. This `count` mechanism does not need to
    * change even if we switch to edge-triggered I/O.
@@ -872,6 +965,30 @@ static void uv__write(uv_stream_t* stream) {
     req = uv__queue_data(q, uv_write_t, queue);
     assert(req->handle == stream);
 
+    /* Many small requests are written with a single writev(), which under
+     * the shim also means a single demikernel push.
+     */
+    nreqs = uv__write_gather(stream, bufs, &nbufs);
+    if (nreqs > 1) {
+      n = uv__try_write(stream, bufs, nbufs, NULL);
+      if (n >= 0) {
+        if (uv__write_gather_update(stream, nreqs, n)) {
+          if (count-- > 0)
+            continue;
+
+          return;
+        }
+      } else if (n != UV_EAGAIN)
+        goto error;
+
+      if (stream->flags & UV_HANDLE_BLOCKING_WRITES)
+        continue;
+
+      uv__io_start(stream->loop, &stream->io_watcher, POLLOUT);
+      uv__stream_osx_interrupt_select(stream);
+      return;
+    }
+
     n = uv__try_write(stream,
                       &(req->bufs[req->write_index]),
                       req->nbufs - req->write_index,
@@ -1170,6 +1287,115 @@ static void uv__read(uv_stream_t* stream) {
 }
 
 
+void uv__stream_demi_read(uv_stream_t* stream, struct dpoll_completion* c) {
+  uv_buf_t buf;
+  size_t remaining;
+  size_t nread;
+  int err;
+
+  /* Data that isn't read now stays with the socket and is handed out by the
+   * next pop, see dpoll_completion_release().
+   */
+  if (uv__is_closing(stream) || !(stream->flags & UV_HANDLE_READING)) {
+    dpoll_completion_release(c);
+    return;
+  }
+
+  if (c->res < 0) {
+    err = c->res;
+    dpoll_completion_release(c);
+    buf = uv_buf_init(NULL, 0);
+    stream->flags &= ~(UV_HANDLE_READABLE | UV_HANDLE_WRITABLE);
+    stream->read_cb(stream, err, &buf);
+    if (stream->flags & UV_HANDLE_READING) {
+      stream->flags &= ~UV_HANDLE_READING;
+      uv__handle_stop(stream);
+    }
+    return;
+  }
+
+  if (c->res == 0) {
+    dpoll_completion_release(c);
+    buf = uv_buf_init(NULL, 0);
+    uv__stream_eof(stream, &buf);
+    return;
+  }
+
+  /* A single pop can be larger than the buffers handed out by alloc_cb. */
+  remaining = c->res;
+  while (remaining > 0 && (stream->flags & UV_HANDLE_READING)) {
+    buf = uv_buf_init(NULL, 0);
+    stream->alloc_cb((uv_handle_t*)stream, 64 * 1024, &buf);
+    if (buf.base == NULL || buf.len == 0) {
+      /* User indicates it can't or won't handle the read. */
+      dpoll_completion_release(c);
+      stream->read_cb(stream, UV_ENOBUFS, &buf);
+      return;
+    }
+
+    nread = dpoll_completion_read(c, buf.base, buf.len);
+    remaining -= nread;
+    stream->read_cb(stream, nread, &buf);
+  }
+  dpoll_completion_release(c);
+
+  if (!(stream->flags & UV_HANDLE_READING))
+    return;
+
+  err = uv__demi_read_start(stream);
+  if (err != 0) {
+    buf = uv_buf_init(NULL, 0);
+    stream->flags &= ~UV_HANDLE_READING;
+    uv__handle_stop(stream);
+    stream->read_cb(stream, err, &buf);
+  }
+}
+
+
+/* uv_write2() leaves the requests of a demikernel stream in the write queue
+ * while it is connecting, post them now. Once a push can't be posted the
+ * requests behind it can't be written in order anymore and fail with it.
+ */
+static void uv__stream_demi_post_writes(uv_stream_t* stream) {
+  struct uv__queue* q;
+  struct uv__queue* next;
+  uv_write_t* req;
+  int err;
+
+  err = 0;
+  for (q = uv__queue_head(&stream->write_queue);
+       q != &stream->write_queue;
+       q = next) {
+    next = uv__queue_next(q);
+    req = uv__queue_data(q, uv_write_t, queue);
+    if (err == 0)
+      err = uv__demi_write(stream, req);
+    if (err < 0) {
+      req->error = err;
+      uv__write_req_finish(req);
+    }
+  }
+}
+
+
+void uv__stream_demi_write(uv_write_t* req, ssize_t res) {
+  uv_stream_t* stream;
+
+  stream = req->handle;
+
+  /* uv__stream_destroy() cancels the request. */
+  if (uv__is_closing(stream))
+    return;
+
+  if (res < 0)
+    req->error = res;
+  else if (res > 0)
+    uv__write_req_update(stream, req, res);
+
+  uv__write_req_finish(req);
+}
+
+
 int uv_shutdown(uv_shutdown_t* req, uv_stream_t* stream, uv_shutdown_cb cb) {
   assert(stream->type == UV_TCP ||
          stream->type == UV_TTY ||
@@ -1288,10 +1514,16 @@ static void uv__stream_connect(uv_stream_t* stream) {
   stream->connect_req = NULL;
   uv__req_unregister(stream->loop);
 
-  if (error < 0 || uv__queue_empty(&stream->write_queue)) {
+  if (error < 0 ||
+      uv__queue_empty(&stream->write_queue) ||
+      uv__demi_stream(stream)) {
     uv__io_stop(stream->loop, &stream->io_watcher, POLLOUT);
   }
 
+  /* Before the connect callback, which may queue more writes. */
+  if (error == 0 && uv__demi_stream(stream))
+    uv__stream_demi_post_writes(stream);
+
   if (req->cb)
     req->cb(req, error);
 
@@ -1333,6 +1565,10 @@ static int uv__check_before_write(uv_stream_t* stream,
     if (uv__handle_fd((uv_handle_t*) send_handle) < 0)
       return UV_EBADF;
 
+    /* Demikernel sockets only exist in the process that created them. */
+    if (dpoll_is_socket(uv__handle_fd((uv_handle_t*) send_handle)))
+      return UV_ENOTSUP;
+
 #if defined(__CYGWIN__) || defined(__MSYS__)
     /* Cygwin recvmsg always sets msg_controllen to zero, so we cannot send it.
        See https://github.com/mirror/newlib-cygwin/blob/86fc4bf0/winsup/cygwin/fhandler_socket.cc#L1736-L1743 */
@@ -1394,6 +1630,13 @@ int uv_write2(uv_write_t* req,
   if (stream->connect_req) {
     /* Still connecting, do nothing. */
   }
+  else if (uv__demi_stream(stream)) {
+    err = uv__demi_write(stream, req);
+    if (err < 0) {
+      req->error = err;
+      uv__write_req_finish(req);
+    }
+  }
   else if (empty_queue) {
     uv__write(stream);
   }
@@ -1441,6 +1684,10 @@ int uv_try_write2(uv_stream_t* stream,
   if (stream->connect_req != NULL || stream->write_queue_size != 0)
     return UV_EAGAIN;
 
+  /* Demikernel streams only write through posted pushes. */
+  if (uv__demi_stream(stream))
+    return UV_EAGAIN;
+
   err = uv__check_before_write(stream, nbufs, NULL);
   if (err < 0)
     return err;
@@ -1467,6 +1714,11 @@ int uv__read_start(uv_stream_t* stream,
   stream->read_cb = read_cb;
   stream->alloc_cb = alloc_cb;
 
+  if (uv__demi_stream(stream)) {
+    uv__handle_start(stream);
+    return uv__demi_read_start(stream);
+  }
+
   uv__io_start(stream->loop, &stream->io_watcher, POLLIN);
   uv__handle_start(stream);
   uv__stream_osx_interrupt_select(stream);
@@ -625,6 +625,20 @@ int uv_tcp_simultaneous_accepts(uv_tcp_t* handle, int enable) {
 }
 
 
+/* Only demikernel sockets can be timed out by the shim, reads of an expired
+ * handle fail with UV_ETIMEDOUT.
+ */
+int uv_tcp_idle_timeout(uv_tcp_t* handle, unsigned int timeout) {
+  if (uv__stream_fd(handle) == -1)
+    return UV_EBADF;
+
+  if (dpoll_set_idle_timeout(uv__stream_fd(handle), timeout))
+    return UV__ERR(errno);
+
+  return 0;
+}
+
+
 void uv__tcp_close(uv_tcp_t* handle) {
   uv__stream_close((uv_stream_t*)handle);
 }
@@ -431,6 +431,7 @@ struct uv__loop_internal_fields_s {
   struct uv__iou ctl;
   struct uv__iou iou;
   void* inv;  /* used by uv__platform_invalidate_fd() */
+  struct dpoll_doorbell* doorbell;  /* used by uv__async_send() */
 #endif  /* __linux__ */
 };
 
@@ -3738,6 +3738,13 @@ int uv_fs_lutime(uv_loop_t* loop, uv_fs_t* req, const char* path, double atime,
 }
 
 
+int uv_fs_batch(uv_loop_t* loop, uv_fs_t* req, uv_fs_t reqs[],
+    unsigned int nreqs, uv_fs_cb cb) {
+  /* Requests can't be prepared without a loop here, see unix/fs.c. */
+  return UV_ENOSYS;
+}
+
+
 int uv_fs_statfs(uv_loop_t* loop,
                  uv_fs_t* req,
                  const char* path,
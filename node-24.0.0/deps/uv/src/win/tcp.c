@@ -1388,6 +1388,11 @@ int uv_tcp_simultaneous_accepts(uv_tcp_t* handle, int enable) {
 }
 
 
+int uv_tcp_idle_timeout(uv_tcp_t* handle, unsigned int timeout) {
+  return UV_ENOTSUP;
+}
+
+
 static void uv__tcp_try_cancel_reqs(uv_tcp_t* tcp) {
   SOCKET socket;
   int non_ifs_lsp;
@@ -2940,6 +2940,60 @@ TEST_IMPL(fs_stat_missing_path) {
 }
 
 
+static int batch_cb_count;
+
+static void batch_cb(uv_fs_t* req) {
+  ASSERT_EQ(req->fs_type, UV_FS_BATCH);
+  ASSERT_OK(req->result);
+  batch_cb_count++;
+  uv_fs_req_cleanup(req);
+}
+
+static void batch_sub_cb(uv_fs_t* req) {
+  ASSERT(0 && "should not be called");
+}
+
+
+TEST_IMPL(fs_batch) {
+#ifdef _WIN32
+  RETURN_SKIP("uv_fs_batch() is not supported on Windows");
+#else
+  uv_fs_t reqs[3];
+  uv_fs_t req;
+  int r;
+
+  loop = uv_default_loop();
+
+  ASSERT_OK(uv_fs_stat(NULL, &reqs[0], ".", batch_sub_cb));
+  ASSERT_OK(uv_fs_stat(NULL, &reqs[1], "non_existent_file", batch_sub_cb));
+  ASSERT_OK(uv_fs_lstat(NULL, &reqs[2], ".", batch_sub_cb));
+
+  /* Unlike the other uv_fs_*() functions, a batch can only run async. */
+  r = uv_fs_batch(loop, &req, reqs, ARRAY_SIZE(reqs), NULL);
+  ASSERT_EQ(r, UV_EINVAL);
+
+  r = uv_fs_batch(loop, &req, reqs, ARRAY_SIZE(reqs), batch_cb);
+  ASSERT_OK(r);
+  uv_run(loop, UV_RUN_DEFAULT);
+  ASSERT_EQ(1, batch_cb_count);
+
+  ASSERT_OK(reqs[0].result);
+  ASSERT_PTR_EQ(reqs[0].ptr, &reqs[0].statbuf);
+  ASSERT(S_ISDIR(reqs[0].statbuf.st_mode));
+  ASSERT_EQ(reqs[1].result, UV_ENOENT);
+  ASSERT_OK(reqs[2].result);
+  ASSERT_EQ(reqs[2].statbuf.st_ino, reqs[0].statbuf.st_ino);
+
+  uv_fs_req_cleanup(&reqs[0]);
+  uv_fs_req_cleanup(&reqs[1]);
+  uv_fs_req_cleanup(&reqs[2]);
+
+  MAKE_VALGRIND_HAPPY(loop);
+  return 0;
+#endif
+}
+
+
 TEST_IMPL(fs_scandir_empty_dir) {
   const char* path;
   uv_fs_t req;
@@ -0,0 +1,161 @@
+/* Copyright libuv project contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Queued writes are gathered into one writev().  The socket buffers are kept
+ * small, so most of those writev() calls end in the middle of a request.
+ * Checks that every request is finished in order, only once all of its bytes
+ * were taken by the kernel, and that the reader sees each byte exactly once.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#endif
+
+#define REQ_COUNT 64
+#define REQ_SIZE(i) (700 + 13 * (i))
+
+static uv_pipe_t writer;
+static uv_pipe_t reader;
+static uv_write_t write_reqs[REQ_COUNT];
+static char* write_bufs[REQ_COUNT];
+static int reader_fd;
+static size_t total_size;
+static size_t read_size;
+static int read_req;
+static size_t read_off;
+static int write_cb_called;
+static int close_cb_called;
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  static char slab[2048];
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  ssize_t i;
+
+  ASSERT_GE(nread, 0);
+  for (i = 0; i < nread; i++) {
+    ASSERT_LT(read_req, REQ_COUNT);
+    ASSERT_EQ((unsigned char) buf->base[i], (unsigned char) read_req);
+    if (++read_off == REQ_SIZE(read_req)) {
+      read_req++;
+      read_off = 0;
+    }
+  }
+  read_size += nread;
+
+  if (read_size == total_size) {
+    uv_close((uv_handle_t*) &writer, close_cb);
+    uv_close((uv_handle_t*) &reader, close_cb);
+  }
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+#ifndef _WIN32
+  size_t written;
+  int queued;
+  int i;
+
+  ASSERT_OK(status);
+  ASSERT_PTR_EQ(req, &write_reqs[write_cb_called]);
+
+  /* Everything up to this request has reached the other end, which is only
+   * unknown once the reader has read it all and was closed.
+   */
+  if (!uv_is_closing((uv_handle_t*) &reader)) {
+    written = 0;
+    for (i = 0; i <= write_cb_called; i++)
+      written += REQ_SIZE(i);
+    ASSERT_OK(ioctl(reader_fd, FIONREAD, &queued));
+    ASSERT_GE(read_size + queued, written);
+  }
+
+  write_cb_called++;
+#endif
+}
+
+
+TEST_IMPL(pipe_write_gather) {
+#ifdef _WIN32
+  RETURN_SKIP("Test uses socketpair() and FIONREAD.");
+#else
+  int fds[2];
+  int size;
+  uv_buf_t buf;
+  int i;
+
+  ASSERT_OK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  size = 4096;
+  ASSERT_OK(setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size)));
+  ASSERT_OK(setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)));
+  reader_fd = fds[1];
+
+  ASSERT_OK(uv_pipe_init(uv_default_loop(), &writer, 0));
+  ASSERT_OK(uv_pipe_open(&writer, fds[0]));
+  ASSERT_OK(uv_pipe_init(uv_default_loop(), &reader, 0));
+  ASSERT_OK(uv_pipe_open(&reader, fds[1]));
+
+  for (i = 0; i < REQ_COUNT; i++) {
+    write_bufs[i] = malloc(REQ_SIZE(i));
+    ASSERT_NOT_NULL(write_bufs[i]);
+    memset(write_bufs[i], i, REQ_SIZE(i));
+    buf = uv_buf_init(write_bufs[i], REQ_SIZE(i));
+    ASSERT_OK(uv_write(&write_reqs[i],
+                       (uv_stream_t*) &writer,
+                       &buf,
+                       1,
+                       write_cb));
+    total_size += REQ_SIZE(i);
+  }
+  ASSERT_GT(uv_stream_get_write_queue_size((uv_stream_t*) &writer), 0);
+
+  ASSERT_OK(uv_read_start((uv_stream_t*) &reader, alloc_cb, read_cb));
+  ASSERT_OK(uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT_EQ(REQ_COUNT, write_cb_called);
+  ASSERT_EQ(total_size, read_size);
+  ASSERT_EQ(REQ_COUNT, read_req);
+  ASSERT_EQ(2, close_cb_called);
+
+  for (i = 0; i < REQ_COUNT; i++)
+    free(write_bufs[i]);
+
+  MAKE_VALGRIND_HAPPY(uv_default_loop());
+  return 0;
+#endif
+}
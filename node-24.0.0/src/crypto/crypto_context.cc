@@ -41,7 +41,9 @@ using ncrypto::EnginePointer;
 #endif  // !OPENSSL_NO_ENGINE
 using ncrypto::EVPKeyPointer;
 using ncrypto::MarkPopErrorOnReturn;
+using ncrypto::RSAPointer;
 using ncrypto::SSLPointer;
+using ncrypto::SSLSessionPointer;
 using ncrypto::StackOfX509;
 using ncrypto::X509Pointer;
 using ncrypto::X509View;
@@ -955,6 +957,231 @@ void GetExtraCACertificates(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
+#ifdef NODE_ASYNC_PRIVATE_KEY
+namespace {
+thread_local PrivateKeyOp* pending_private_key_op = nullptr;
+
+// The keys made by NewAsyncPrivateKey() keep the key they were copied from,
+// with the default method, in their ex data. Operations use that one on the
+// threadpool.
+template <typename T, void (*Free)(T*)>
+void FreeOriginalKey(void* parent,
+                     void* ptr,
+                     CRYPTO_EX_DATA* ad,
+                     int idx,
+                     long argl,  // NOLINT(runtime/int)
+                     void* argp) {
+  Free(static_cast<T*>(ptr));
+}
+
+constexpr CRYPTO_EX_free* FreeRsa = FreeOriginalKey<RSA, RSA_free>;
+constexpr CRYPTO_EX_free* FreeEcKey = FreeOriginalKey<EC_KEY, EC_KEY_free>;
+
+int RsaExIndex() {
+  static const int index =
+      RSA_get_ex_new_index(0, nullptr, nullptr, nullptr, FreeRsa);
+  return index;
+}
+
+int EcKeyExIndex() {
+  static const int index =
+      EC_KEY_get_ex_new_index(0, nullptr, nullptr, nullptr, FreeEcKey);
+  return index;
+}
+
+int AsyncRsaPrivEnc(
+    int flen, const unsigned char* from, unsigned char* to, RSA* rsa, int pad) {
+  RSA* key = static_cast<RSA*>(RSA_get_ex_data(rsa, RsaExIndex()));
+  return PrivateKeyOp::Run(
+      [=]() { return RSA_private_encrypt(flen, from, to, key, pad); });
+}
+
+int AsyncRsaPrivDec(
+    int flen, const unsigned char* from, unsigned char* to, RSA* rsa, int pad) {
+  RSA* key = static_cast<RSA*>(RSA_get_ex_data(rsa, RsaExIndex()));
+  return PrivateKeyOp::Run(
+      [=]() { return RSA_private_decrypt(flen, from, to, key, pad); });
+}
+
+int AsyncEcdsaSign(int type,
+                   const unsigned char* dgst,
+                   int dlen,
+                   unsigned char* sig,
+                   unsigned int* siglen,
+                   const BIGNUM* kinv,
+                   const BIGNUM* r,
+                   EC_KEY* eckey) {
+  EC_KEY* key = static_cast<EC_KEY*>(EC_KEY_get_ex_data(eckey, EcKeyExIndex()));
+  return PrivateKeyOp::Run([=]() {
+    return ECDSA_sign_ex(type, dgst, dlen, sig, siglen, kinv, r, key);
+  });
+}
+
+// Never freed, shared by all keys.
+const RSA_METHOD* AsyncRsaMethod() {
+  static RSA_METHOD* method = []() {
+    RSA_METHOD* m = RSA_meth_dup(RSA_PKCS1_OpenSSL());
+    CHECK_NOT_NULL(m);
+    RSA_meth_set_priv_enc(m, AsyncRsaPrivEnc);
+    RSA_meth_set_priv_dec(m, AsyncRsaPrivDec);
+    return m;
+  }();
+  return method;
+}
+
+const EC_KEY_METHOD* AsyncEcKeyMethod() {
+  static EC_KEY_METHOD* method = []() {
+    EC_KEY_METHOD* m = EC_KEY_METHOD_new(EC_KEY_OpenSSL());
+    CHECK_NOT_NULL(m);
+    int (*sign_setup)(EC_KEY*, BN_CTX*, BIGNUM**, BIGNUM**);
+    ECDSA_SIG* (*sign_sig)(
+        const unsigned char*, int, const BIGNUM*, const BIGNUM*, EC_KEY*);
+    EC_KEY_METHOD_get_sign(EC_KEY_OpenSSL(), nullptr, &sign_setup, &sign_sig);
+    EC_KEY_METHOD_set_sign(m, AsyncEcdsaSign, sign_setup, sign_sig);
+    return m;
+  }();
+  return method;
+}
+}  // namespace
+
+EVPKeyPointer PrivateKeyOp::NewAsyncPrivateKey(EVP_PKEY* pkey) {
+  switch (EVP_PKEY_id(pkey)) {
+    case EVP_PKEY_RSA: {
+      RSAPointer original(EVP_PKEY_get1_RSA(pkey));
+      if (!original) return {};
+      RSAPointer rsa(RSAPrivateKey_dup(original.get()));
+      if (!rsa || !RSA_set_method(rsa.get(), AsyncRsaMethod()) ||
+          !RSA_set_ex_data(rsa.get(), RsaExIndex(), original.get())) {
+        return {};
+      }
+      original.release();
+      return EVPKeyPointer::NewRSA(std::move(rsa));
+    }
+    case EVP_PKEY_EC: {
+      DeleteFnPtr<EC_KEY, EC_KEY_free> original(EVP_PKEY_get1_EC_KEY(pkey));
+      if (!original) return {};
+      DeleteFnPtr<EC_KEY, EC_KEY_free> ec(EC_KEY_dup(original.get()));
+      if (!ec || !EC_KEY_set_method(ec.get(), AsyncEcKeyMethod()) ||
+          !EC_KEY_set_ex_data(ec.get(), EcKeyExIndex(), original.get())) {
+        return {};
+      }
+      original.release();
+      EVPKeyPointer key(EVP_PKEY_new());
+      if (!key || !EVP_PKEY_assign_EC_KEY(key.get(), ec.get())) return {};
+      ec.release();
+      return key;
+    }
+    default:
+      return {};
+  }
+}
+
+int PrivateKeyOp::Run(std::function<int()> fn) {
+  if (ASYNC_get_current_job() == nullptr) return fn();
+
+  // Lives on the stack of the paused job until the handshake is resumed.
+  PrivateKeyOp op;
+  op.fn_ = std::move(fn);
+  pending_private_key_op = &op;
+  if (!ASYNC_pause_job()) {
+    pending_private_key_op = nullptr;
+    return op.fn_();
+  }
+  // TLSWrap doesn't touch the SSL while the operation runs.
+  CHECK(op.done_);
+  return op.result_;
+}
+
+PrivateKeyOp* PrivateKeyOp::TakePending() {
+  PrivateKeyOp* op = pending_private_key_op;
+  pending_private_key_op = nullptr;
+  return op;
+}
+
+void PrivateKeyOp::DoWork() {
+  result_ = fn_();
+  done_ = true;
+}
+#endif  // NODE_ASYNC_PRIVATE_KEY
+
+SharedSessionCache* SharedSessionCache::Get() {
+  // Never destroyed, worker threads may still be handshaking at exit.
+  static SharedSessionCache* cache = new SharedSessionCache();
+  return cache;
+}
+
+std::string SharedSessionCache::Key(std::string_view ns,
+                                    const unsigned char* id,
+                                    size_t len) {
+  // The length keeps a namespace from running into the id.
+  std::string key = std::to_string(ns.size());
+  key += ':';
+  key += ns;
+  key.append(reinterpret_cast<const char*>(id), len);
+  return key;
+}
+
+SharedSessionCache::Shard* SharedSessionCache::ShardFor(
+    const std::string& key) {
+  return &shards_[std::hash<std::string>()(key) % kShards];
+}
+
+void SharedSessionCache::Evict(Shard* shard, int64_t now) {
+  for (auto it = shard->entries.begin(); it != shard->entries.end();) {
+    if (it->second.expires <= now)
+      it = shard->entries.erase(it);
+    else
+      ++it;
+  }
+  // Nothing expired, drop an arbitrary session, its client does a full
+  // handshake next time.
+  if (shard->entries.size() >= kMaxEntriesPerShard)
+    shard->entries.erase(shard->entries.begin());
+}
+
+void SharedSessionCache::Add(std::string_view ns, SSL_SESSION* sess) {
+  int size = i2d_SSL_SESSION(sess, nullptr);
+  if (size <= 0 || size > SecureContext::kMaxSessionSize) return;
+
+  unsigned int id_length;
+  const unsigned char* id_data = SSL_SESSION_get_id(sess, &id_length);
+  if (id_length == 0) return;
+
+  Entry entry;
+  entry.der.resize(size);
+  unsigned char* der = entry.der.data();
+  CHECK_EQ(i2d_SSL_SESSION(sess, &der), size);
+  entry.expires = static_cast<int64_t>(SSL_SESSION_get_time(sess)) +
+                  SSL_SESSION_get_timeout(sess);
+
+  std::string key = Key(ns, id_data, id_length);
+  Shard* shard = ShardFor(key);
+  Mutex::ScopedLock lock(shard->mutex);
+  if (shard->entries.size() >= kMaxEntriesPerShard)
+    Evict(shard, time(nullptr));
+  shard->entries.insert_or_assign(std::move(key), std::move(entry));
+}
+
+SSLSessionPointer SharedSessionCache::Find(std::string_view ns,
+                                           const unsigned char* id,
+                                           size_t len) {
+  std::string key = Key(ns, id, len);
+  Shard* shard = ShardFor(key);
+  std::vector<unsigned char> der;
+  {
+    Mutex::ScopedLock lock(shard->mutex);
+    auto it = shard->entries.find(key);
+    if (it == shard->entries.end()) return {};
+    if (it->second.expires <= time(nullptr)) {
+      shard->entries.erase(it);
+      return {};
+    }
+    der = it->second.der;
+  }
+  const unsigned char* data = der.data();
+  return SSLSessionPointer(d2i_SSL_SESSION(nullptr, &data, der.size()));
+}
+
 bool SecureContext::HasInstance(Environment* env, const Local<Value>& value) {
   return GetConstructorTemplate(env)->HasInstance(value);
 }
@@ -989,6 +1216,10 @@ Local<FunctionTemplate> SecureContext::GetConstructorTemplate(
     SetProtoMethod(isolate, tmpl, "setOptions", SetOptions);
     SetProtoMethod(isolate, tmpl, "setSessionIdContext", SetSessionIdContext);
     SetProtoMethod(isolate, tmpl, "setSessionTimeout", SetSessionTimeout);
+    SetProtoMethod(
+        isolate, tmpl, "enableSharedSessionCache", EnableSharedSessionCache);
+    SetProtoMethod(
+        isolate, tmpl, "enableAsyncPrivateKey", EnableAsyncPrivateKey);
     SetProtoMethod(isolate, tmpl, "close", Close);
     SetProtoMethod(isolate, tmpl, "loadPKCS12", LoadPKCS12);
     SetProtoMethod(isolate, tmpl, "setTicketKeys", SetTicketKeys);
@@ -1070,6 +1301,8 @@ void SecureContext::RegisterExternalReferences(
   registry->Register(SetOptions);
   registry->Register(SetSessionIdContext);
   registry->Register(SetSessionTimeout);
+  registry->Register(EnableSharedSessionCache);
+  registry->Register(EnableAsyncPrivateKey);
   registry->Register(Close);
   registry->Register(LoadPKCS12);
   registry->Register(SetTicketKeys);
@@ -1724,6 +1957,52 @@ void SecureContext::SetSessionTimeout(const FunctionCallbackInfo<Value>& args) {
   SSL_CTX_set_timeout(sc->ctx_.get(), sessionTimeout);
 }
 
+// Takes an optional name. Only contexts with the same name resume each other's
+// sessions, so they must agree on everything a resumed session skips, like
+// requestCert and the CA certificates.
+void SecureContext::EnableSharedSessionCache(
+    const FunctionCallbackInfo<Value>& args) {
+  // Contexts without a name get one that no other context has.
+  static std::atomic<uint64_t> next_context_id{0};
+  SecureContext* sc;
+  ASSIGN_OR_RETURN_UNWRAP(&sc, args.This());
+  Environment* env = Environment::GetCurrent(args);
+  if (args[0]->IsString()) {
+    const Utf8Value name(env->isolate(), args[0]);
+    sc->shared_session_namespace_ = "n" + name.ToString();
+  } else {
+    sc->shared_session_namespace_ =
+        "c" + std::to_string(next_context_id.fetch_add(1));
+  }
+  sc->shared_session_cache_ = true;
+}
+
+// Returns true if private key operations of the current key now run on the
+// threadpool during handshakes, false if they keep running synchronously
+// because there is no key yet, its type isn't RSA or EC, or OpenSSL was built
+// without ASYNC support. Has to be called again after changing the key.
+void SecureContext::EnableAsyncPrivateKey(
+    const FunctionCallbackInfo<Value>& args) {
+  SecureContext* sc;
+  ASSIGN_OR_RETURN_UNWRAP(&sc, args.This());
+#ifdef NODE_ASYNC_PRIVATE_KEY
+  Environment* env = Environment::GetCurrent(args);
+  ClearErrorOnReturn clear_error_on_return;
+
+  EVP_PKEY* current = SSL_CTX_get0_privatekey(sc->ctx_.get());
+  if (current == nullptr) return args.GetReturnValue().Set(false);
+  EVPKeyPointer key = PrivateKeyOp::NewAsyncPrivateKey(current);
+  if (!key) return args.GetReturnValue().Set(false);
+
+  if (!SSL_CTX_use_PrivateKey(sc->ctx_.get(), key.get()))
+    return ThrowCryptoError(env, ERR_get_error(), "SSL_CTX_use_PrivateKey");
+  sc->async_private_key_ = true;
+  args.GetReturnValue().Set(true);
+#else
+  args.GetReturnValue().Set(false);
+#endif  // NODE_ASYNC_PRIVATE_KEY
+}
+
 void SecureContext::Close(const FunctionCallbackInfo<Value>& args) {
   SecureContext* sc;
   ASSIGN_OR_RETURN_UNWRAP(&sc, args.This());
@@ -8,8 +8,17 @@
 #include "crypto/crypto_util.h"
 #include "env.h"
 #include "memory_tracker.h"
+#include "node_mutex.h"
 #include "v8.h"
 
+#include <array>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
 namespace node {
 namespace crypto {
 // A maxVersion of 0 means "any", but OpenSSL may support TLS versions that
@@ -25,6 +34,80 @@ X509_STORE* GetOrCreateRootCertStore();
 
 ncrypto::BIOPointer LoadBIO(Environment* env, v8::Local<v8::Value> v);
 
+// Process wide store of serialized server sessions, used directly from the
+// session callbacks of every SecureContext that opted in with
+// enableSharedSessionCache(), including those of worker threads. Sessions are
+// keyed by the namespace of their SecureContext as well as their id, so they
+// only resume on contexts of the same namespace. By default every context has
+// a namespace of its own. Contexts that are configured alike, e.g. the same
+// server's contexts on several worker threads, can share one by passing the
+// same name, which lets a client resume on any of them without a JS round
+// trip. The session id context is still checked by OpenSSL on top of that.
+// Entries expire with their session's timeout.
+class SharedSessionCache final {
+ public:
+  static SharedSessionCache* Get();
+
+  void Add(std::string_view ns, SSL_SESSION* sess);
+  ncrypto::SSLSessionPointer Find(std::string_view ns,
+                                  const unsigned char* id,
+                                  size_t len);
+
+ private:
+  static constexpr size_t kShards = 16;
+  static constexpr size_t kMaxEntriesPerShard = 1024;
+
+  struct Entry {
+    std::vector<unsigned char> der;
+    // Seconds since the epoch, like SSL_SESSION_get_time().
+    int64_t expires;
+  };
+
+  struct Shard {
+    Mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+  };
+
+  static std::string Key(std::string_view ns,
+                         const unsigned char* id,
+                         size_t len);
+  Shard* ShardFor(const std::string& key);
+  // Makes room for a new entry, caller holds shard->mutex.
+  static void Evict(Shard* shard, int64_t now);
+
+  std::array<Shard, kShards> shards_;
+};
+
+#if !defined(OPENSSL_NO_ASYNC) && !defined(OPENSSL_IS_BORINGSSL)
+#define NODE_ASYNC_PRIVATE_KEY 1
+
+// A private key operation of a SecureContext with enableAsyncPrivateKey().
+// Inside the ASYNC job of a handshake it pauses the job, TLSWrap picks it up
+// with TakePending(), runs it on the threadpool and then resumes the
+// handshake, which returns the result.
+class PrivateKeyOp final {
+ public:
+  // Copies pkey into a key whose private key operations go through Run().
+  // A custom method also keeps OpenSSL 3 from moving the key to a provider,
+  // which would bypass it. Only RSA and EC keys are supported.
+  static ncrypto::EVPKeyPointer NewAsyncPrivateKey(EVP_PKEY* pkey);
+  // Runs fn right away when not called from an ASYNC job.
+  static int Run(std::function<int()> fn);
+  // The operation the ASYNC job of the current thread last paused for.
+  static PrivateKeyOp* TakePending();
+
+  // Called on the threadpool.
+  void DoWork();
+  // Makes the operation fail, for connections destroyed while it ran.
+  void Cancel() { result_ = -1; }
+
+ private:
+  std::function<int()> fn_;
+  int result_ = -1;
+  bool done_ = false;
+};
+#endif  // !OPENSSL_NO_ASYNC && !OPENSSL_IS_BORINGSSL
+
 class SecureContext final : public BaseObject {
  public:
   using GetSessionCb = SSL_SESSION* (*)(SSL*, const unsigned char*, int, int*);
@@ -65,6 +148,14 @@ class SecureContext final : public BaseObject {
   void SetRootCerts();
 
   void SetX509StoreFlag(unsigned long flags);  // NOLINT(runtime/int)
+
+  inline bool uses_shared_session_cache() const {
+    return shared_session_cache_;
+  }
+  inline const std::string& shared_session_namespace() const {
+    return shared_session_namespace_;
+  }
+  inline bool uses_async_private_key() const { return async_private_key_; }
   X509_STORE* GetCertStoreOwnedByThisSecureContext();
 
   // TODO(joyeecheung): track the memory used by OpenSSL types
@@ -107,6 +198,10 @@ class SecureContext final : public BaseObject {
       const v8::FunctionCallbackInfo<v8::Value>& args);
   static void SetSessionTimeout(
       const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void EnableSharedSessionCache(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void EnableAsyncPrivateKey(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
   static void SetMinProto(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void SetMaxProto(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void GetMinProto(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -157,6 +252,10 @@ class SecureContext final : public BaseObject {
   unsigned char ticket_key_name_[16];
   unsigned char ticket_key_aes_[16];
   unsigned char ticket_key_hmac_[16];
+
+  bool shared_session_cache_ = false;
+  std::string shared_session_namespace_;
+  bool async_private_key_ = false;
 };
 
 int SSL_CTX_use_certificate_chain(SSL_CTX* ctx,
@@ -32,6 +32,7 @@
 #include "node_buffer.h"
 #include "node_errors.h"
 #include "stream_base-inl.h"
+#include "threadpoolwork-inl.h"
 #include "util-inl.h"
 
 namespace node {
@@ -100,7 +101,13 @@ SSL_SESSION* GetSessionCallback(
     int* copy) {
   TLSWrap* w = static_cast<TLSWrap*>(SSL_get_app_data(s));
   *copy = 0;
-  return w->ReleaseSession();
+  SSL_SESSION* sess = w->ReleaseSession();
+  // A session handed in by 'resumeSession' takes precedence.
+  if (sess == nullptr && w->uses_shared_session_cache())
+    sess = SharedSessionCache::Get()
+               ->Find(w->shared_session_namespace(), key, len)
+               .release();
+  return sess;
 }
 
 void OnClientHello(
@@ -142,6 +149,9 @@ void OnClientHello(
 
 void KeylogCallback(const SSL* s, const char* line) {
   TLSWrap* w = static_cast<TLSWrap*>(SSL_get_app_data(s));
+  if (w->DeferKeylog(line))
+    return;
+
   Environment* env = w->env();
   HandleScope handle_scope(env->isolate());
   Context::Scope context_scope(env->context());
@@ -163,6 +173,9 @@ int NewSessionCallback(SSL* s, SSL_SESSION* sess) {
   HandleScope handle_scope(env->isolate());
   Context::Scope context_scope(env->context());
 
+  if (w->is_server() && w->uses_shared_session_cache())
+    SharedSessionCache::Get()->Add(w->shared_session_namespace(), sess);
+
   if (!w->has_session_callbacks()) [[unlikely]]
     return 0;
 
@@ -210,9 +223,12 @@ int NewSessionCallback(SSL* s, SSL_SESSION* sess) {
 int SSLCertCallback(SSL* s, void* arg) {
   TLSWrap* w = static_cast<TLSWrap*>(SSL_get_app_data(s));
 
-  if (!w->is_server() || !w->is_waiting_cert_cb())
+  if (!w->is_server())
     return 1;
 
+  if (!w->is_waiting_cert_cb())
+    return w->StartAsyncHandshake() ? -1 : 1;
+
   if (w->is_cert_cb_running())
     // Not an error. Suspend handshake with SSL_ERROR_WANT_X509_LOOKUP, and
     // handshake will continue after certcb is done.
@@ -243,7 +259,9 @@ int SSLCertCallback(SSL* s, void* arg) {
   Local<Value> argv[] = { info };
   w->MakeCallback(env->oncertcb_string(), arraysize(argv), argv);
 
-  return w->is_cert_cb_running() ? -1 : 1;
+  if (w->is_cert_cb_running())
+    return -1;
+  return w->StartAsyncHandshake() ? -1 : 1;
 }
 
 int SelectALPNCallback(
@@ -603,6 +621,15 @@ void TLSWrap::SSLInfoCallback(const SSL* ssl_, int where, int ret) {
   // SSL_renegotiate_pending() should take `const SSL*`, but it does not.
   SSL* ssl = const_cast<SSL*>(ssl_);
   TLSWrap* c = static_cast<TLSWrap*>(SSL_get_app_data(ssl_));
+#ifdef NODE_ASYNC_PRIVATE_KEY
+  // JS can't run on the stack of an ASYNC job, RunDeferredCallbacks() reports
+  // the event once the job is done.
+  if (ASYNC_get_current_job() != nullptr) {
+    c->deferred_info_where_ |=
+        where & (SSL_CB_HANDSHAKE_START | SSL_CB_HANDSHAKE_DONE);
+    return;
+  }
+#endif  // NODE_ASYNC_PRIVATE_KEY
   Environment* env = c->env();
   HandleScope handle_scope(env->isolate());
   Context::Scope context_scope(env->context());
@@ -802,11 +829,44 @@ void TLSWrap::ClearOut() {
     return;
   }
 
+#ifdef NODE_ASYNC_PRIVATE_KEY
+  if (private_key_work_ != nullptr) {
+    Debug(this, "Returning from ClearOut(), private key operation pending");
+    return;
+  }
+#endif  // NODE_ASYNC_PRIVATE_KEY
+
   MarkPopErrorOnReturn mark_pop_error_on_return;
 
   char out[kClearOutChunkSize];
-  int read;
-  for (;;) {
+  int read = 1;
+  // A paused ASYNC job is resumed with the arguments it was started with, so
+  // it can't be started by SSL_read() with `out`. Drive the handshake on its
+  // own until the job is done, then go back to running it on this stack.
+  if (in_async_handshake()) {
+    read = SSL_do_handshake(ssl_.get());
+    Debug(this, "Async handshake returned %d", read);
+    const int err =
+        read == 1 ? SSL_ERROR_NONE : SSL_get_error(ssl_.get(), read);
+    if (err != SSL_ERROR_WANT_ASYNC)
+      SSL_clear_mode(ssl_.get(), SSL_MODE_ASYNC);
+    if (err == SSL_ERROR_NONE || err == SSL_ERROR_WANT_READ ||
+        err == SSL_ERROR_WANT_WRITE) {
+      // Caveat emptor: this calls into JS land, check ssl_ again. SSL_read()
+      // below continues the handshake, or finds out it has to wait, again.
+      if (!RunDeferredCallbacks()) {
+        Debug(this, "Returning from ClearOut(), ssl_ == nullptr");
+        return;
+      }
+      read = 1;
+      ClearIn();
+      if (ssl_ == nullptr) {
+        Debug(this, "Returning from ClearOut(), ssl_ == nullptr");
+        return;
+      }
+    }
+  }
+  while (read > 0) {
     read = SSL_read(ssl_.get(), out, sizeof(out));
     Debug(this, "Read %d bytes of cleartext output", read);
 
@@ -892,6 +952,19 @@ void TLSWrap::ClearOut() {
         }
         break;
 
+#ifdef NODE_ASYNC_PRIVATE_KEY
+      case SSL_ERROR_WANT_ASYNC:
+        StartPrivateKeyWork();
+        return;
+
+      case SSL_ERROR_WANT_X509_LOOKUP:
+        // SSLCertCallback() paused the handshake to move it into an ASYNC
+        // job, resume it right away.
+        if (in_async_handshake())
+          ClearOut();
+        return;
+#endif  // NODE_ASYNC_PRIVATE_KEY
+
       default:
         return;
     }
@@ -925,6 +998,11 @@ void TLSWrap::ClearIn() {
     return;
   }
 
+  if (in_async_handshake()) {
+    Debug(this, "Returning from ClearIn(), async handshake in progress");
+    return;
+  }
+
   std::unique_ptr<BackingStore> bs = std::move(pending_cleartext_input_);
   MarkPopErrorOnReturn mark_pop_error_on_return;
 
@@ -1084,7 +1162,11 @@ int TLSWrap::DoWrite(WriteWrap* w,
   // of data supplied to end() there is no sense allocating
   // and copying it when it could just be used.
 
-  if (nonempty_count != 1) {
+  // SSL_write() would start the handshake job with buffers that can be gone
+  // when it is resumed, so the data waits for ClearIn() in that case.
+  const bool defer_write = in_async_handshake();
+
+  if (nonempty_count != 1 || defer_write) {
     bs = ArrayBuffer::NewBackingStore(
         env()->isolate(),
         length,
@@ -1096,8 +1178,12 @@ int TLSWrap::DoWrite(WriteWrap* w,
       offset += bufs[i].len;
     }
 
-    NodeBIO::FromBIO(enc_out_)->set_allocate_tls_hint(length);
-    written = SSL_write(ssl_.get(), bs->Data(), length);
+    if (defer_write) {
+      written = -1;
+    } else {
+      NodeBIO::FromBIO(enc_out_)->set_allocate_tls_hint(length);
+      written = SSL_write(ssl_.get(), bs->Data(), length);
+    }
   } else {
     // Only one buffer: try to write directly, only store if it fails
     uv_buf_t* buf = &bufs[nonempty_i];
@@ -1118,7 +1204,8 @@ int TLSWrap::DoWrite(WriteWrap* w,
 
   if (written == -1) {
     // If we stopped writing because of an error, it's fatal, discard the data.
-    int err = SSL_get_error(ssl_.get(), written);
+    int err = defer_write ? SSL_ERROR_WANT_WRITE
+                          : SSL_get_error(ssl_.get(), written);
     if (err == SSL_ERROR_SSL || err == SSL_ERROR_SYSCALL) {
       // TODO(@jasnell): What are we doing with the error?
       Debug(this, "Got SSL error (%d), returning UV_EPROTO", err);
@@ -1300,6 +1387,109 @@ void TLSWrap::EnableTrace(const FunctionCallbackInfo<Value>& args) {
 #endif
 }
 
+#ifdef NODE_ASYNC_PRIVATE_KEY
+// Runs the private key operation a handshake job paused for, then resumes
+// the handshake from ClearOut().
+class TLSWrap::PrivateKeyWork final : public ThreadPoolWork {
+ public:
+  PrivateKeyWork(TLSWrap* wrap, PrivateKeyOp* op)
+      : ThreadPoolWork(wrap->env(), "tlsprivatekey"), wrap_(wrap), op_(op) {}
+
+  // Keeps the SSL of a destroyed TLSWrap until the operation is done.
+  void TakeSSL(SSLPointer&& ssl) { ssl_ = std::move(ssl); }
+
+  void DoThreadPoolWork() override { op_->DoWork(); }
+
+  void AfterThreadPoolWork(int status) override {
+    std::unique_ptr<PrivateKeyWork> self(this);
+    CHECK_EQ(status, 0);
+    wrap_->private_key_work_ = nullptr;
+
+    if (ssl_) {
+      // Let the job fail right away instead of finishing the handshake of a
+      // connection nobody is listening to, so that it can be freed.
+      ClearErrorOnReturn clear_error_on_return;
+      op_->Cancel();
+      SSL_do_handshake(ssl_.get());
+      return;
+    }
+
+    HandleScope handle_scope(env()->isolate());
+    Context::Scope context_scope(env()->context());
+    wrap_->Cycle();
+  }
+
+ private:
+  BaseObjectPtr<TLSWrap> wrap_;
+  PrivateKeyOp* op_;
+  SSLPointer ssl_;
+};
+
+void TLSWrap::StartPrivateKeyWork() {
+  CHECK_NULL(private_key_work_);
+  PrivateKeyOp* op = PrivateKeyOp::TakePending();
+  CHECK_NOT_NULL(op);
+  Debug(this, "Running private key operation on the threadpool");
+  private_key_work_ = new PrivateKeyWork(this, op);
+  private_key_work_->ScheduleWork();
+}
+
+bool TLSWrap::RunDeferredCallbacks() {
+  std::vector<std::string> keylog = std::move(deferred_keylog_);
+  const int where = deferred_info_where_;
+  deferred_info_where_ = 0;
+
+  for (const std::string& line : keylog) {
+    KeylogCallback(ssl_.get(), line.c_str());
+    if (ssl_ == nullptr) return false;
+  }
+  if (where != 0) {
+    SSLInfoCallback(ssl_.get(), where, 1);
+    if (ssl_ == nullptr) return false;
+  }
+  return true;
+}
+#endif  // NODE_ASYNC_PRIVATE_KEY
+
+bool TLSWrap::StartAsyncHandshake() {
+#ifdef NODE_ASYNC_PRIVATE_KEY
+  // The key of an SNI context is the one that signs.
+  SecureContext* sc = static_cast<SecureContext*>(
+      SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl_.get())));
+  // Only the initial handshake of a server, whose cert callback is the last
+  // step that can call into JS before the server signs. The exception is the
+  // ALPN callback of TLS 1.2, which OpenSSL runs after the cert callback.
+  if (!is_server() || established_ || in_async_handshake() ||
+      sc == nullptr || !sc->uses_async_private_key() ||
+      (alpn_callback_enabled_ && SSL_version(ssl_.get()) < TLS1_3_VERSION)) {
+    return false;
+  }
+  Debug(this, "Continuing handshake in an ASYNC job");
+  SSL_set_mode(ssl_.get(), SSL_MODE_ASYNC);
+  return true;
+#else
+  return false;
+#endif  // NODE_ASYNC_PRIVATE_KEY
+}
+
+bool TLSWrap::DeferKeylog(const char* line) {
+#ifdef NODE_ASYNC_PRIVATE_KEY
+  if (ASYNC_get_current_job() != nullptr) {
+    deferred_keylog_.emplace_back(line);
+    return true;
+  }
+#endif  // NODE_ASYNC_PRIVATE_KEY
+  return false;
+}
+
+bool TLSWrap::in_async_handshake() const {
+#ifdef NODE_ASYNC_PRIVATE_KEY
+  return ssl_ && (SSL_get_mode(ssl_.get()) & SSL_MODE_ASYNC) != 0;
+#else
+  return false;
+#endif  // NODE_ASYNC_PRIVATE_KEY
+}
+
 void TLSWrap::DestroySSL(const FunctionCallbackInfo<Value>& args) {
   TLSWrap* wrap;
   ASSIGN_OR_RETURN_UNWRAP(&wrap, args.This());
@@ -1318,6 +1508,11 @@ void TLSWrap::Destroy() {
   InvokeQueued(UV_ECANCELED, "Canceled because of SSL destruction");
 
   env()->external_memory_accounter()->Decrease(env()->isolate(), kExternalSize);
+#ifdef NODE_ASYNC_PRIVATE_KEY
+  // The paused handshake job still uses the SSL.
+  if (private_key_work_ != nullptr)
+    private_key_work_->TakeSSL(std::move(ssl_));
+#endif  // NODE_ASYNC_PRIVATE_KEY
   ssl_.reset();
 
   enc_in_ = nullptr;
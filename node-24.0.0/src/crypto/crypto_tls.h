@@ -69,6 +69,12 @@ class TLSWrap : public AsyncWrap,
   inline bool is_server() const { return kind_ == Kind::kServer; }
   inline bool is_client() const { return kind_ == Kind::kClient; }
   inline bool is_awaiting_new_session() const { return awaiting_new_session_; }
+  inline bool uses_shared_session_cache() const {
+    return sc_ && sc_->uses_shared_session_cache();
+  }
+  inline const std::string& shared_session_namespace() const {
+    return sc_->shared_session_namespace();
+  }
 
   // Implement StreamBase:
   bool IsAlive() override;
@@ -100,6 +106,13 @@ class TLSWrap : public AsyncWrap,
   // Called by the done() callback of the 'newSession' event.
   void NewSessionDoneCb();
 
+  // Called by the cert callback once the callbacks for the ClientHello are
+  // done. Returns true if the rest of the handshake is to run in an ASYNC job
+  // so that the private key operation can be offloaded, see ClearOut().
+  bool StartAsyncHandshake();
+  // Returns true if `line` is kept for after the handshake job.
+  bool DeferKeylog(const char* line);
+
   // Implement MemoryRetainer:
   void MemoryInfo(MemoryTracker* tracker) const override;
   SET_MEMORY_INFO_NAME(TLSWrap)
@@ -156,6 +169,17 @@ class TLSWrap : public AsyncWrap,
   void ClearOut();  // SSL_read() clear text "out" from SSL.
   void Destroy();
 
+  // True while the handshake runs in an OpenSSL ASYNC job, which is the case
+  // with a SecureContext that uses enableAsyncPrivateKey(). See ClearOut().
+  bool in_async_handshake() const;
+#ifdef NODE_ASYNC_PRIVATE_KEY
+  class PrivateKeyWork;
+  void StartPrivateKeyWork();
+  // Emits the events that happened inside the handshake job. Returns false if
+  // ssl_ was destroyed by JS.
+  bool RunDeferredCallbacks();
+#endif
+
   // Call Done() on outstanding WriteWrap request.
   void InvokeQueued(int status, const char* error_str = nullptr);
 
@@ -262,6 +286,13 @@ class TLSWrap : public AsyncWrap,
   BIO* enc_out_ = nullptr;  // SSL_write()/handshake fills this for EncOut().
   // Waiting for ClearIn() to pass to SSL_write().
   std::unique_ptr<v8::BackingStore> pending_cleartext_input_;
+#ifdef NODE_ASYNC_PRIVATE_KEY
+  // The handshake is paused until it is done.
+  PrivateKeyWork* private_key_work_ = nullptr;
+  // SSLInfoCallback() and keylog events from inside the handshake job.
+  int deferred_info_where_ = 0;
+  std::vector<std::string> deferred_keylog_;
+#endif
   size_t write_size_ = 0;
   BaseObjectPtr<AsyncWrap> current_write_;
   BaseObjectPtr<AsyncWrap> current_empty_write_;
@@ -18,6 +18,7 @@
 #include "node_worker.h"
 #include "req_wrap-inl.h"
 #include "stream_base.h"
+#include "stream_wrap.h"
 #include "tracing/agent.h"
 #include "tracing/traced_value.h"
 #include "util-inl.h"
@@ -1088,6 +1089,10 @@ void Environment::InitializeLibuv() {
     }
   }
 
+  // TCP writes staged for the next loop iteration would otherwise be lost
+  // when the process exits first.
+  AtExit(LibuvStreamWrap::FlushCorkedWritesAtExit, this);
+
   StartProfilerIdleNotifier();
   env_handle_initialized_ = true;
 }
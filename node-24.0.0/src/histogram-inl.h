@@ -79,6 +79,16 @@ bool Histogram::Record(int64_t value) {
   return recorded;
 }
 
+bool Histogram::RecordValues(int64_t value, int64_t count) {
+  Mutex::ScopedLock lock(mutex_);
+  bool recorded = hdr_record_values(histogram_.get(), value, count);
+  if (!recorded)
+    exceeds_ += count;
+  else
+    count_ += count;
+  return recorded;
+}
+
 uint64_t Histogram::RecordDelta() {
   Mutex::ScopedLock lock(mutex_);
   uint64_t time = uv_hrtime();
@@ -34,6 +34,8 @@ class Histogram : public MemoryRetainer {
   virtual ~Histogram() = default;
 
   inline bool Record(int64_t value);
+  // Records `count` occurrences of `value` at once.
+  inline bool RecordValues(int64_t value, int64_t count);
   inline void Reset();
   inline int64_t Min() const;
   inline int64_t Max() const;
@@ -22,6 +22,7 @@
 #include "node_buffer.h"
 #include "node.h"
 #include "node_blob.h"
+#include "node_buffer_search.h"
 #include "node_debug.h"
 #include "node_errors.h"
 #include "node_external_reference.h"
@@ -883,6 +884,39 @@ int32_t FastCompare(Local<Value>,
 
 static CFunction fast_compare(CFunction::Make(FastCompare));
 
+// Same as nbytes::SearchString(), but uses the SIMD kernels of
+// node_buffer_search.h for forward searches where they beat
+// Boyer-Moore-Horspool: single characters are already found with memchr(),
+// and long needles let BMH skip further than a vector is wide.
+template <typename Char>
+size_t SearchString(const Char* haystack,
+                    size_t haystack_length,
+                    const Char* needle,
+                    size_t needle_length,
+                    size_t start_index,
+                    bool is_forward) {
+#ifdef NODE_BUFFER_SIMD_SEARCH
+  constexpr size_t kMaxSimdNeedleBytes = 32;
+  if (is_forward && needle_length >= 2 &&
+      needle_length * sizeof(Char) <= kMaxSimdNeedleBytes &&
+      needle_length <= haystack_length) {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2) {
+      return SearchAVX2(
+          haystack, haystack_length, needle, needle_length, start_index);
+    }
+    return SearchSSE2(
+        haystack, haystack_length, needle, needle_length, start_index);
+  }
+#endif  // NODE_BUFFER_SIMD_SEARCH
+  return nbytes::SearchString(haystack,
+                              haystack_length,
+                              needle,
+                              needle_length,
+                              start_index,
+                              is_forward);
+}
+
 // Computes the offset for starting an indexOf or lastIndexOf search.
 // Returns either a valid offset in [0...<length - 1>], ie inside the Buffer,
 // or -1 to signal that there is no possible match.
@@ -991,20 +1025,19 @@ void IndexOfString(const FunctionCallbackInfo<Value>& args) {
       if (decoded_string == nullptr)
         return args.GetReturnValue().Set(-1);
 
-      result = nbytes::SearchString(reinterpret_cast<const uint16_t*>(haystack),
-                                    haystack_length / 2,
-                                    decoded_string,
-                                    decoder.size() / 2,
-                                    offset / 2,
-                                    is_forward);
+      result = SearchString(reinterpret_cast<const uint16_t*>(haystack),
+                            haystack_length / 2,
+                            decoded_string,
+                            decoder.size() / 2,
+                            offset / 2,
+                            is_forward);
     } else {
-      result =
-          nbytes::SearchString(reinterpret_cast<const uint16_t*>(haystack),
-                               haystack_length / 2,
-                               reinterpret_cast<const uint16_t*>(*needle_value),
-                               needle_value.length(),
-                               offset / 2,
-                               is_forward);
+      result = SearchString(reinterpret_cast<const uint16_t*>(haystack),
+                            haystack_length / 2,
+                            reinterpret_cast<const uint16_t*>(*needle_value),
+                            needle_value.length(),
+                            offset / 2,
+                            is_forward);
     }
     result *= 2;
   } else if (enc == UTF8) {
@@ -1012,13 +1045,12 @@ void IndexOfString(const FunctionCallbackInfo<Value>& args) {
     if (*needle_value == nullptr)
       return args.GetReturnValue().Set(-1);
 
-    result =
-        nbytes::SearchString(reinterpret_cast<const uint8_t*>(haystack),
-                             haystack_length,
-                             reinterpret_cast<const uint8_t*>(*needle_value),
-                             needle_length,
-                             offset,
-                             is_forward);
+    result = SearchString(reinterpret_cast<const uint8_t*>(haystack),
+                          haystack_length,
+                          reinterpret_cast<const uint8_t*>(*needle_value),
+                          needle_length,
+                          offset,
+                          is_forward);
   } else if (enc == LATIN1) {
     uint8_t* needle_data = node::UncheckedMalloc<uint8_t>(needle_length);
     if (needle_data == nullptr) {
@@ -1027,12 +1059,12 @@ void IndexOfString(const FunctionCallbackInfo<Value>& args) {
     needle->WriteOneByte(
         isolate, needle_data, 0, needle_length, String::NO_NULL_TERMINATION);
 
-    result = nbytes::SearchString(reinterpret_cast<const uint8_t*>(haystack),
-                                  haystack_length,
-                                  needle_data,
-                                  needle_length,
-                                  offset,
-                                  is_forward);
+    result = SearchString(reinterpret_cast<const uint8_t*>(haystack),
+                          haystack_length,
+                          needle_data,
+                          needle_length,
+                          offset,
+                          is_forward);
     free(needle_data);
   }
 
@@ -1091,20 +1123,20 @@ void IndexOfBuffer(const FunctionCallbackInfo<Value>& args) {
     if (haystack_length < 2 || needle_length < 2) {
       return args.GetReturnValue().Set(-1);
     }
-    result = nbytes::SearchString(reinterpret_cast<const uint16_t*>(haystack),
-                                  haystack_length / 2,
-                                  reinterpret_cast<const uint16_t*>(needle),
-                                  needle_length / 2,
-                                  offset / 2,
-                                  is_forward);
+    result = SearchString(reinterpret_cast<const uint16_t*>(haystack),
+                          haystack_length / 2,
+                          reinterpret_cast<const uint16_t*>(needle),
+                          needle_length / 2,
+                          offset / 2,
+                          is_forward);
     result *= 2;
   } else {
-    result = nbytes::SearchString(reinterpret_cast<const uint8_t*>(haystack),
-                                  haystack_length,
-                                  reinterpret_cast<const uint8_t*>(needle),
-                                  needle_length,
-                                  offset,
-                                  is_forward);
+    result = SearchString(reinterpret_cast<const uint8_t*>(haystack),
+                          haystack_length,
+                          reinterpret_cast<const uint8_t*>(needle),
+                          needle_length,
+                          offset,
+                          is_forward);
   }
 
   args.GetReturnValue().Set(
@@ -0,0 +1,132 @@
+#ifndef SRC_NODE_BUFFER_SEARCH_H_
+#define SRC_NODE_BUFFER_SEARCH_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define NODE_BUFFER_SIMD_SEARCH 1
+#endif
+
+#ifdef NODE_BUFFER_SIMD_SEARCH
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace node {
+namespace Buffer {
+
+// Forward substring search for needles of at least two characters. Every
+// step compares the first and the last character of the needle against a
+// whole vector of haystack positions, only positions where both match are
+// checked with memcmp(). Lengths and the result are in characters, the
+// result is haystack_length if there is no match, like nbytes::SearchString.
+template <typename Char>
+size_t SearchTail(const Char* haystack,
+                  size_t haystack_length,
+                  const Char* needle,
+                  size_t needle_length,
+                  size_t i) {
+  for (; i + needle_length <= haystack_length; i++) {
+    if (haystack[i] == needle[0] &&
+        memcmp(haystack + i, needle, needle_length * sizeof(Char)) == 0) {
+      return i;
+    }
+  }
+  return haystack_length;
+}
+
+template <typename Char>
+size_t SearchSSE2(const Char* haystack,
+                  size_t haystack_length,
+                  const Char* needle,
+                  size_t needle_length,
+                  size_t i) {
+  constexpr size_t kStep = sizeof(__m128i) / sizeof(Char);
+  const size_t last = needle_length - 1;
+  __m128i first_char, last_char;
+  if constexpr (sizeof(Char) == 1) {
+    first_char = _mm_set1_epi8(static_cast<char>(needle[0]));
+    last_char = _mm_set1_epi8(static_cast<char>(needle[last]));
+  } else {
+    first_char = _mm_set1_epi16(static_cast<int16_t>(needle[0]));
+    last_char = _mm_set1_epi16(static_cast<int16_t>(needle[last]));
+  }
+
+  for (; i + last + kStep <= haystack_length; i += kStep) {
+    const __m128i block_first =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i));
+    const __m128i block_last =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i + last));
+    __m128i eq;
+    if constexpr (sizeof(Char) == 1) {
+      eq = _mm_and_si128(_mm_cmpeq_epi8(block_first, first_char),
+                         _mm_cmpeq_epi8(block_last, last_char));
+    } else {
+      eq = _mm_and_si128(_mm_cmpeq_epi16(block_first, first_char),
+                         _mm_cmpeq_epi16(block_last, last_char));
+    }
+    // One bit per byte, so two-byte characters set two bits per position.
+    uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+    while (mask != 0) {
+      const size_t pos = i + __builtin_ctz(mask) / sizeof(Char);
+      if (memcmp(haystack + pos, needle, needle_length * sizeof(Char)) == 0)
+        return pos;
+      mask &= mask - 1;
+      if constexpr (sizeof(Char) == 2) mask &= mask - 1;
+    }
+  }
+  return SearchTail(haystack, haystack_length, needle, needle_length, i);
+}
+
+template <typename Char>
+__attribute__((target("avx2"))) size_t SearchAVX2(const Char* haystack,
+                                                  size_t haystack_length,
+                                                  const Char* needle,
+                                                  size_t needle_length,
+                                                  size_t i) {
+  constexpr size_t kStep = sizeof(__m256i) / sizeof(Char);
+  const size_t last = needle_length - 1;
+  __m256i first_char, last_char;
+  if constexpr (sizeof(Char) == 1) {
+    first_char = _mm256_set1_epi8(static_cast<char>(needle[0]));
+    last_char = _mm256_set1_epi8(static_cast<char>(needle[last]));
+  } else {
+    first_char = _mm256_set1_epi16(static_cast<int16_t>(needle[0]));
+    last_char = _mm256_set1_epi16(static_cast<int16_t>(needle[last]));
+  }
+
+  for (; i + last + kStep <= haystack_length; i += kStep) {
+    const __m256i block_first =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i));
+    const __m256i block_last = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(haystack + i + last));
+    __m256i eq;
+    if constexpr (sizeof(Char) == 1) {
+      eq = _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first_char),
+                            _mm256_cmpeq_epi8(block_last, last_char));
+    } else {
+      eq = _mm256_and_si256(_mm256_cmpeq_epi16(block_first, first_char),
+                            _mm256_cmpeq_epi16(block_last, last_char));
+    }
+    // One bit per byte, so two-byte characters set two bits per position.
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+    while (mask != 0) {
+      const size_t pos = i + __builtin_ctz(mask) / sizeof(Char);
+      if (memcmp(haystack + pos, needle, needle_length * sizeof(Char)) == 0)
+        return pos;
+      mask &= mask - 1;
+      if constexpr (sizeof(Char) == 2) mask &= mask - 1;
+    }
+  }
+  return SearchTail(haystack, haystack_length, needle, needle_length, i);
+}
+
+}  // namespace Buffer
+}  // namespace node
+
+#endif  // NODE_BUFFER_SIMD_SEARCH
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_NODE_BUFFER_SEARCH_H_
@@ -76,6 +76,11 @@ using CFunctionWithInt64Fallback = void (*)(v8::Local<v8::Value>,
 using CFunctionWithBool = void (*)(v8::Local<v8::Value>,
                                    v8::Local<v8::Value>,
                                    bool);
+using CFunctionReturnInt32 = int32_t (*)(v8::Local<v8::Value> receiver);
+using CFunctionWithBoolReturnInt32 = int32_t (*)(v8::Local<v8::Value> receiver,
+                                                 bool);
+using CFunctionWithBoolUint32ReturnInt32 =
+    int32_t (*)(v8::Local<v8::Value> receiver, bool, uint32_t);
 
 using CFunctionWriteString = uint32_t (*)(v8::Local<v8::Value>,
                                           v8::Local<v8::Value>,
@@ -119,6 +124,9 @@ class ExternalReferenceRegistry {
   V(CFunctionWithDoubleReturnDouble)                                           \
   V(CFunctionWithInt64Fallback)                                                \
   V(CFunctionWithBool)                                                         \
+  V(CFunctionReturnInt32)                                                      \
+  V(CFunctionWithBoolReturnInt32)                                              \
+  V(CFunctionWithBoolUint32ReturnInt32)                                        \
   V(CFunctionBufferCopy)                                                       \
   V(CFunctionWriteString)                                                      \
   V(const v8::CFunctionInfo*)                                                  \
@@ -52,6 +52,7 @@
 #ifdef _WIN32
 #include <windows.h>
 #else
+#include <sys/mman.h>
 #include <unistd.h>
 #endif
 
@@ -60,6 +61,8 @@ namespace node {
 namespace fs {
 
 using v8::Array;
+using v8::ArrayBuffer;
+using v8::BackingStore;
 using v8::BigInt;
 using v8::Context;
 using v8::EscapableHandleScope;
@@ -137,6 +140,7 @@ static const char* get_fs_func_name_by_type(uv_fs_type req_type) {
     FS_TYPE_TO_NAME(STATFS, "statfs")
     FS_TYPE_TO_NAME(MKSTEMP, "mkstemp")
     FS_TYPE_TO_NAME(LUTIME, "lutime")
+    FS_TYPE_TO_NAME(BATCH, "batch")
 #undef FS_TYPE_TO_NAME
     default:
       return "unknown";
@@ -799,6 +803,70 @@ void AfterStat(uv_fs_t* req) {
   }
 }
 
+// The sub-requests of a uv_fs_batch() are allocated by statMany() and
+// readMany() and released here, once the batch is done or failed to start.
+static void FreeBatch(uv_fs_t* reqs, unsigned int nreqs) {
+  for (unsigned int i = 0; i < nreqs; i++)
+    uv_fs_req_cleanup(&reqs[i]);
+  delete[] reqs;
+}
+
+// Resolves with [results, stats], where results holds 0 or the error of
+// each stat() and stats holds kFsStatsFieldsNumber fields per path.
+template <typename AliasedStatsArray>
+static Local<Value> BatchStatsResult(Isolate* isolate,
+                                     uv_fs_t* reqs,
+                                     unsigned int nreqs) {
+  constexpr size_t kFields =
+      static_cast<size_t>(FsStatsOffset::kFsStatsFieldsNumber);
+  AliasedInt32Array results(isolate, nreqs);
+  AliasedStatsArray stats(isolate, nreqs * kFields);
+  for (unsigned int i = 0; i < nreqs; i++) {
+    results.SetValue(i, static_cast<int32_t>(reqs[i].result));
+    if (reqs[i].result == 0)
+      FillStatsArray(&stats, &reqs[i].statbuf, i * kFields);
+  }
+  Local<Value> result[] = {results.GetJSArray(), stats.GetJSArray()};
+  return Array::New(isolate, result, arraysize(result));
+}
+
+void AfterStatMany(uv_fs_t* req) {
+  FSReqBase* req_wrap = FSReqBase::from_req(req);
+  FSReqAfterScope after(req_wrap, req);
+  uv_fs_t* reqs = static_cast<uv_fs_t*>(req->ptr);
+  const unsigned int nreqs = reqs != nullptr ? req->nbufs : 0;
+  FS_ASYNC_TRACE_END1(
+      req->fs_type, req_wrap, "result", static_cast<int>(req->result))
+  if (after.Proceed()) {
+    Isolate* isolate = req_wrap->env()->isolate();
+    req_wrap->Resolve(
+        req_wrap->use_bigint()
+            ? BatchStatsResult<AliasedBigInt64Array>(isolate, reqs, nreqs)
+            : BatchStatsResult<AliasedFloat64Array>(isolate, reqs, nreqs));
+  }
+  if (reqs != nullptr)
+    FreeBatch(reqs, nreqs);
+}
+
+// Resolves with an Int32Array holding the number of bytes read or the error
+// of each read().
+void AfterReadMany(uv_fs_t* req) {
+  FSReqBase* req_wrap = FSReqBase::from_req(req);
+  FSReqAfterScope after(req_wrap, req);
+  uv_fs_t* reqs = static_cast<uv_fs_t*>(req->ptr);
+  const unsigned int nreqs = reqs != nullptr ? req->nbufs : 0;
+  FS_ASYNC_TRACE_END1(
+      req->fs_type, req_wrap, "result", static_cast<int>(req->result))
+  if (after.Proceed()) {
+    AliasedInt32Array results(req_wrap->env()->isolate(), nreqs);
+    for (unsigned int i = 0; i < nreqs; i++)
+      results.SetValue(i, static_cast<int32_t>(reqs[i].result));
+    req_wrap->Resolve(results.GetJSArray());
+  }
+  if (reqs != nullptr)
+    FreeBatch(reqs, nreqs);
+}
+
 void AfterStatFs(uv_fs_t* req) {
   FSReqBase* req_wrap = FSReqBase::from_req(req);
   FSReqAfterScope after(req_wrap, req);
@@ -1237,6 +1305,55 @@ static void FStat(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
+// statMany(paths, use_bigint, req)
+//
+// Stats all paths in a single uv_fs_batch(), i.e. one threadpool round trip
+// and one callback instead of one per path.
+static void StatMany(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+
+  const int argc = args.Length();
+  CHECK_GE(argc, 3);
+
+  CHECK(args[0]->IsArray());
+  Local<Array> paths_arr = args[0].As<Array>();
+  bool use_bigint = args[1]->IsTrue();
+  FSReqBase* req_wrap_async = GetReqWrap(args, 2, use_bigint);
+  CHECK_NOT_NULL(req_wrap_async);
+
+  std::vector<std::string> paths;
+  paths.reserve(paths_arr->Length());
+  for (uint32_t i = 0; i < paths_arr->Length(); i++) {
+    Local<Value> value;
+    if (!paths_arr->Get(env->context(), i).ToLocal(&value)) return;
+    BufferValue path(isolate, value);
+    CHECK_NOT_NULL(*path);
+    ToNamespacedPath(env, &path);
+    ASYNC_THROW_IF_INSUFFICIENT_PERMISSIONS(
+        env,
+        req_wrap_async,
+        permission::PermissionScope::kFileSystemRead,
+        path.ToStringView());
+    paths.emplace_back(path.ToStringView());
+  }
+
+  const unsigned int nreqs = paths.size();
+  uv_fs_t* reqs = new uv_fs_t[nreqs]();
+  for (unsigned int i = 0; i < nreqs; i++) {
+    // A null loop only prepares the request, the path is copied.
+    CHECK_EQ(uv_fs_stat(nullptr, &reqs[i], paths[i].c_str(), AfterStatMany),
+             0);
+  }
+
+  FS_ASYNC_TRACE_BEGIN1(
+      UV_FS_BATCH, req_wrap_async, "count", static_cast<int>(nreqs))
+  if (AsyncCall(env, req_wrap_async, args, "stat", UTF8, AfterStatMany,
+                uv_fs_batch, reqs, nreqs) == nullptr) {
+    FreeBatch(reqs, nreqs);
+  }
+}
+
 static void StatFs(const FunctionCallbackInfo<Value>& args) {
   Realm* realm = Realm::GetCurrent(args);
   BindingData* binding_data = realm->GetBindingData<BindingData>();
@@ -2755,6 +2872,90 @@ static void ReadFileUtf8(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(val);
 }
 
+// readFileMapped(path, flags, threshold)
+//
+// Maps a regular file of at least threshold bytes and returns a Buffer backed
+// by the mapping, which is unmapped once the Buffer is collected. The mapping
+// is private, so writes to the Buffer don't reach the file. Truncating the
+// file while the Buffer is alive would make accesses past the new end fault,
+// so only files without any write permission are mapped, like deployed static
+// assets. Returns undefined for all other files, for smaller ones, and where
+// mappings can't back a Buffer, so that the caller reads the file as usual.
+static void ReadFileMapped(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  CHECK_GE(args.Length(), 3);
+
+  CHECK(args[1]->IsInt32());
+  const int flags = args[1].As<Int32>()->Value();
+
+  CHECK(IsSafeJsInt(args[2]));
+  const int64_t threshold = args[2].As<Integer>()->Value();
+
+  BufferValue path(env->isolate(), args[0]);
+  CHECK_NOT_NULL(*path);
+  ToNamespacedPath(env, &path);
+  if (CheckOpenPermissions(env, path, flags).IsNothing()) return;
+
+#if defined(_WIN32) || defined(V8_ENABLE_SANDBOX)
+  // No mmap(), or no external backing stores with the sandbox.
+  USE(threshold);
+  return;
+#else
+  uv_fs_t req;
+  FS_SYNC_TRACE_BEGIN(open);
+  uv_file file = uv_fs_open(nullptr, &req, *path, flags, 0666, nullptr);
+  FS_SYNC_TRACE_END(open);
+  uv_fs_req_cleanup(&req);
+  if (file < 0) {
+    return env->ThrowUVException(file, "open", nullptr, path.out());
+  }
+
+  auto defer_close = OnScopeLeave([file, &req]() {
+    FS_SYNC_TRACE_BEGIN(close);
+    CHECK_EQ(0, uv_fs_close(nullptr, &req, file, nullptr));
+    FS_SYNC_TRACE_END(close);
+    uv_fs_req_cleanup(&req);
+  });
+
+  FS_SYNC_TRACE_BEGIN(fstat);
+  int err = uv_fs_fstat(nullptr, &req, file, nullptr);
+  FS_SYNC_TRACE_END(fstat);
+  if (err < 0) {
+    return env->ThrowUVException(err, "fstat", nullptr, path.out());
+  }
+  // Files in procfs and friends report a size of 0 and are left to reads.
+  const uv_stat_t* s = static_cast<const uv_stat_t*>(req.ptr);
+  if (!S_ISREG(s->st_mode) || (s->st_mode & (S_IWUSR | S_IWGRP | S_IWOTH)) ||
+      s->st_size == 0 ||
+      static_cast<int64_t>(s->st_size) < threshold ||
+      s->st_size > Buffer::kMaxLength) {
+    return;
+  }
+  const size_t size = s->st_size;
+  uv_fs_req_cleanup(&req);
+
+  void* data =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+  if (data == MAP_FAILED) return;
+  // Start reading the whole file in, without blocking on it like
+  // MAP_POPULATE would.
+  madvise(data, size, MADV_WILLNEED);
+
+  std::unique_ptr<BackingStore> store = ArrayBuffer::NewBackingStore(
+      data,
+      size,
+      [](void* data, size_t length, void* deleter_data) {
+        munmap(data, length);
+      },
+      nullptr);
+  Local<ArrayBuffer> ab = ArrayBuffer::New(env->isolate(), std::move(store));
+  Local<Object> buffer;
+  if (!Buffer::New(env, ab, 0, size).ToLocal(&buffer)) return;
+  args.GetReturnValue().Set(buffer);
+#endif  // defined(_WIN32) || defined(V8_ENABLE_SANDBOX)
+}
+
 // Wrapper for readv(2).
 //
 // bytesRead = fs.readv(fd, buffers[, position], callback)
@@ -2804,6 +3005,66 @@ static void ReadBuffers(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
+// readMany(fds, buffers, positions, req)
+//
+// Reads buffers[i] from fds[i] at positions[i] (-1 for the current position)
+// for all i in a single uv_fs_batch(). The buffers have to be kept alive by
+// the caller until req completes, same as for read().
+static void ReadMany(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Local<Context> context = env->context();
+
+  const int argc = args.Length();
+  CHECK_GE(argc, 4);
+
+  CHECK(args[0]->IsArray());
+  CHECK(args[1]->IsArray());
+  CHECK(args[2]->IsArray());
+  Local<Array> fds = args[0].As<Array>();
+  Local<Array> buffers = args[1].As<Array>();
+  Local<Array> positions = args[2].As<Array>();
+  CHECK_EQ(buffers->Length(), fds->Length());
+  CHECK_EQ(positions->Length(), fds->Length());
+
+  FSReqBase* req_wrap_async = GetReqWrap(args, 3);
+  CHECK_NOT_NULL(req_wrap_async);
+
+  const unsigned int nreqs = fds->Length();
+  MaybeStackBuffer<uv_file> files(nreqs);
+  MaybeStackBuffer<uv_buf_t> iovs(nreqs);
+  MaybeStackBuffer<int64_t> pos(nreqs);
+  for (unsigned int i = 0; i < nreqs; i++) {
+    Local<Value> fd;
+    Local<Value> buffer;
+    Local<Value> position;
+    if (!fds->Get(context, i).ToLocal(&fd) ||
+        !buffers->Get(context, i).ToLocal(&buffer) ||
+        !positions->Get(context, i).ToLocal(&position)) {
+      return;
+    }
+    CHECK(fd->IsInt32());
+    CHECK(Buffer::HasInstance(buffer));
+    files[i] = fd.As<Int32>()->Value();
+    iovs[i] = uv_buf_init(Buffer::Data(buffer), Buffer::Length(buffer));
+    pos[i] = GetOffset(position);  // -1 if not a valid JS int
+  }
+
+  uv_fs_t* reqs = new uv_fs_t[nreqs]();
+  for (unsigned int i = 0; i < nreqs; i++) {
+    // A null loop only prepares the request, the buffer list is copied.
+    CHECK_EQ(uv_fs_read(nullptr, &reqs[i], files[i], &iovs[i], 1, pos[i],
+                        AfterReadMany),
+             0);
+  }
+
+  FS_ASYNC_TRACE_BEGIN1(
+      UV_FS_BATCH, req_wrap_async, "count", static_cast<int>(nreqs))
+  if (AsyncCall(env, req_wrap_async, args, "read", UTF8, AfterReadMany,
+                uv_fs_batch, reqs, nreqs) == nullptr) {
+    FreeBatch(reqs, nreqs);
+  }
+}
+
 
 /* fs.chmod(path, mode);
  * Wrapper for chmod(1) / EIO_CHMOD
@@ -3646,7 +3907,9 @@ static void CreatePerIsolateProperties(IsolateData* isolate_data,
   SetMethod(isolate, target, "openFileHandle", OpenFileHandle);
   SetMethod(isolate, target, "read", Read);
   SetMethod(isolate, target, "readFileUtf8", ReadFileUtf8);
+  SetMethod(isolate, target, "readFileMapped", ReadFileMapped);
   SetMethod(isolate, target, "readBuffers", ReadBuffers);
+  SetMethod(isolate, target, "readMany", ReadMany);
   SetMethod(isolate, target, "fdatasync", Fdatasync);
   SetMethod(isolate, target, "fsync", Fsync);
   SetMethod(isolate, target, "rename", Rename);
@@ -3663,6 +3926,7 @@ static void CreatePerIsolateProperties(IsolateData* isolate_data,
   SetMethod(isolate, target, "stat", Stat);
   SetMethod(isolate, target, "lstat", LStat);
   SetMethod(isolate, target, "fstat", FStat);
+  SetMethod(isolate, target, "statMany", StatMany);
   SetMethod(isolate, target, "statfs", StatFs);
   SetMethod(isolate, target, "link", Link);
   SetMethod(isolate, target, "symlink", Symlink);
@@ -3773,7 +4037,9 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(OpenFileHandle);
   registry->Register(Read);
   registry->Register(ReadFileUtf8);
+  registry->Register(ReadFileMapped);
   registry->Register(ReadBuffers);
+  registry->Register(ReadMany);
   registry->Register(Fdatasync);
   registry->Register(Fsync);
   registry->Register(Rename);
@@ -3788,6 +4054,7 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(Stat);
   registry->Register(LStat);
   registry->Register(FStat);
+  registry->Register(StatMany);
   registry->Register(StatFs);
   registry->Register(Link);
   registry->Register(Symlink);
@@ -619,6 +619,43 @@ void Message::MemoryInfo(MemoryTracker* tracker) const {
   tracker->TrackField("transferables", transferables_);
 }
 
+IncomingMessageQueue::IncomingMessageQueue()
+    : head_(new Node()), tail_(head_.load(std::memory_order_relaxed)) {}
+
+IncomingMessageQueue::~IncomingMessageQueue() {
+  Node* node = tail_;
+  while (node != nullptr) {
+    Node* next = node->next.load(std::memory_order_relaxed);
+    delete node;
+    node = next;
+  }
+}
+
+void IncomingMessageQueue::Push(std::shared_ptr<Message> message) {
+  Node* node = new Node();
+  node->message = std::move(message);
+  size_.fetch_add(1, std::memory_order_relaxed);
+  // Until `prev` is linked the consumer sees the queue ending at `prev`, the
+  // caller has to make sure it looks again afterwards.
+  Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+  prev->next.store(node, std::memory_order_release);
+}
+
+Message* IncomingMessageQueue::Peek() const {
+  Node* next = tail_->next.load(std::memory_order_acquire);
+  return next != nullptr ? next->message.get() : nullptr;
+}
+
+std::shared_ptr<Message> IncomingMessageQueue::Pop() {
+  Node* next = tail_->next.load(std::memory_order_acquire);
+  if (next == nullptr) return {};
+  std::shared_ptr<Message> message = std::move(next->message);
+  delete tail_;
+  tail_ = next;
+  size_.fetch_sub(1, std::memory_order_relaxed);
+  return message;
+}
+
 MessagePortData::MessagePortData(MessagePort* owner)
     : owner_(owner) {
 }
@@ -629,15 +666,21 @@ MessagePortData::~MessagePortData() {
 }
 
 void MessagePortData::MemoryInfo(MemoryTracker* tracker) const {
-  Mutex::ScopedLock lock(mutex_);
-  tracker->TrackField("incoming_messages", incoming_messages_);
+  // The messages themselves can only be inspected by the receiving thread.
+  tracker->TrackFieldWithSize(
+      "incoming_messages",
+      incoming_messages_.size() * sizeof(std::shared_ptr<Message>));
 }
 
 void MessagePortData::AddToIncomingQueue(std::shared_ptr<Message> message) {
   // This function will be called by other threads.
-  Mutex::ScopedLock lock(mutex_);
-  incoming_messages_.emplace_back(std::move(message));
+  incoming_messages_.Push(std::move(message));
 
+  // The message has to be linked before this, OnMessage() clears the flag
+  // before it drains the queue.
+  if (wakeup_pending_.exchange(true, std::memory_order_acq_rel)) return;
+
+  Mutex::ScopedLock lock(mutex_);
   if (owner_ != nullptr) {
     Debug(owner_, "Adding message to incoming queue");
     owner_->TriggerAsync();
@@ -775,8 +818,9 @@ MaybeLocal<Value> MessagePort::ReceiveMessage(Local<Context> context,
                                               Local<Value>* port_list) {
   std::shared_ptr<Message> received;
   {
-    // Get the head of the message queue.
-    Mutex::ScopedLock lock(data_->mutex_);
+    // Get the head of the message queue. This thread is the only consumer,
+    // so the message can't go away between Peek() and Pop().
+    Message* front = data_->incoming_messages_.Peek();
 
     Debug(this, "MessagePort has message");
 
@@ -787,14 +831,11 @@ MaybeLocal<Value> MessagePort::ReceiveMessage(Local<Context> context,
     // - There are no pending messages
     // - We are not intending to receive messages, and the message we would
     //   receive is not the final "close" message.
-    if (data_->incoming_messages_.empty() ||
-        (!wants_message &&
-         !data_->incoming_messages_.front()->IsCloseMessage())) {
+    if (front == nullptr || (!wants_message && !front->IsCloseMessage())) {
       return env()->no_message_symbol();
     }
 
-    received = data_->incoming_messages_.front();
-    data_->incoming_messages_.pop_front();
+    received = data_->incoming_messages_.Pop();
   }
 
   if (received->IsCloseMessage()) {
@@ -816,13 +857,18 @@ void MessagePort::OnMessage(MessageProcessingMode mode) {
   // Because all data was sent from the previous context.
   if (IsDetached()) return;
 
+  // Messages added from now on have to wake us up again, unless this call
+  // picks them up anyway.
+  // This has to read the flag, so that the messages pushed before a producer
+  // saw it set are visible below.
+  data_->wakeup_pending_.exchange(false, std::memory_order_acq_rel);
+
   HandleScope handle_scope(env()->isolate());
   Local<Context> context =
       object(env()->isolate())->GetCreationContextChecked();
 
   size_t processing_limit;
   if (mode == MessageProcessingMode::kNormalOperation) {
-    Mutex::ScopedLock lock(data_->mutex_);
     processing_limit = std::max(data_->incoming_messages_.size(),
                                 static_cast<size_t>(1000));
   } else {
@@ -1112,7 +1158,6 @@ void MessagePort::PostMessage(const FunctionCallbackInfo<Value>& args) {
 void MessagePort::Start() {
   Debug(this, "Start receiving messages");
   receiving_messages_ = true;
-  Mutex::ScopedLock lock(data_->mutex_);
   if (!data_->incoming_messages_.empty())
     TriggerAsync();
 }
@@ -1546,7 +1591,9 @@ Maybe<bool> SiblingGroup::Dispatch(
         return Just(true);
       }
     }
-    port->AddToIncomingQueue(message);
+    // With a single destination the reference can be handed over instead of
+    // copied.
+    port->AddToIncomingQueue(size() == 2 ? std::move(message) : message);
   }
 
   return Just(true);
@@ -6,7 +6,7 @@
 #include "env.h"
 #include "node_mutex.h"
 #include "v8.h"
-#include <deque>
+#include <atomic>
 #include <string>
 #include <unordered_map>
 #include <set>
@@ -167,6 +167,42 @@ class SiblingGroup final : public std::enable_shared_from_this<SiblingGroup> {
   static Map groups_;
 };
 
+// Multi-producer, single-consumer queue of incoming messages. Push() may be
+// called from any thread without taking a lock, everything else only from the
+// thread that owns the receiving port. Each message takes one node, which is
+// allocated by the producer and freed by the consumer.
+class IncomingMessageQueue {
+ public:
+  IncomingMessageQueue();
+  ~IncomingMessageQueue();
+
+  IncomingMessageQueue(const IncomingMessageQueue&) = delete;
+  IncomingMessageQueue& operator=(const IncomingMessageQueue&) = delete;
+
+  void Push(std::shared_ptr<Message> message);
+  // Returns nullptr if the queue is empty. A Push() that has not finished yet
+  // may not be visible.
+  Message* Peek() const;
+  std::shared_ptr<Message> Pop();
+
+  bool empty() const { return Peek() == nullptr; }
+  // Approximate while producers are running.
+  size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+ private:
+  struct Node {
+    std::atomic<Node*> next{nullptr};
+    std::shared_ptr<Message> message;
+  };
+
+  // The most recently pushed node, swapped by producers.
+  std::atomic<Node*> head_;
+  // A node whose message was already consumed. Its successor holds the oldest
+  // message. Only touched by the consumer.
+  Node* tail_;
+  std::atomic<size_t> size_{0};
+};
+
 // This contains all data for a `MessagePort` instance that is not tied to
 // a specific Environment/Isolate/event loop, for easier transfer between those.
 class MessagePortData : public TransferData {
@@ -206,13 +242,13 @@ class MessagePortData : public TransferData {
   SET_SELF_SIZE(MessagePortData)
 
  private:
-  // This mutex protects all fields below it, with the exception of
-  // sibling_.
+  IncomingMessageQueue incoming_messages_;
+  // Set by the first AddToIncomingQueue() call after the receiver last started
+  // draining the queue, so that a burst of messages wakes it up only once.
+  std::atomic<bool> wakeup_pending_{false};
+  // This mutex protects all fields below it. Producers only take it to wake
+  // up the owner.
   mutable Mutex mutex_;
-  // TODO(addaleax): Make this a std::variant<std::shared_ptr, std::unique_ptr>
-  // once that is available with C++17, because std::shared_ptr comes with
-  // overhead that is only necessary for BroadcastChannel.
-  std::deque<std::shared_ptr<Message>> incoming_messages_;
   MessagePort* owner_ = nullptr;
   std::shared_ptr<SiblingGroup> group_;
   friend class MessagePort;
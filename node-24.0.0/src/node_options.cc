@@ -1051,6 +1051,10 @@ PerProcessOptionsParser::PerProcessOptionsParser(
             "set V8's thread pool size",
             &PerProcessOptions::v8_thread_pool_size,
             kAllowedInEnvvar);
+  AddOption("--worker-isolate-pool-size",
+            "number of isolates kept ready for new Worker threads",
+            &PerProcessOptions::worker_isolate_pool_size,
+            kAllowedInEnvvar);
   AddOption("--zero-fill-buffers",
             "automatically zero-fill all newly allocated Buffer instances",
             &PerProcessOptions::zero_fill_all_buffers,
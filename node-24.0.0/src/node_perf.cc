@@ -11,6 +11,8 @@
 
 #include <cinttypes>
 
+#include <demi_epoll/latency.h>
+
 namespace node {
 namespace performance {
 
@@ -21,6 +23,7 @@ using v8::Function;
 using v8::FunctionCallbackInfo;
 using v8::GCCallbackFlags;
 using v8::GCType;
+using v8::Int32;
 using v8::Integer;
 using v8::Isolate;
 using v8::Local;
@@ -278,6 +281,46 @@ void UvMetricsInfo(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(arr);
 }
 
+static Local<Value> DpollLatencyToHistogram(
+    Environment* env, const dpoll_latency_hist& hist) {
+  auto histogram = std::make_shared<Histogram>(Histogram::Options{});
+  for (size_t i = 0; i < DPOLL_LAT_BUCKETS; i++) {
+    if (hist.buckets[i] == 0) continue;
+    histogram->RecordValues(dpoll_latency_bucket_value(i), hist.buckets[i]);
+  }
+  return HistogramBase::Create(env, std::move(histogram))->object();
+}
+
+// Snapshots the shim's issue-to-completion latency of demikernel operations,
+// in nanoseconds. Without arguments returns the histograms of [push, pop,
+// accept], with the fd of a listening dpoll socket only the accept histogram
+// of that listener. Returns undefined unless DEMI_EPOLL_LATENCY=1.
+void DpollLatencyHistograms(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  if (!dpoll_latency_enabled()) return;
+
+  if (args[0]->IsInt32()) {
+    auto hist = std::make_unique<dpoll_latency_hist>();
+    if (dpoll_get_listener_latency_histogram(args[0].As<Int32>()->Value(),
+                                             hist.get())) {
+      return env->ThrowErrnoException(errno,
+                                      "dpoll_get_listener_latency_histogram");
+    }
+    args.GetReturnValue().Set(DpollLatencyToHistogram(env, *hist));
+    return;
+  }
+
+  auto hists = std::make_unique<dpoll_latency_hist[]>(DPOLL_LAT_OP_COUNT);
+  dpoll_get_latency_histograms(hists.get());
+  Local<Value> data[] = {
+      DpollLatencyToHistogram(env, hists[DPOLL_LAT_PUSH]),
+      DpollLatencyToHistogram(env, hists[DPOLL_LAT_POP]),
+      DpollLatencyToHistogram(env, hists[DPOLL_LAT_ACCEPT]),
+  };
+  static_assert(arraysize(data) == DPOLL_LAT_OP_COUNT);
+  args.GetReturnValue().Set(Array::New(env->isolate(), data, arraysize(data)));
+}
+
 void CreateELDHistogram(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   int64_t interval = args[0].As<Integer>()->Value();
@@ -342,6 +385,10 @@ static void CreatePerIsolateProperties(IsolateData* isolate_data,
   SetMethod(isolate, target, "createELDHistogram", CreateELDHistogram);
   SetMethod(isolate, target, "markBootstrapComplete", MarkBootstrapComplete);
   SetMethod(isolate, target, "uvMetricsInfo", UvMetricsInfo);
+  SetMethod(isolate,
+            target,
+            "dpollLatencyHistograms",
+            DpollLatencyHistograms);
   SetFastMethodNoSideEffect(
       isolate, target, "now", SlowPerformanceNow, &fast_performance_now);
 }
@@ -409,6 +456,7 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(CreateELDHistogram);
   registry->Register(MarkBootstrapComplete);
   registry->Register(UvMetricsInfo);
+  registry->Register(DpollLatencyHistograms);
   registry->Register(SlowPerformanceNow);
   registry->Register(FastPerformanceNow);
   registry->Register(fast_performance_now.GetTypeInfo());
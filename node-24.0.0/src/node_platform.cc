@@ -18,7 +18,7 @@ using v8::TaskPriority;
 namespace {
 
 struct PlatformWorkerData {
-  TaskQueue<TaskQueueEntry>* task_queue;
+  WorkStealingTaskQueue* task_queue;
   Mutex* platform_workers_mutex;
   ConditionVariable* platform_workers_ready;
   int* pending_platform_workers;
@@ -53,7 +53,7 @@ static void PlatformWorkerThread(void* data) {
   std::unique_ptr<PlatformWorkerData>
       worker_data(static_cast<PlatformWorkerData*>(data));
 
-  TaskQueue<TaskQueueEntry>* pending_worker_tasks = worker_data->task_queue;
+  WorkStealingTaskQueue* pending_worker_tasks = worker_data->task_queue;
   TRACE_EVENT_METADATA1("__metadata", "thread_name", "name",
                         "PlatformWorkerThread");
 
@@ -68,7 +68,7 @@ static void PlatformWorkerThread(void* data) {
       worker_data->debug_log_level != PlatformDebugLogLevel::kNone;
   int id = worker_data->id;
   while (std::unique_ptr<TaskQueueEntry> entry =
-             pending_worker_tasks->Lock().BlockingPop()) {
+             pending_worker_tasks->BlockingPop(id)) {
     if (debug_log_enabled) {
       fprintf(stderr,
               "\nPlatformWorkerThread %d running task %p %s\n",
@@ -80,7 +80,7 @@ static void PlatformWorkerThread(void* data) {
     entry->task->Run();
     // See NodePlatform::DrainTasks().
     if (entry->is_outstanding()) {
-      pending_worker_tasks->Lock().NotifyOfOutstandingCompletion();
+      pending_worker_tasks->NotifyOfOutstandingCompletion();
     }
   }
 }
@@ -96,7 +96,7 @@ static int GetActualThreadPoolSize(int thread_pool_size) {
 
 class WorkerThreadsTaskRunner::DelayedTaskScheduler {
  public:
-  explicit DelayedTaskScheduler(TaskQueue<TaskQueueEntry>* tasks)
+  explicit DelayedTaskScheduler(WorkStealingTaskQueue* tasks)
       : pending_worker_tasks_(tasks) {}
 
   std::unique_ptr<uv_thread_t> Start() {
@@ -213,9 +213,7 @@ class WorkerThreadsTaskRunner::DelayedTaskScheduler {
     DelayedTaskScheduler* scheduler =
         ContainerOf(&DelayedTaskScheduler::loop_, timer->loop);
     auto entry = scheduler->TakeTimerTask(timer);
-    bool is_outstanding = entry->is_outstanding();
-    scheduler->pending_worker_tasks_->Lock().Push(std::move(entry),
-                                                  is_outstanding);
+    scheduler->pending_worker_tasks_->PushDelayed(std::move(entry));
   }
 
   std::unique_ptr<TaskQueueEntry> TakeTimerTask(uv_timer_t* timer) {
@@ -232,7 +230,7 @@ class WorkerThreadsTaskRunner::DelayedTaskScheduler {
   uv_sem_t ready_;
   // Task queue in the worker thread task runner, we push the delayed task back
   // to it when the timer expires.
-  TaskQueue<TaskQueueEntry>* pending_worker_tasks_;
+  WorkStealingTaskQueue* pending_worker_tasks_;
 
   // Locally scheduled tasks to be poped into the worker task runner queue.
   // It is flushed whenever the next closest timer expires.
@@ -244,7 +242,8 @@ class WorkerThreadsTaskRunner::DelayedTaskScheduler {
 
 WorkerThreadsTaskRunner::WorkerThreadsTaskRunner(
     int thread_pool_size, PlatformDebugLogLevel debug_log_level)
-    : debug_log_level_(debug_log_level) {
+    : pending_worker_tasks_(thread_pool_size),
+      debug_log_level_(debug_log_level) {
   Mutex platform_workers_mutex;
   ConditionVariable platform_workers_ready;
 
@@ -281,9 +280,8 @@ WorkerThreadsTaskRunner::WorkerThreadsTaskRunner(
 void WorkerThreadsTaskRunner::PostTask(v8::TaskPriority priority,
                                        std::unique_ptr<v8::Task> task,
                                        const v8::SourceLocation& location) {
-  auto entry = std::make_unique<TaskQueueEntry>(std::move(task), priority);
-  bool is_outstanding = entry->is_outstanding();
-  pending_worker_tasks_.Lock().Push(std::move(entry), is_outstanding);
+  pending_worker_tasks_.Push(
+      std::make_unique<TaskQueueEntry>(std::move(task), priority));
 }
 
 void WorkerThreadsTaskRunner::PostDelayedTask(
@@ -296,11 +294,11 @@ void WorkerThreadsTaskRunner::PostDelayedTask(
 }
 
 void WorkerThreadsTaskRunner::BlockingDrain() {
-  pending_worker_tasks_.Lock().BlockingDrain();
+  pending_worker_tasks_.BlockingDrain();
 }
 
 void WorkerThreadsTaskRunner::Shutdown() {
-  pending_worker_tasks_.Lock().Stop();
+  pending_worker_tasks_.Stop();
   delayed_task_scheduler_->Stop();
   for (size_t i = 0; i < threads_.size(); i++) {
     CHECK_EQ(0, uv_thread_join(threads_[i].get()));
@@ -844,6 +842,222 @@ TaskQueue<T>::PriorityQueue TaskQueue<T>::Locked::PopAll() {
   return result;
 }
 
+// Chase-Lev deque with a fixed capacity, see "Correct and Efficient
+// Work-Stealing for Weak Memory Models" (Le et al., PPoPP 2013). Push() and
+// Pop() are only called by the worker owning it, at the bottom, Steal() by
+// any thread at the top.
+class WorkStealingTaskQueue::Deque {
+ public:
+  static constexpr int64_t kCapacity = 256;
+
+  ~Deque() {
+    while (TaskQueueEntry* entry = Pop()) delete entry;
+  }
+
+  // Returns false if the deque is full.
+  bool Push(TaskQueueEntry* entry) {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    int64_t top = top_.load(std::memory_order_acquire);
+    if (bottom - top >= kCapacity) return false;
+    buffer_[bottom % kCapacity].store(entry, std::memory_order_relaxed);
+    bottom_.store(bottom + 1, std::memory_order_release);
+    return true;
+  }
+
+  TaskQueueEntry* Pop() {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = top_.load(std::memory_order_relaxed);
+    if (top > bottom) {
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    TaskQueueEntry* entry =
+        buffer_[bottom % kCapacity].load(std::memory_order_relaxed);
+    if (top == bottom) {
+      // Last entry, race against thieves for it.
+      if (!top_.compare_exchange_strong(top,
+                                        top + 1,
+                                        std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        entry = nullptr;
+      }
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return entry;
+  }
+
+  // Returns nullptr if the deque is empty or another thread won the race for
+  // the top entry.
+  TaskQueueEntry* Steal() {
+    int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) return nullptr;
+    TaskQueueEntry* entry =
+        buffer_[top % kCapacity].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(top,
+                                      top + 1,
+                                      std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return entry;
+  }
+
+  bool IsEmpty() const {
+    return top_.load(std::memory_order_acquire) >=
+           bottom_.load(std::memory_order_acquire);
+  }
+
+ private:
+  // Kept on separate cache lines, the owner writes bottom_ and thieves top_.
+  alignas(64) std::atomic<int64_t> top_{0};
+  alignas(64) std::atomic<int64_t> bottom_{0};
+  std::atomic<TaskQueueEntry*> buffer_[kCapacity] = {};
+};
+
+struct WorkStealingTaskQueue::Worker {
+  Deque deques[kNumPriorities];
+};
+
+namespace {
+// The worker the current thread is, if any, so that Push() can use its deque.
+struct CurrentWorker {
+  const WorkStealingTaskQueue* queue = nullptr;
+  int id = -1;
+};
+thread_local CurrentWorker current_worker;
+}  // namespace
+
+WorkStealingTaskQueue::WorkStealingTaskQueue(int num_workers) {
+  for (int i = 0; i < num_workers; i++)
+    workers_.push_back(std::make_unique<Worker>());
+}
+
+WorkStealingTaskQueue::~WorkStealingTaskQueue() = default;
+
+void WorkStealingTaskQueue::Lane::Push(std::unique_ptr<TaskQueueEntry> task) {
+  Mutex::ScopedLock lock(mutex);
+  tasks.push_back(std::move(task));
+  size.fetch_add(1, std::memory_order_seq_cst);
+}
+
+std::unique_ptr<TaskQueueEntry> WorkStealingTaskQueue::Lane::Pop() {
+  if (size.load(std::memory_order_relaxed) == 0) return nullptr;
+  Mutex::ScopedLock lock(mutex);
+  if (tasks.empty()) return nullptr;
+  std::unique_ptr<TaskQueueEntry> task = std::move(tasks.front());
+  tasks.pop_front();
+  size.fetch_sub(1, std::memory_order_relaxed);
+  return task;
+}
+
+void WorkStealingTaskQueue::Push(std::unique_ptr<TaskQueueEntry> task) {
+  if (task->is_outstanding())
+    outstanding_tasks_.fetch_add(1, std::memory_order_relaxed);
+
+  int priority = static_cast<int>(task->priority);
+  if (current_worker.queue == this &&
+      workers_[current_worker.id]->deques[priority].Push(task.get())) {
+    task.release();
+  } else {
+    posted_[priority].Push(std::move(task));
+  }
+  WakeUpWorker();
+}
+
+void WorkStealingTaskQueue::PushDelayed(std::unique_ptr<TaskQueueEntry> task) {
+  if (task->is_outstanding())
+    outstanding_tasks_.fetch_add(1, std::memory_order_relaxed);
+
+  int priority = static_cast<int>(task->priority);
+  delayed_[priority].Push(std::move(task));
+  WakeUpWorker();
+}
+
+void WorkStealingTaskQueue::WakeUpWorker() {
+  // Pairs with the increment of sleeping_workers_ in BlockingPop(): either
+  // the worker going to sleep sees the new task in HasTasks(), or this sees
+  // the worker and wakes it up.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping_workers_.load(std::memory_order_relaxed) == 0) return;
+  Mutex::ScopedLock lock(mutex_);
+  tasks_available_.Signal(lock);
+}
+
+std::unique_ptr<TaskQueueEntry> WorkStealingTaskQueue::TryPop(int worker_id) {
+  const int num_workers = workers_.size();
+  for (int priority = kNumPriorities - 1; priority >= 0; priority--) {
+    if (TaskQueueEntry* entry = workers_[worker_id]->deques[priority].Pop())
+      return std::unique_ptr<TaskQueueEntry>(entry);
+    if (auto task = posted_[priority].Pop()) return task;
+    if (auto task = delayed_[priority].Pop()) return task;
+    for (int i = 1; i < num_workers; i++) {
+      Deque& victim = workers_[(worker_id + i) % num_workers]->deques[priority];
+      if (TaskQueueEntry* entry = victim.Steal())
+        return std::unique_ptr<TaskQueueEntry>(entry);
+    }
+  }
+  return nullptr;
+}
+
+bool WorkStealingTaskQueue::HasTasks() const {
+  for (int priority = 0; priority < kNumPriorities; priority++) {
+    if (posted_[priority].size.load(std::memory_order_relaxed) != 0 ||
+        delayed_[priority].size.load(std::memory_order_relaxed) != 0) {
+      return true;
+    }
+    for (const auto& worker : workers_) {
+      if (!worker->deques[priority].IsEmpty()) return true;
+    }
+  }
+  return false;
+}
+
+std::unique_ptr<TaskQueueEntry> WorkStealingTaskQueue::BlockingPop(
+    int worker_id) {
+  CHECK_LT(worker_id, static_cast<int>(workers_.size()));
+  current_worker = {this, worker_id};
+
+  while (!stopped_.load(std::memory_order_relaxed)) {
+    if (auto task = TryPop(worker_id)) return task;
+
+    Mutex::ScopedLock lock(mutex_);
+    if (stopped_.load(std::memory_order_relaxed)) break;
+    sleeping_workers_.fetch_add(1, std::memory_order_seq_cst);
+    // Pairs with the fence in WakeUpWorker(). The seq_cst increment alone
+    // does not keep the relaxed loads in HasTasks() from moving before it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // A failed Steal() doesn't mean that there is nothing left, so check
+    // again before sleeping.
+    if (!HasTasks()) tasks_available_.Wait(lock);
+    sleeping_workers_.fetch_sub(1, std::memory_order_relaxed);
+  }
+  return nullptr;
+}
+
+void WorkStealingTaskQueue::NotifyOfOutstandingCompletion() {
+  if (outstanding_tasks_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    Mutex::ScopedLock lock(mutex_);
+    outstanding_tasks_drained_.Broadcast(lock);
+  }
+}
+
+void WorkStealingTaskQueue::BlockingDrain() {
+  Mutex::ScopedLock lock(mutex_);
+  while (outstanding_tasks_.load(std::memory_order_acquire) > 0) {
+    outstanding_tasks_drained_.Wait(lock);
+  }
+}
+
+void WorkStealingTaskQueue::Stop() {
+  Mutex::ScopedLock lock(mutex_);
+  stopped_.store(true, std::memory_order_relaxed);
+  tasks_available_.Broadcast(lock);
+}
+
 void MultiIsolatePlatform::DisposeIsolate(Isolate* isolate) {
   // The order of these calls is important. When the Isolate is disposed,
   // it may still post tasks to the platform, so it must still be registered
@@ -3,6 +3,8 @@
 
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
+#include <atomic>
+#include <deque>
 #include <functional>
 #include <queue>
 #include <type_traits>
@@ -96,6 +98,61 @@ struct DelayedTask {
   std::shared_ptr<PerIsolatePlatformData> platform_data;
 };
 
+// The queue of the WorkerThreadsTaskRunner. Every worker thread owns a
+// lock-free deque per priority, tasks posted from a worker thread go to its
+// own deque and idle workers steal from the others. Tasks posted from other
+// threads and delayed tasks whose timer expired go through two shared lanes
+// with a lock each. Workers always take the highest priority task they can
+// find, in their own deque, the shared lanes or the deques of other workers,
+// in that order.
+class WorkStealingTaskQueue {
+ public:
+  explicit WorkStealingTaskQueue(int num_workers);
+  ~WorkStealingTaskQueue();
+
+  // Can be called from any thread.
+  void Push(std::unique_ptr<TaskQueueEntry> task);
+  // Used by the DelayedTaskScheduler for tasks whose delay has passed.
+  void PushDelayed(std::unique_ptr<TaskQueueEntry> task);
+  // Called by worker `worker_id`, returns nullptr once stopped.
+  std::unique_ptr<TaskQueueEntry> BlockingPop(int worker_id);
+  void NotifyOfOutstandingCompletion();
+  void BlockingDrain();
+  void Stop();
+
+ private:
+  static constexpr int kNumPriorities =
+      static_cast<int>(v8::TaskPriority::kMaxPriority) + 1;
+
+  class Deque;
+  struct Worker;
+  struct Lane {
+    Mutex mutex;
+    std::deque<std::unique_ptr<TaskQueueEntry>> tasks;
+    // Lets workers skip empty lanes without taking the lock.
+    std::atomic<size_t> size{0};
+
+    void Push(std::unique_ptr<TaskQueueEntry> task);
+    std::unique_ptr<TaskQueueEntry> Pop();
+  };
+
+  void PushToLane(Lane* lanes, std::unique_ptr<TaskQueueEntry> task);
+  std::unique_ptr<TaskQueueEntry> TryPop(int worker_id);
+  bool HasTasks() const;
+  void WakeUpWorker();
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  Lane posted_[kNumPriorities];
+  Lane delayed_[kNumPriorities];
+
+  Mutex mutex_;
+  ConditionVariable tasks_available_;
+  ConditionVariable outstanding_tasks_drained_;
+  std::atomic<int> sleeping_workers_{0};
+  std::atomic<int> outstanding_tasks_{0};
+  std::atomic<bool> stopped_{false};
+};
+
 enum class PlatformDebugLogLevel {
   kNone = 0,
   kMinimal = 1,
@@ -209,7 +266,7 @@ class WorkerThreadsTaskRunner {
   // v8::Platform::PostDelayedTaskOnWorkerThread(), the DelayedTaskScheduler
   // thread will schedule a timer that pushes the delayed tasks back into this
   // queue when the timer expires.
-  TaskQueue<TaskQueueEntry> pending_worker_tasks_;
+  WorkStealingTaskQueue pending_worker_tasks_;
 
   class DelayedTaskScheduler;
   std::unique_ptr<DelayedTaskScheduler> delayed_task_scheduler_;
@@ -7,6 +7,7 @@
 #include "node_sockaddr-inl.h"  // NOLINT(build/include_inline)
 #include "uv.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
@@ -398,6 +399,7 @@ void SocketAddressBlockList::AddSocketAddress(
       std::make_unique<SocketAddressRule>(address);
   rules_.emplace_front(std::move(rule));
   address_rules_[*address.get()] = rules_.begin();
+  index_dirty_ = true;
 }
 
 void SocketAddressBlockList::RemoveSocketAddress(
@@ -407,6 +409,7 @@ void SocketAddressBlockList::RemoveSocketAddress(
   if (it != std::end(address_rules_)) {
     rules_.erase(it->second);
     address_rules_.erase(it);
+    index_dirty_ = true;
   }
 }
 
@@ -417,6 +420,7 @@ void SocketAddressBlockList::AddSocketAddressRange(
   std::unique_ptr<Rule> rule =
       std::make_unique<SocketAddressRangeRule>(start, end);
   rules_.emplace_front(std::move(rule));
+  index_dirty_ = true;
 }
 
 void SocketAddressBlockList::AddSocketAddressMask(
@@ -426,18 +430,234 @@ void SocketAddressBlockList::AddSocketAddressMask(
   std::unique_ptr<Rule> rule =
       std::make_unique<SocketAddressMaskRule>(network, prefix);
   rules_.emplace_front(std::move(rule));
+  index_dirty_ = true;
 }
 
 bool SocketAddressBlockList::Apply(
     const std::shared_ptr<SocketAddress>& address) {
-  Mutex::ScopedLock lock(mutex_);
-  for (const auto& rule : rules_) {
-    if (rule->Apply(address))
+  {
+    Mutex::ScopedLock lock(mutex_);
+    if (index_dirty_) {
+      index_.Build(rules_);
+      index_dirty_ = false;
+    }
+    if (index_.Match(address))
       return true;
   }
   return parent_ ? parent_->Apply(address) : false;
 }
 
+bool SocketAddressBlockList::RuleIndex::ToKey(const SocketAddress& address,
+                                              Key* key) {
+  switch (address.family()) {
+    case AF_INET: {
+      const sockaddr_in* in =
+          reinterpret_cast<const sockaddr_in*>(address.data());
+      key->hi = 0;
+      key->lo = (uint64_t{0xffff} << 32) | ntohl(in->sin_addr.s_addr);
+      return true;
+    }
+    case AF_INET6: {
+      const sockaddr_in6* in =
+          reinterpret_cast<const sockaddr_in6*>(address.data());
+      const uint8_t* ptr = in->sin6_addr.s6_addr;
+      key->hi = (uint64_t{nbytes::ReadUint32BE(ptr)} << 32) |
+                nbytes::ReadUint32BE(ptr + 4);
+      key->lo = (uint64_t{nbytes::ReadUint32BE(ptr + 8)} << 32) |
+                nbytes::ReadUint32BE(ptr + 12);
+      return true;
+    }
+  }
+  return false;
+}
+
+namespace {
+// Whether a key lies in ::ffff:0:0/96, where IPv4 addresses are mapped to.
+inline bool is_mapped_key(uint64_t hi, uint64_t lo) {
+  return hi == 0 && (lo >> 32) == 0xffff;
+}
+
+inline int key_bit(uint64_t hi, uint64_t lo, int bit) {
+  return bit < 64 ? (hi >> (63 - bit)) & 1 : (lo >> (127 - bit)) & 1;
+}
+}  // namespace
+
+void SocketAddressBlockList::RuleIndex::AddAddress(
+    const SocketAddress& address) {
+  Key key;
+  if (ToKey(address, &key))
+    prefixes_.emplace_back(key, 128);
+}
+
+void SocketAddressBlockList::RuleIndex::AddMask(Rule* rule,
+                                                const SocketAddress& network,
+                                                int prefix) {
+  Key key;
+  if (!ToKey(network, &key))
+    return;
+  // An IPv4 network matches the same addresses as its IPv4-mapped IPv6 form
+  // with the prefix extended by the 96 bits of ::ffff:0:0.
+  const int max = network.family() == AF_INET ? 32 : 128;
+  if (prefix < 0 || prefix > max) {
+    fallback_.push_back(rule);
+    return;
+  }
+  prefixes_.emplace_back(key, prefix + 128 - max);
+}
+
+void SocketAddressBlockList::RuleIndex::AddRange(Rule* rule,
+                                                 const SocketAddress& start,
+                                                 const SocketAddress& end) {
+  Key s, e;
+  if (!ToKey(start, &s) || !ToKey(end, &e) || s > e)
+    return;
+  const bool mapped = is_mapped_key(s.hi, s.lo) && is_mapped_key(e.hi, e.lo);
+  // Comparing addresses of different families is unordered unless the IPv6
+  // one is IPv4-mapped, so mixed ranges only match part of their interval.
+  if (start.family() != end.family() && !mapped) {
+    fallback_.push_back(rule);
+    return;
+  }
+  ranges_.push_back({s, e});
+  if (mapped)
+    mapped_ranges_.push_back({s, e});
+}
+
+void SocketAddressBlockList::RuleIndex::Insert(const Key& key, int bits) {
+  uint32_t node = 0;
+  for (int bit = 0; bit < bits; bit++) {
+    // Already covered by a shorter prefix.
+    if (trie_[node].terminal)
+      return;
+    const int b = key_bit(key.hi, key.lo, bit);
+    uint32_t next = trie_[node].child[b];
+    if (next == 0) {
+      next = static_cast<uint32_t>(trie_.size());
+      trie_.push_back(Node{});
+      trie_[node].child[b] = next;
+    }
+    node = next;
+  }
+  trie_[node].terminal = true;
+}
+
+bool SocketAddressBlockList::RuleIndex::InTrie(const Key& key) const {
+  uint32_t node = 0;
+  int bit = 0;
+  if (is_mapped_key(key.hi, key.lo)) {
+    if (mapped_all_)
+      return true;
+    if (mapped_root_ == 0)
+      return false;
+    node = mapped_root_;
+    bit = 96;
+  }
+  for (; bit < 128; bit++) {
+    if (trie_[node].terminal)
+      return true;
+    node = trie_[node].child[key_bit(key.hi, key.lo, bit)];
+    if (node == 0)
+      return false;
+  }
+  return trie_[node].terminal;
+}
+
+void SocketAddressBlockList::RuleIndex::Compact(
+    std::vector<Interval>* intervals) {
+  std::sort(intervals->begin(),
+            intervals->end(),
+            [](const Interval& a, const Interval& b) {
+              return a.start < b.start;
+            });
+  size_t n = 0;
+  for (const Interval& i : *intervals) {
+    if (n > 0 && i.start <= (*intervals)[n - 1].end) {
+      (*intervals)[n - 1].end = std::max((*intervals)[n - 1].end, i.end);
+      continue;
+    }
+    (*intervals)[n++] = i;
+  }
+  intervals->resize(n);
+}
+
+bool SocketAddressBlockList::RuleIndex::InIntervals(
+    const std::vector<Interval>& intervals, const Key& key) {
+  auto it = std::upper_bound(intervals.begin(),
+                             intervals.end(),
+                             key,
+                             [](const Key& k, const Interval& i) {
+                               return k < i.start;
+                             });
+  if (it == intervals.begin())
+    return false;
+  return key <= std::prev(it)->end;
+}
+
+void SocketAddressBlockList::RuleIndex::Build(
+    const std::list<std::unique_ptr<Rule>>& rules) {
+  prefixes_.clear();
+  trie_.assign(1, Node{});
+  ranges_.clear();
+  mapped_ranges_.clear();
+  fallback_.clear();
+
+  for (const auto& rule : rules)
+    rule->AddTo(this);
+
+  // Inserting the shortest prefixes first keeps the trie free of nodes below
+  // a terminal one.
+  std::sort(prefixes_.begin(),
+            prefixes_.end(),
+            [](const auto& a, const auto& b) { return a.second < b.second; });
+  for (const auto& [key, bits] : prefixes_)
+    Insert(key, bits);
+  prefixes_.clear();
+  prefixes_.shrink_to_fit();
+
+  mapped_root_ = 0;
+  mapped_all_ = false;
+  uint32_t node = 0;
+  const Key mapped{0, uint64_t{0xffff} << 32};
+  for (int bit = 0; bit < 96; bit++) {
+    if (trie_[node].terminal) {
+      mapped_all_ = true;
+      break;
+    }
+    node = trie_[node].child[key_bit(mapped.hi, mapped.lo, bit)];
+    if (node == 0)
+      break;
+  }
+  if (!mapped_all_)
+    mapped_root_ = node;
+
+  Compact(&ranges_);
+  Compact(&mapped_ranges_);
+}
+
+bool SocketAddressBlockList::RuleIndex::Match(
+    const std::shared_ptr<SocketAddress>& address) const {
+  Key key;
+  if (!ToKey(*address.get(), &key))
+    return false;
+  if (InTrie(key))
+    return true;
+  if (InIntervals(
+          address->family() == AF_INET ? mapped_ranges_ : ranges_, key)) {
+    return true;
+  }
+  for (Rule* rule : fallback_) {
+    if (rule->Apply(address))
+      return true;
+  }
+  return false;
+}
+
+size_t SocketAddressBlockList::RuleIndex::memory_size() const {
+  return trie_.capacity() * sizeof(Node) +
+         (ranges_.capacity() + mapped_ranges_.capacity()) * sizeof(Interval) +
+         fallback_.capacity() * sizeof(Rule*);
+}
+
 SocketAddressBlockList::SocketAddressRule::SocketAddressRule(
     const std::shared_ptr<SocketAddress>& address_)
     : address(address_) {}
@@ -459,6 +679,10 @@ bool SocketAddressBlockList::SocketAddressRule::Apply(
   return this->address->is_match(*address.get());
 }
 
+void SocketAddressBlockList::SocketAddressRule::AddTo(RuleIndex* index) {
+  index->AddAddress(*address.get());
+}
+
 std::string SocketAddressBlockList::SocketAddressRule::ToString() {
   std::string ret = "Address: ";
   ret += address->family() == AF_INET ? "IPv4" : "IPv6";
@@ -473,6 +697,10 @@ bool SocketAddressBlockList::SocketAddressRangeRule::Apply(
          *address.get() <= *end.get();
 }
 
+void SocketAddressBlockList::SocketAddressRangeRule::AddTo(RuleIndex* index) {
+  index->AddRange(this, *start.get(), *end.get());
+}
+
 std::string SocketAddressBlockList::SocketAddressRangeRule::ToString() {
   std::string ret = "Range: ";
   ret += start->family() == AF_INET ? "IPv4" : "IPv6";
@@ -488,6 +716,10 @@ bool SocketAddressBlockList::SocketAddressMaskRule::Apply(
   return address->is_in_network(*network.get(), prefix);
 }
 
+void SocketAddressBlockList::SocketAddressMaskRule::AddTo(RuleIndex* index) {
+  index->AddMask(this, *network.get(), prefix);
+}
+
 std::string SocketAddressBlockList::SocketAddressMaskRule::ToString() {
   std::string ret = "Subnet: ";
   ret += network->family() == AF_INET ? "IPv4" : "IPv6";
@@ -520,6 +752,7 @@ bool SocketAddressBlockList::ListRules(Environment* env,
 
 void SocketAddressBlockList::MemoryInfo(node::MemoryTracker* tracker) const {
   tracker->TrackField("rules", rules_);
+  tracker->TrackFieldWithSize("index", index_.memory_size());
 }
 
 void SocketAddressBlockList::SocketAddressRule::MemoryInfo(
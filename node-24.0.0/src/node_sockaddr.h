@@ -16,6 +16,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace node {
 
@@ -236,6 +237,8 @@ class SocketAddressLRU : public MemoryRetainer {
 // SocketAddress should be accepted for inbound or
 // outbound network activity.
 class SocketAddressBlockList : public MemoryRetainer {
+  class RuleIndex;
+
  public:
   explicit SocketAddressBlockList(
       std::shared_ptr<SocketAddressBlockList> parent = {});
@@ -261,6 +264,7 @@ class SocketAddressBlockList : public MemoryRetainer {
 
   struct Rule : public MemoryRetainer {
     virtual bool Apply(const std::shared_ptr<SocketAddress>& address) = 0;
+    virtual void AddTo(RuleIndex* index) = 0;
     inline v8::MaybeLocal<v8::Value> ToV8String(Environment* env);
     virtual std::string ToString() = 0;
   };
@@ -271,6 +275,7 @@ class SocketAddressBlockList : public MemoryRetainer {
     explicit SocketAddressRule(const std::shared_ptr<SocketAddress>& address);
 
     bool Apply(const std::shared_ptr<SocketAddress>& address) override;
+    void AddTo(RuleIndex* index) override;
     std::string ToString() override;
 
     void MemoryInfo(node::MemoryTracker* tracker) const override;
@@ -287,6 +292,7 @@ class SocketAddressBlockList : public MemoryRetainer {
         const std::shared_ptr<SocketAddress>& end);
 
     bool Apply(const std::shared_ptr<SocketAddress>& address) override;
+    void AddTo(RuleIndex* index) override;
     std::string ToString() override;
 
     void MemoryInfo(node::MemoryTracker* tracker) const override;
@@ -303,6 +309,7 @@ class SocketAddressBlockList : public MemoryRetainer {
         int prefix);
 
     bool Apply(const std::shared_ptr<SocketAddress>& address) override;
+    void AddTo(RuleIndex* index) override;
     std::string ToString() override;
 
     void MemoryInfo(node::MemoryTracker* tracker) const override;
@@ -317,9 +324,68 @@ class SocketAddressBlockList : public MemoryRetainer {
  private:
   bool ListRules(Environment* env, v8::LocalVector<v8::Value>* vec);
 
+  // Compiled form of rules_ used by Apply(). Addresses of both families are
+  // mapped into one 128-bit key space, IPv4 addresses as their IPv4-mapped
+  // IPv6 form, which is how the rules already compare addresses across
+  // families. Single addresses and masks go into a binary trie, ranges into
+  // sorted, merged interval lists. The few range rules whose endpoints do not
+  // fit that key space are kept as rules and checked one by one.
+  class RuleIndex {
+   public:
+    void Build(const std::list<std::unique_ptr<Rule>>& rules);
+    bool Match(const std::shared_ptr<SocketAddress>& address) const;
+    size_t memory_size() const;
+
+    void AddAddress(const SocketAddress& address);
+    void AddRange(Rule* rule,
+                  const SocketAddress& start,
+                  const SocketAddress& end);
+    void AddMask(Rule* rule, const SocketAddress& network, int prefix);
+
+   private:
+    struct Key {
+      uint64_t hi;
+      uint64_t lo;
+      auto operator<=>(const Key&) const = default;
+    };
+
+    struct Interval {
+      Key start;
+      Key end;
+    };
+
+    struct Node {
+      uint32_t child[2];
+      bool terminal;
+    };
+
+    static bool ToKey(const SocketAddress& address, Key* key);
+    static void Compact(std::vector<Interval>* intervals);
+    static bool InIntervals(const std::vector<Interval>& intervals,
+                            const Key& key);
+
+    void Insert(const Key& key, int bits);
+    bool InTrie(const Key& key) const;
+
+    // Prefixes are only inserted once all rules were added, shortest first.
+    std::vector<std::pair<Key, int>> prefixes_;
+    std::vector<Node> trie_;
+    // Node of ::ffff:0:0/96 so that IPv4 lookups can skip the shared prefix,
+    // 0 if no rule covers any IPv4 address.
+    uint32_t mapped_root_ = 0;
+    bool mapped_all_ = false;
+    // Ranges matched by IPv6 addresses, and the subset that IPv4 addresses
+    // can match, i.e. those with both endpoints in the IPv4-mapped space.
+    std::vector<Interval> ranges_;
+    std::vector<Interval> mapped_ranges_;
+    std::vector<Rule*> fallback_;
+  };
+
   std::shared_ptr<SocketAddressBlockList> parent_;
   std::list<std::unique_ptr<Rule>> rules_;
   SocketAddress::Map<std::list<std::unique_ptr<Rule>>::iterator> address_rules_;
+  RuleIndex index_;
+  bool index_dirty_ = true;
 
   Mutex mutex_;
 };
@@ -46,6 +46,7 @@ using v8::Promise;
 using v8::SideEffectType;
 using v8::String;
 using v8::TryCatch;
+using v8::Uint32;
 using v8::Uint8Array;
 using v8::Value;
 
@@ -644,12 +645,97 @@ void UserDefinedFunction::xDestroy(void* self) {
   delete static_cast<UserDefinedFunction*>(self);
 }
 
+sqlite3_stmt* StatementCache::Acquire(std::string_view sql) {
+  auto it = entries_.find(sql);
+  if (it == entries_.end()) {
+    misses_++;
+    return nullptr;
+  }
+  hits_++;
+  lru_.splice(lru_.begin(), lru_, it->second);
+  sqlite3_stmt* stmt = it->second->stmt;
+  users_[stmt].count++;
+  return stmt;
+}
+
+void StatementCache::Insert(std::string_view sql, sqlite3_stmt* stmt) {
+  CHECK_EQ(entries_.count(sql), 0);
+  if (lru_.size() >= capacity_) {
+    evictions_++;
+    Evict(std::prev(lru_.end()));
+  }
+  lru_.push_front({std::string(sql), stmt});
+  entries_.emplace(lru_.front().sql, lru_.begin());
+  users_.emplace(stmt, Users{1, true, nullptr});
+}
+
+bool StatementCache::Release(sqlite3_stmt* stmt) {
+  auto it = users_.find(stmt);
+  if (it == users_.end()) {
+    return false;
+  }
+  CHECK_GT(it->second.count, 0);
+  if (--it->second.count > 0) {
+    return true;
+  }
+  if (it->second.cached) {
+    // The last user may have left an iteration unfinished.
+    sqlite3_reset(stmt);
+  } else {
+    sqlite3_finalize(stmt);
+    users_.erase(it);
+  }
+  return true;
+}
+
+void StatementCache::Evict(std::list<Entry>::iterator it) {
+  auto users = users_.find(it->stmt);
+  CHECK_NE(users, users_.end());
+  if (users->second.count == 0) {
+    sqlite3_finalize(it->stmt);
+    users_.erase(users);
+  } else {
+    users->second.cached = false;
+  }
+  entries_.erase(it->sql);
+  lru_.erase(it);
+}
+
+void StatementCache::Clear() {
+  while (!lru_.empty()) {
+    Evict(lru_.begin());
+  }
+}
+
+StatementSync* StatementCache::iterating(sqlite3_stmt* stmt) const {
+  auto it = users_.find(stmt);
+  CHECK_NE(it, users_.end());
+  return it->second.iterating;
+}
+
+void StatementCache::set_iterating(sqlite3_stmt* stmt, StatementSync* owner) {
+  auto it = users_.find(stmt);
+  CHECK_NE(it, users_.end());
+  it->second.iterating = owner;
+}
+
+size_t StatementCache::memory_size() const {
+  size_t size = sizeof(*this);
+  for (const Entry& entry : lru_) {
+    size += sizeof(entry) + entry.sql.capacity() +
+            sqlite3_stmt_status(entry.stmt, SQLITE_STMTSTATUS_MEMUSED, 0);
+  }
+  return size;
+}
+
 DatabaseSync::DatabaseSync(Environment* env,
                            Local<Object> object,
                            DatabaseOpenConfiguration&& open_config,
                            bool open,
                            bool allow_load_extension)
-    : BaseObject(env, object), open_config_(std::move(open_config)) {
+    : BaseObject(env, object),
+      open_config_(std::move(open_config)),
+      statement_cache_(open_config_.get_statement_cache_size()) {
   MakeWeak();
   connection_ = nullptr;
   allow_load_extension_ = allow_load_extension;
@@ -683,6 +769,7 @@ DatabaseSync::~DatabaseSync() {
 
   if (IsOpen()) {
     FinalizeStatements();
+    statement_cache_.Clear();
     DeleteSessions();
     sqlite3_close_v2(connection_);
     connection_ = nullptr;
@@ -693,6 +780,8 @@ void DatabaseSync::MemoryInfo(MemoryTracker* tracker) const {
   // TODO(tniessen): more accurately track the size of all fields
   tracker->TrackFieldWithSize(
       "open_config", sizeof(open_config_), "DatabaseOpenConfiguration");
+  tracker->TrackFieldWithSize(
+      "statement_cache", statement_cache_.memory_size(), "StatementCache");
 }
 
 bool DatabaseSync::Open() {
@@ -766,6 +855,10 @@ void DatabaseSync::FinalizeStatements() {
   statements_.clear();
 }
 
+bool DatabaseSync::ReleaseStatement(sqlite3_stmt* stmt) {
+  return statement_cache_.Release(stmt);
+}
+
 void DatabaseSync::UntrackStatement(StatementSync* statement) {
   auto it = statements_.find(statement);
   if (it != statements_.end()) {
@@ -961,6 +1054,27 @@ void DatabaseSync::New(const FunctionCallbackInfo<Value>& args) {
 
       open_config.set_timeout(timeout_v.As<Int32>()->Value());
     }
+
+    Local<String> statement_cache_size_string =
+        FIXED_ONE_BYTE_STRING(env->isolate(), "statementCacheSize");
+    Local<Value> statement_cache_size_v;
+    if (!options->Get(env->context(), statement_cache_size_string)
+             .ToLocal(&statement_cache_size_v)) {
+      return;
+    }
+
+    if (!statement_cache_size_v->IsUndefined()) {
+      if (!statement_cache_size_v->IsUint32()) {
+        THROW_ERR_INVALID_ARG_TYPE(
+            env->isolate(),
+            "The \"options.statementCacheSize\" argument must be a "
+            "non-negative integer.");
+        return;
+      }
+
+      open_config.set_statement_cache_size(
+          statement_cache_size_v.As<Uint32>()->Value());
+    }
   }
 
   new DatabaseSync(
@@ -994,6 +1108,7 @@ void DatabaseSync::Close(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   THROW_AND_RETURN_ON_BAD_STATE(env, !db->IsOpen(), "database is not open");
   db->FinalizeStatements();
+  db->statement_cache_.Clear();
   db->DeleteSessions();
   int r = sqlite3_close_v2(db->connection_);
   CHECK_ERROR_OR_THROW(env->isolate(), db, r, SQLITE_OK, void());
@@ -1013,15 +1128,53 @@ void DatabaseSync::Prepare(const FunctionCallbackInfo<Value>& args) {
   }
 
   Utf8Value sql(env->isolate(), args[0].As<String>());
+  // Statements compiled against an older schema are reprepared by SQLite
+  // when they are stepped, so cached ones never go stale.
+  StatementCache* cache = &db->statement_cache_;
   sqlite3_stmt* s = nullptr;
-  int r = sqlite3_prepare_v2(db->connection_, *sql, -1, &s, 0);
-  CHECK_ERROR_OR_THROW(env->isolate(), db, r, SQLITE_OK, void());
+  if (cache->enabled()) {
+    s = cache->Acquire(sql.ToStringView());
+  }
+  bool shared = s != nullptr;
+  if (s == nullptr) {
+    int r = sqlite3_prepare_v2(db->connection_, *sql, -1, &s, 0);
+    CHECK_ERROR_OR_THROW(env->isolate(), db, r, SQLITE_OK, void());
+    if (cache->enabled() && s != nullptr) {
+      cache->Insert(sql.ToStringView(), s);
+      shared = true;
+    }
+  }
   BaseObjectPtr<StatementSync> stmt =
-      StatementSync::Create(env, BaseObjectPtr<DatabaseSync>(db), s);
+      StatementSync::Create(env, BaseObjectPtr<DatabaseSync>(db), s, shared);
   db->statements_.insert(stmt.get());
   args.GetReturnValue().Set(stmt->object());
 }
 
+void DatabaseSync::StatementCacheStats(
+    const FunctionCallbackInfo<Value>& args) {
+  DatabaseSync* db;
+  ASSIGN_OR_RETURN_UNWRAP(&db, args.This());
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  const StatementCache& cache = db->statement_cache_;
+  LocalVector<Name> keys(isolate,
+                         {FIXED_ONE_BYTE_STRING(isolate, "capacity"),
+                          FIXED_ONE_BYTE_STRING(isolate, "size"),
+                          FIXED_ONE_BYTE_STRING(isolate, "hits"),
+                          FIXED_ONE_BYTE_STRING(isolate, "misses"),
+                          FIXED_ONE_BYTE_STRING(isolate, "evictions")});
+  LocalVector<Value> values(
+      isolate,
+      {Number::New(isolate, static_cast<double>(cache.capacity())),
+       Number::New(isolate, static_cast<double>(cache.size())),
+       Number::New(isolate, static_cast<double>(cache.hits())),
+       Number::New(isolate, static_cast<double>(cache.misses())),
+       Number::New(isolate, static_cast<double>(cache.evictions()))});
+  Local<Object> stats = Object::New(
+      isolate, Null(isolate), keys.data(), values.data(), keys.size());
+  args.GetReturnValue().Set(stats);
+}
+
 void DatabaseSync::Exec(const FunctionCallbackInfo<Value>& args) {
   DatabaseSync* db;
   ASSIGN_OR_RETURN_UNWRAP(&db, args.This());
@@ -1755,10 +1908,12 @@ void DatabaseSync::LoadExtension(const FunctionCallbackInfo<Value>& args) {
 StatementSync::StatementSync(Environment* env,
                              Local<Object> object,
                              BaseObjectPtr<DatabaseSync> db,
-                             sqlite3_stmt* stmt)
+                             sqlite3_stmt* stmt,
+                             bool shared)
     : BaseObject(env, object), db_(std::move(db)) {
   MakeWeak();
   statement_ = stmt;
+  shared_ = shared;
   // In the future, some of these options could be set at the database
   // connection level and inherited by statements to reduce boilerplate.
   return_arrays_ = false;
@@ -1776,7 +1931,10 @@ StatementSync::~StatementSync() {
 }
 
 void StatementSync::Finalize() {
-  sqlite3_finalize(statement_);
+  EndIteration();
+  if (!db_->ReleaseStatement(statement_)) {
+    sqlite3_finalize(statement_);
+  }
   statement_ = nullptr;
 }
 
@@ -1784,6 +1942,38 @@ inline bool StatementSync::IsFinalized() {
   return statement_ == nullptr;
 }
 
+bool StatementSync::Borrow() {
+  generation_++;
+  if (!shared_) {
+    return true;
+  }
+  StatementCache* cache = db_->statement_cache();
+  StatementSync* iterating = cache->iterating(statement_);
+  if (iterating == this) {
+    // Resetting the statement ends this StatementSync's own iteration, as it
+    // always did.
+    cache->set_iterating(statement_, nullptr);
+    return true;
+  }
+  if (iterating == nullptr && !sqlite3_stmt_busy(statement_)) {
+    return true;
+  }
+  sqlite3_stmt* copy = nullptr;
+  int r = sqlite3_prepare_v2(
+      db_->Connection(), sqlite3_sql(statement_), -1, &copy, nullptr);
+  CHECK_ERROR_OR_THROW(env()->isolate(), db_.get(), r, SQLITE_OK, false);
+  CHECK(db_->ReleaseStatement(statement_));
+  statement_ = copy;
+  shared_ = false;
+  return true;
+}
+
+void StatementSync::EndIteration() {
+  if (shared_ && db_->statement_cache()->iterating(statement_) == this) {
+    db_->statement_cache()->set_iterating(statement_, nullptr);
+  }
+}
+
 bool StatementSync::BindParams(const FunctionCallbackInfo<Value>& args) {
   int r = sqlite3_clear_bindings(statement_);
   CHECK_ERROR_OR_THROW(env()->isolate(), db_.get(), r, SQLITE_OK, false);
@@ -1950,6 +2140,9 @@ void StatementSync::All(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   THROW_AND_RETURN_ON_BAD_STATE(
       env, stmt->IsFinalized(), "statement has been finalized");
+  if (!stmt->Borrow()) {
+    return;
+  }
   Isolate* isolate = env->isolate();
   int r = sqlite3_reset(stmt->statement_);
   CHECK_ERROR_OR_THROW(isolate, stmt->db_.get(), r, SQLITE_OK, void());
@@ -2013,6 +2206,9 @@ void StatementSync::Iterate(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   THROW_AND_RETURN_ON_BAD_STATE(
       env, stmt->IsFinalized(), "statement has been finalized");
+  if (!stmt->Borrow()) {
+    return;
+  }
   auto isolate = env->isolate();
   auto context = env->context();
   int r = sqlite3_reset(stmt->statement_);
@@ -2036,6 +2232,9 @@ void StatementSync::Iterate(const FunctionCallbackInfo<Value>& args) {
 
   BaseObjectPtr<StatementSyncIterator> iter =
       StatementSyncIterator::Create(env, BaseObjectPtr<StatementSync>(stmt));
+  if (stmt->shared_) {
+    stmt->db_->statement_cache()->set_iterating(stmt->statement_, stmt);
+  }
 
   if (iter->object()
           ->GetPrototype()
@@ -2054,6 +2253,9 @@ void StatementSync::Get(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   THROW_AND_RETURN_ON_BAD_STATE(
       env, stmt->IsFinalized(), "statement has been finalized");
+  if (!stmt->Borrow()) {
+    return;
+  }
   Isolate* isolate = env->isolate();
   int r = sqlite3_reset(stmt->statement_);
   CHECK_ERROR_OR_THROW(isolate, stmt->db_.get(), r, SQLITE_OK, void());
@@ -2115,6 +2317,9 @@ void StatementSync::Run(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   THROW_AND_RETURN_ON_BAD_STATE(
       env, stmt->IsFinalized(), "statement has been finalized");
+  if (!stmt->Borrow()) {
+    return;
+  }
   int r = sqlite3_reset(stmt->statement_);
   CHECK_ERROR_OR_THROW(env->isolate(), stmt->db_.get(), r, SQLITE_OK, void());
 
@@ -2385,7 +2590,10 @@ Local<FunctionTemplate> StatementSync::GetConstructorTemplate(
 }
 
 BaseObjectPtr<StatementSync> StatementSync::Create(
-    Environment* env, BaseObjectPtr<DatabaseSync> db, sqlite3_stmt* stmt) {
+    Environment* env,
+    BaseObjectPtr<DatabaseSync> db,
+    sqlite3_stmt* stmt,
+    bool shared) {
   Local<Object> obj;
   if (!GetConstructorTemplate(env)
            ->InstanceTemplate()
@@ -2394,7 +2602,7 @@ BaseObjectPtr<StatementSync> StatementSync::Create(
     return nullptr;
   }
 
-  return MakeBaseObject<StatementSync>(env, obj, std::move(db), stmt);
+  return MakeBaseObject<StatementSync>(env, obj, std::move(db), stmt, shared);
 }
 
 StatementSyncIterator::StatementSyncIterator(Environment* env,
@@ -2402,6 +2610,7 @@ StatementSyncIterator::StatementSyncIterator(Environment* env,
                                              BaseObjectPtr<StatementSync> stmt)
     : BaseObject(env, object), stmt_(std::move(stmt)) {
   MakeWeak();
+  generation_ = stmt_->generation_;
   done_ = false;
 }
 
@@ -2447,6 +2656,11 @@ void StatementSyncIterator::Next(const FunctionCallbackInfo<Value>& args) {
   Isolate* isolate = env->isolate();
   LocalVector<Name> keys(isolate, {env->done_string(), env->value_string()});
 
+  // Another call on the statement reset it, this iteration is over.
+  if (iter->generation_ != iter->stmt_->generation_) {
+    iter->done_ = true;
+  }
+
   if (iter->done_) {
     LocalVector<Value> values(isolate,
                               {Boolean::New(isolate, true), Null(isolate)});
@@ -2462,6 +2676,8 @@ void StatementSyncIterator::Next(const FunctionCallbackInfo<Value>& args) {
     CHECK_ERROR_OR_THROW(
         env->isolate(), iter->stmt_->db_.get(), r, SQLITE_DONE, void());
     sqlite3_reset(iter->stmt_->statement_);
+    iter->stmt_->EndIteration();
+    iter->done_ = true;
     LocalVector<Value> values(isolate,
                               {Boolean::New(isolate, true), Null(isolate)});
     DCHECK_EQ(values.size(), keys.size());
@@ -2517,7 +2733,10 @@ void StatementSyncIterator::Return(const FunctionCallbackInfo<Value>& args) {
       env, iter->stmt_->IsFinalized(), "statement has been finalized");
   Isolate* isolate = env->isolate();
 
-  sqlite3_reset(iter->stmt_->statement_);
+  if (!iter->done_ && iter->generation_ == iter->stmt_->generation_) {
+    sqlite3_reset(iter->stmt_->statement_);
+    iter->stmt_->EndIteration();
+  }
   iter->done_ = true;
   LocalVector<Name> keys(isolate, {env->done_string(), env->value_string()});
   LocalVector<Value> values(isolate,
@@ -2668,6 +2887,10 @@ static void Initialize(Local<Object> target,
                  DatabaseSync::EnableLoadExtension);
   SetProtoMethod(
       isolate, db_tmpl, "loadExtension", DatabaseSync::LoadExtension);
+  SetProtoMethodNoSideEffect(isolate,
+                             db_tmpl,
+                             "statementCacheStats",
+                             DatabaseSync::StatementCacheStats);
   SetSideEffectFreeGetter(isolate,
                           db_tmpl,
                           FIXED_ONE_BYTE_STRING(isolate, "isOpen"),
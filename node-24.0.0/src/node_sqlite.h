@@ -8,7 +8,11 @@
 #include "sqlite3.h"
 #include "util.h"
 
+#include <list>
 #include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace node {
@@ -39,17 +43,90 @@ class DatabaseOpenConfiguration {
 
   inline int get_timeout() { return timeout_; }
 
+  inline void set_statement_cache_size(uint32_t size) {
+    statement_cache_size_ = size;
+  }
+
+  inline uint32_t get_statement_cache_size() const {
+    return statement_cache_size_;
+  }
+
  private:
   std::string location_;
   bool read_only_ = false;
   bool enable_foreign_keys_ = true;
   bool enable_dqs_ = false;
   int timeout_ = 0;
+  uint32_t statement_cache_size_ = 0;
 };
 
+// Bounded LRU cache of prepared statements keyed by their SQL text. A cached
+// statement stays in the cache and is shared by every StatementSync prepared
+// from the same SQL. Each of them only borrows it for the length of a
+// run/get/all/iterate call, which resets it and binds its parameters again.
+// A StatementSync that finds the statement in the middle of another call
+// switches to a private copy, see StatementSync::Borrow(). Statements that
+// are evicted while still shared are finalized once their last user releases
+// them.
 class StatementSync;
 class BackupJob;
 
+class StatementCache {
+ public:
+  explicit StatementCache(size_t capacity) : capacity_(capacity) {}
+
+  inline bool enabled() const { return capacity_ > 0; }
+  inline size_t capacity() const { return capacity_; }
+  inline size_t size() const { return lru_.size(); }
+  inline uint64_t hits() const { return hits_; }
+  inline uint64_t misses() const { return misses_; }
+  inline uint64_t evictions() const { return evictions_; }
+
+  // Returns the cached statement for sql and counts one more user of it, or
+  // returns nullptr on a miss.
+  sqlite3_stmt* Acquire(std::string_view sql);
+  // Caches a statement that was just prepared from sql and counts it as
+  // acquired once.
+  void Insert(std::string_view sql, sqlite3_stmt* stmt);
+  // Returns false if stmt did not come from the cache, in which case the
+  // caller still owns it.
+  bool Release(sqlite3_stmt* stmt);
+  // Drops all entries. Statements in use stay valid until they are released.
+  void Clear();
+
+  // The StatementSync whose iteration may still be stepping stmt, if any.
+  // Nobody else may reset stmt in the meantime.
+  StatementSync* iterating(sqlite3_stmt* stmt) const;
+  void set_iterating(sqlite3_stmt* stmt, StatementSync* owner);
+
+  size_t memory_size() const;
+
+ private:
+  struct Entry {
+    std::string sql;
+    sqlite3_stmt* stmt;
+  };
+
+  struct Users {
+    size_t count;
+    bool cached;
+    StatementSync* iterating;
+  };
+
+  void Evict(std::list<Entry>::iterator it);
+
+  size_t capacity_;
+  // Most recently used first.
+  std::list<Entry> lru_;
+  std::unordered_map<std::string_view, std::list<Entry>::iterator> entries_;
+  // Every statement handed out by the cache, including evicted ones that are
+  // still in use.
+  std::unordered_map<sqlite3_stmt*, Users> users_;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+  uint64_t evictions_ = 0;
+};
+
 class DatabaseSync : public BaseObject {
  public:
   DatabaseSync(Environment* env,
@@ -75,7 +152,11 @@ class DatabaseSync : public BaseObject {
   static void EnableLoadExtension(
       const v8::FunctionCallbackInfo<v8::Value>& args);
   static void LoadExtension(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void StatementCacheStats(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
   void FinalizeStatements();
+  bool ReleaseStatement(sqlite3_stmt* stmt);
+  inline StatementCache* statement_cache() { return &statement_cache_; }
   void RemoveBackup(BackupJob* backup);
   void AddBackup(BackupJob* backup);
   void FinalizeBackups();
@@ -103,6 +184,7 @@ class DatabaseSync : public BaseObject {
   bool enable_load_extension_;
   sqlite3* connection_;
   bool ignore_next_sqlite_error_;
+  StatementCache statement_cache_;
 
   std::set<BackupJob*> backups_;
   std::set<sqlite3_session*> sessions_;
@@ -116,13 +198,15 @@ class StatementSync : public BaseObject {
   StatementSync(Environment* env,
                 v8::Local<v8::Object> object,
                 BaseObjectPtr<DatabaseSync> db,
-                sqlite3_stmt* stmt);
+                sqlite3_stmt* stmt,
+                bool shared);
   void MemoryInfo(MemoryTracker* tracker) const override;
   static v8::Local<v8::FunctionTemplate> GetConstructorTemplate(
       Environment* env);
   static BaseObjectPtr<StatementSync> Create(Environment* env,
                                              BaseObjectPtr<DatabaseSync> db,
-                                             sqlite3_stmt* stmt);
+                                             sqlite3_stmt* stmt,
+                                             bool shared);
   static void All(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Iterate(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Get(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -147,11 +231,23 @@ class StatementSync : public BaseObject {
   ~StatementSync() override;
   BaseObjectPtr<DatabaseSync> db_;
   sqlite3_stmt* statement_;
+  // statement_ belongs to the statement cache and may be shared with other
+  // StatementSyncs.
+  bool shared_;
+  // Bumped by every call that resets statement_, so that an iterator can tell
+  // that it was superseded.
+  uint64_t generation_ = 0;
   bool return_arrays_ = false;
   bool use_big_ints_;
   bool allow_bare_named_params_;
   bool allow_unknown_named_params_;
   std::optional<std::map<std::string, std::string>> bare_named_params_;
+  // Called before every run/get/all/iterate. Switches to a private copy of a
+  // shared statement which is in the middle of a call of another
+  // StatementSync. Returns false if preparing that copy failed.
+  bool Borrow();
+  // Lets other StatementSyncs reset a shared statement_ again.
+  void EndIteration();
   bool BindParams(const v8::FunctionCallbackInfo<v8::Value>& args);
   bool BindValue(const v8::Local<v8::Value>& value, const int index);
   v8::MaybeLocal<v8::Value> ColumnToValue(const int column);
@@ -179,6 +275,8 @@ class StatementSyncIterator : public BaseObject {
  private:
   ~StatementSyncIterator() override;
   BaseObjectPtr<StatementSync> stmt_;
+  // StatementSync::generation_ when the iteration started.
+  uint64_t generation_;
   bool done_;
 };
 
@@ -13,6 +13,8 @@
 #include "util-inl.h"
 #include "v8-cppgc.h"
 
+#include <deque>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -138,99 +140,92 @@ void Worker::UpdateResourceConstraints(ResourceConstraints* constraints) {
   }
 }
 
-// This class contains data that is only relevant to the child thread itself,
-// and only while it is running.
-// (Eventually, the Environment instance should probably also be moved here.)
-class WorkerThreadData {
+// The parts of a worker that don't depend on the code it runs: its event loop
+// and an isolate deserialized from the snapshot, which the platform associates
+// with that loop. They are either created on the worker thread itself or ahead
+// of time by the WorkerIsolatePool.
+class WorkerIsolate {
  public:
-  explicit WorkerThreadData(Worker* w)
-    : w_(w) {
-    int ret = uv_loop_init(&loop_);
+  // Returns nullptr and sets `*error` on failure.
+  static std::unique_ptr<WorkerIsolate> Create(
+      MultiIsolatePlatform* platform,
+      const SnapshotData* snapshot_data,
+      std::shared_ptr<PerIsolateOptions> per_isolate_opts,
+      const std::function<void(ResourceConstraints*)>& update_constraints,
+      std::string* error) {
+    std::unique_ptr<WorkerIsolate> result(new WorkerIsolate(platform));
+    int ret = uv_loop_init(&result->loop_);
     if (ret != 0) {
       char err_buf[128];
       uv_err_name_r(ret, err_buf, sizeof(err_buf));
-      // TODO(joyeecheung): maybe this should be kBootstrapFailure instead?
-      w->Exit(ExitCode::kGenericUserError, "ERR_WORKER_INIT_FAILED", err_buf);
-      return;
+      *error = err_buf;
+      return nullptr;
     }
-    loop_init_failed_ = false;
-    uv_loop_configure(&loop_, UV_METRICS_IDLE_TIME);
+    result->loop_init_failed_ = false;
+    uv_loop_configure(&result->loop_, UV_METRICS_IDLE_TIME);
 
     std::shared_ptr<ArrayBufferAllocator> allocator =
         ArrayBufferAllocator::Create();
     Isolate::CreateParams params;
     SetIsolateCreateParamsForNode(&params);
-    w->UpdateResourceConstraints(&params.constraints);
+    update_constraints(&params.constraints);
+    result->constraints_ = params.constraints;
     params.array_buffer_allocator_shared = allocator;
     Isolate* isolate =
-        NewIsolate(&params, &loop_, w->platform_, w->snapshot_data());
+        NewIsolate(&params, &result->loop_, platform, snapshot_data);
     if (isolate == nullptr) {
-      // TODO(joyeecheung): maybe this should be kBootstrapFailure instead?
-      w->Exit(ExitCode::kGenericUserError,
-              "ERR_WORKER_INIT_FAILED",
-              "Failed to create new Isolate");
-      return;
+      *error = "Failed to create new Isolate";
+      return nullptr;
     }
+    result->isolate_ = isolate;
 
     SetIsolateUpForNode(isolate);
 
-    // Be sure it's called before Environment::InitializeDiagnostics()
-    // so that this callback stays when the callback of
-    // --heapsnapshot-near-heap-limit gets is popped.
-    isolate->AddNearHeapLimitCallback(Worker::NearHeapLimit, w);
-
     {
       Locker locker(isolate);
       Isolate::Scope isolate_scope(isolate);
       // V8 computes its stack limit the first time a `Locker` is used based on
       // --stack-size. Reset it to the correct value.
-      isolate->SetStackLimit(w->stack_base_);
+      if (params.constraints.stack_limit() != nullptr) {
+        isolate->SetStackLimit(
+            reinterpret_cast<uintptr_t>(params.constraints.stack_limit()));
+      }
 
       HandleScope handle_scope(isolate);
-      isolate_data_.reset(IsolateData::CreateIsolateData(
+      result->isolate_data_.reset(IsolateData::CreateIsolateData(
           isolate,
-          &loop_,
-          w_->platform_,
+          &result->loop_,
+          platform,
           allocator.get(),
-          w->snapshot_data()->AsEmbedderWrapper().get(),
-          std::move(w_->per_isolate_opts_)));
-      CHECK(isolate_data_);
-      CHECK(!isolate_data_->is_building_snapshot());
-      isolate_data_->set_worker_context(w_);
-      isolate_data_->max_young_gen_size =
+          snapshot_data->AsEmbedderWrapper().get(),
+          std::move(per_isolate_opts)));
+      CHECK(result->isolate_data_);
+      CHECK(!result->isolate_data_->is_building_snapshot());
+      result->isolate_data_->max_young_gen_size =
           params.constraints.max_young_generation_size_in_bytes();
     }
 
-    Mutex::ScopedLock lock(w_->mutex_);
-    w_->isolate_ = isolate;
+    return result;
   }
 
-  ~WorkerThreadData() {
-    Debug(w_, "Worker %llu dispose isolate", w_->thread_id_.id);
-    Isolate* isolate;
-    {
-      Mutex::ScopedLock lock(w_->mutex_);
-      isolate = w_->isolate_;
-      w_->isolate_ = nullptr;
-    }
-
-    if (isolate != nullptr) {
+  ~WorkerIsolate() {
+    if (isolate_ != nullptr) {
       CHECK(!loop_init_failed_);
       bool platform_finished = false;
 
       // https://github.com/nodejs/node/issues/51129 - IsolateData destructor
       // can kick off GC before teardown, so ensure the isolate is entered.
       {
-        Locker locker(isolate);
-        Isolate::Scope isolate_scope(isolate);
+        Locker locker(isolate_);
+        Isolate::Scope isolate_scope(isolate_);
         isolate_data_.reset();
       }
 
-      w_->platform_->AddIsolateFinishedCallback(isolate, [](void* data) {
+      platform_->AddIsolateFinishedCallback(isolate_, [](void* data) {
         *static_cast<bool*>(data) = true;
       }, &platform_finished);
 
-      w_->platform_->DisposeIsolate(isolate);
+      platform_->DisposeIsolate(isolate_);
 
       // Wait until the platform has cleaned up all relevant resources.
       while (!platform_finished) {
@@ -242,14 +237,233 @@ class WorkerThreadData {
     }
   }
 
-  bool loop_is_usable() const { return !loop_init_failed_; }
+  WorkerIsolate(const WorkerIsolate&) = delete;
+  WorkerIsolate& operator=(const WorkerIsolate&) = delete;
+
+  Isolate* isolate() const { return isolate_; }
+  IsolateData* isolate_data() const { return isolate_data_.get(); }
+  const ResourceConstraints& constraints() const { return constraints_; }
 
  private:
-  Worker* const w_;
+  explicit WorkerIsolate(MultiIsolatePlatform* platform)
+      : platform_(platform) {}
+
+  MultiIsolatePlatform* const platform_;
   uv_loop_t loop_;
   bool loop_init_failed_ = true;
+  Isolate* isolate_ = nullptr;
   DeleteFnPtr<IsolateData, FreeIsolateData> isolate_data_;
-  const SnapshotData* snapshot_data_ = nullptr;
+  ResourceConstraints constraints_;
+};
+
+// Keeps up to --worker-isolate-pool-size WorkerIsolates for the Workers of a
+// main thread ready, so that starting one only has to create its context and
+// Environment. The pool is refilled from a thread of its own. Only Workers
+// that would create their isolate exactly like the pool does take from it,
+// i.e. ones that use the parent's options and the default heap limits.
+class WorkerIsolatePool {
+ public:
+  // Returns nullptr if the pool is disabled or `env` is not the main thread.
+  static WorkerIsolatePool* Get(Environment* env) {
+    if (!env->is_main_thread()) return nullptr;
+    if (pool_ != nullptr) return pool_->env_ == env ? pool_ : nullptr;
+
+    int64_t size;
+    {
+      Mutex::ScopedLock lock(per_process::cli_options_mutex);
+      size = per_process::cli_options->worker_isolate_pool_size;
+    }
+    if (size <= 0) return nullptr;
+
+    pool_ = new WorkerIsolatePool(env, static_cast<size_t>(size));
+    if (!pool_->Start()) {
+      delete pool_;
+      pool_ = nullptr;
+      return nullptr;
+    }
+    env->AddCleanupHook(
+        [](void* data) {
+          delete static_cast<WorkerIsolatePool*>(data);
+          pool_ = nullptr;
+        },
+        pool_);
+    return pool_;
+  }
+
+  // Returns nullptr if no isolate is ready, the caller creates its own then.
+  std::unique_ptr<WorkerIsolate> Take() {
+    Mutex::ScopedLock lock(mutex_);
+    if (ready_.empty()) return nullptr;
+    std::unique_ptr<WorkerIsolate> isolate = std::move(ready_.front());
+    ready_.pop_front();
+    taken_++;
+    cond_.Signal(lock);
+    return isolate;
+  }
+
+  static WorkerIsolatePool* current() { return pool_; }
+
+  WorkerIsolatePoolStats stats() {
+    Mutex::ScopedLock lock(mutex_);
+    return {ready_.size(), taken_, refilling_};
+  }
+
+  bool Matches(MultiIsolatePlatform* platform,
+               const SnapshotData* snapshot_data) const {
+    return platform == platform_ && snapshot_data == snapshot_data_;
+  }
+
+  ~WorkerIsolatePool() {
+    {
+      Mutex::ScopedLock lock(mutex_);
+      stopping_ = true;
+      cond_.Signal(lock);
+    }
+    CHECK_EQ(uv_thread_join(&thread_), 0);
+    // Disposed here rather than on the pool thread, which may not dispose an
+    // isolate while it's being created.
+    ready_.clear();
+  }
+
+ private:
+  WorkerIsolatePool(Environment* env, size_t size)
+      : env_(env),
+        platform_(env->isolate_data()->platform()),
+        snapshot_data_(env->isolate_data()->snapshot_data()),
+        per_isolate_opts_(env->isolate_data()->options()->Clone()),
+        size_(size) {}
+
+  bool Start() {
+    return uv_thread_create(
+               &thread_,
+               [](void* data) {
+                 uv_thread_setname("WorkerIsolatePool");
+                 static_cast<WorkerIsolatePool*>(data)->Refill();
+               },
+               this) == 0;
+  }
+
+  void Refill() {
+    Mutex::ScopedLock lock(mutex_);
+    while (true) {
+      while (!stopping_ && ready_.size() >= size_) cond_.Wait(lock);
+      if (stopping_) return;
+
+      std::unique_ptr<WorkerIsolate> isolate;
+      std::string error;
+      refilling_ = true;
+      {
+        Mutex::ScopedUnlock unlock(lock);
+        isolate = WorkerIsolate::Create(platform_,
+                                        snapshot_data_,
+                                        per_isolate_opts_->Clone(),
+                                        [](ResourceConstraints*) {},
+                                        &error);
+      }
+      refilling_ = false;
+      if (!isolate) {
+        // Workers still create their own isolates, and likely fail the same
+        // way, so there's no point in trying again.
+        per_process::Debug(DebugCategory::WORKER,
+                           "Worker isolate pool stops: %s\n",
+                           error.c_str());
+        return;
+      }
+      ready_.push_back(std::move(isolate));
+    }
+  }
+
+  static WorkerIsolatePool* pool_;
+
+  Environment* const env_;
+  MultiIsolatePlatform* const platform_;
+  const SnapshotData* const snapshot_data_;
+  const std::shared_ptr<PerIsolateOptions> per_isolate_opts_;
+  const size_t size_;
+  uv_thread_t thread_;
+
+  Mutex mutex_;
+  ConditionVariable cond_;
+  std::deque<std::unique_ptr<WorkerIsolate>> ready_;
+  size_t taken_ = 0;
+  bool refilling_ = false;
+  bool stopping_ = false;
+};
+
+// Only accessed from the main thread.
+WorkerIsolatePool* WorkerIsolatePool::pool_ = nullptr;
+
+bool GetWorkerIsolatePoolStats(WorkerIsolatePoolStats* stats) {
+  WorkerIsolatePool* pool = WorkerIsolatePool::current();
+  if (pool == nullptr) return false;
+  *stats = pool->stats();
+  return true;
+}
+
+// This class contains data that is only relevant to the child thread itself,
+// and only while it is running.
+// (Eventually, the Environment instance should probably also be moved here.)
+class WorkerThreadData {
+ public:
+  explicit WorkerThreadData(Worker* w)
+    : w_(w) {
+    isolate_ = std::move(w->warm_isolate_);
+    if (isolate_) {
+      Debug(w, "Worker %llu uses a pre-warmed isolate", w->thread_id_.id);
+      // Only fills in the default limits, the worker sets none of its own.
+      ResourceConstraints constraints = isolate_->constraints();
+      w->UpdateResourceConstraints(&constraints);
+    } else {
+      std::string error;
+      isolate_ = WorkerIsolate::Create(
+          w->platform_,
+          w->snapshot_data(),
+          std::move(w->per_isolate_opts_),
+          [w](ResourceConstraints* constraints) {
+            w->UpdateResourceConstraints(constraints);
+          },
+          &error);
+      if (!isolate_) {
+        // TODO(joyeecheung): maybe this should be kBootstrapFailure instead?
+        w->Exit(ExitCode::kGenericUserError,
+                "ERR_WORKER_INIT_FAILED",
+                error.c_str());
+        return;
+      }
+    }
+    Isolate* isolate = isolate_->isolate();
+
+    // Be sure it's called before Environment::InitializeDiagnostics()
+    // so that this callback stays when the callback of
+    // --heapsnapshot-near-heap-limit gets is popped.
+    isolate->AddNearHeapLimitCallback(Worker::NearHeapLimit, w);
+
+    {
+      Locker locker(isolate);
+      Isolate::Scope isolate_scope(isolate);
+      // A pre-warmed isolate was last locked on the pool's thread.
+      isolate->SetStackLimit(w->stack_base_);
+      isolate_->isolate_data()->set_worker_context(w_);
+    }
+
+    Mutex::ScopedLock lock(w_->mutex_);
+    w_->isolate_ = isolate;
+  }
+
+  ~WorkerThreadData() {
+    Debug(w_, "Worker %llu dispose isolate", w_->thread_id_.id);
+    {
+      Mutex::ScopedLock lock(w_->mutex_);
+      w_->isolate_ = nullptr;
+    }
+    isolate_.reset();
+  }
+
+  IsolateData* isolate_data() const { return isolate_->isolate_data(); }
+
+ private:
+  Worker* const w_;
+  std::unique_ptr<WorkerIsolate> isolate_;
   friend class Worker;
 };
 
@@ -287,7 +501,6 @@ void Worker::Run() {
 
   WorkerThreadData data(this);
   if (isolate_ == nullptr) return;
-  CHECK(data.loop_is_usable());
 
   Debug(this, "Starting worker with id %llu", thread_id_.id);
   {
@@ -358,7 +571,7 @@ void Worker::Run() {
         environment_flags_ |= EnvironmentFlags::kNoWaitForInspectorFrontend;
 #endif
         env_.reset(CreateEnvironment(
-            data.isolate_data_.get(),
+            data.isolate_data(),
             context,
             std::move(argv_),
             std::move(exec_argv_),
@@ -508,6 +721,7 @@ void Worker::New(const FunctionCallbackInfo<Value>& args) {
   std::shared_ptr<KVStore> env_vars = nullptr;
 
   std::vector<std::string> exec_argv_out;
+  bool uses_parent_options = false;
 
   // Argument might be a string or URL
   if (!args[0]->IsNullOrUndefined()) {
@@ -664,6 +878,7 @@ void Worker::New(const FunctionCallbackInfo<Value>& args) {
     // Copy the parent's execArgv.
     exec_argv_out = env->exec_argv();
     per_isolate_opts = env->isolate_data()->options()->Clone();
+    uses_parent_options = true;
   }
 
   // Internal workers should not wait for inspector frontend to connect or
@@ -705,6 +920,11 @@ void Worker::New(const FunctionCallbackInfo<Value>& args) {
     worker->environment_flags_ |= EnvironmentFlags::kNoGlobalSearchPaths;
   if (env->no_browser_globals())
     worker->environment_flags_ |= EnvironmentFlags::kNoBrowserGlobals;
+
+  // Starts filling the pool with the first Worker, which creates its own
+  // isolate.
+  worker->can_use_warm_isolate_ = uses_parent_options && !is_internal &&
+                                  WorkerIsolatePool::Get(env) != nullptr;
 }
 
 void Worker::StartThread(const FunctionCallbackInfo<Value>& args) {
@@ -726,6 +946,15 @@ void Worker::StartThread(const FunctionCallbackInfo<Value>& args) {
     w->resource_limits_[kStackSizeMb] = w->stack_size_ / kMB;
   }
 
+  if (w->can_use_warm_isolate_ &&
+      w->resource_limits_[kMaxYoungGenerationSizeMb] <= 0 &&
+      w->resource_limits_[kMaxOldGenerationSizeMb] <= 0 &&
+      w->resource_limits_[kCodeRangeSizeMb] <= 0) {
+    WorkerIsolatePool* pool = WorkerIsolatePool::Get(w->env());
+    if (pool != nullptr && pool->Matches(w->platform_, w->snapshot_data_))
+      w->warm_isolate_ = pool->Take();
+  }
+
   uv_thread_options_t thread_options;
   thread_options.flags = UV_THREAD_HAS_STACK_SIZE;
   thread_options.stack_size = w->stack_size_;
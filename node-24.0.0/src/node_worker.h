@@ -14,6 +14,7 @@ namespace node {
 struct SnapshotData;
 namespace worker {
 
+class WorkerIsolate;
 class WorkerThreadData;
 
 enum ResourceLimits {
@@ -24,6 +25,16 @@ enum ResourceLimits {
   kTotalResourceLimitCount
 };
 
+// State of the --worker-isolate-pool-size pool of the main thread, for tests.
+struct WorkerIsolatePoolStats {
+  size_t ready;     // Isolates waiting for a Worker.
+  size_t taken;     // Isolates handed out to Workers so far.
+  bool refilling;   // Whether the pool thread is creating an isolate.
+};
+
+// Returns false if there is no pool. Only called on the main thread.
+bool GetWorkerIsolatePoolStats(WorkerIsolatePoolStats* stats);
+
 // A worker thread, as represented in its parent thread.
 class Worker : public AsyncWrap {
  public:
@@ -137,6 +148,12 @@ class Worker : public AsyncWrap {
 
   const SnapshotData* snapshot_data_ = nullptr;
   const bool is_internal_;
+
+  // Set if the isolate could come from the WorkerIsolatePool, and to the
+  // isolate taken from it when the thread is started.
+  bool can_use_warm_isolate_ = false;
+  std::unique_ptr<WorkerIsolate> warm_isolate_;
+
   friend class WorkerThreadData;
 };
 
@@ -40,6 +40,7 @@
 
 #include <sys/types.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdlib>
 #include <cstring>
@@ -150,6 +151,27 @@ enum node_zlib_mode {
   ZSTD_DECOMPRESS
 };
 
+// Measured cost of compressing on the loop thread, see
+// CompressionStream::ShouldWriteInline(). It is shared by all streams of the
+// process that use the same algorithm at the same level, so that a fresh
+// stream can make use of what earlier streams measured.
+struct InlineWriteCost {
+  // out_per_in is a fixed point number with this many fractional bits.
+  static constexpr unsigned kOutPerInShift = 8;
+
+  // Cost of a write per KiB of work, 0 until the first write was measured.
+  std::atomic<uint64_t> ns_per_kb{0};
+  // Moving average of the output produced per byte of input consumed.
+  std::atomic<uint64_t> out_per_in{uint64_t{1} << kOutPerInShift};
+};
+
+// Levels outside of [-1, 22] share the entry of the closest level.
+InlineWriteCost* GetInlineWriteCost(node_zlib_mode mode, int level) {
+  static constexpr int kLevels = 24;
+  static InlineWriteCost costs[ZSTD_DECOMPRESS + 1][kLevels];
+  return &costs[mode][std::clamp(level, -1, kLevels - 2) + 1];
+}
+
 constexpr uint8_t GZIP_HEADER_ID1 = 0x1f;
 constexpr uint8_t GZIP_HEADER_ID2 = 0x8b;
 
@@ -183,6 +205,11 @@ class ZlibContext final : public MemoryRetainer {
   CompressionError GetErrorInfo() const;
   inline void SetMode(node_zlib_mode mode) { mode_ = mode; }
   CompressionError ResetStream();
+  // zlib does work in proportion to each write at all levels.
+  bool CanWriteInline() const { return true; }
+  InlineWriteCost* inline_write_cost() const {
+    return GetInlineWriteCost(mode_, level_);
+  }
 
   // Zlib-specific:
   void Init(int level, int window_bits, int mem_level, int strategy,
@@ -259,13 +286,22 @@ class BrotliEncoderContext final : public BrotliContext {
   CompressionError ResetStream();
   CompressionError SetParams(int key, uint32_t value);
   CompressionError GetErrorInfo() const;
+  // Higher qualities buffer their input and compress it block by block,
+  // which can take a long time for a single small write.
+  bool CanWriteInline() const { return quality_ <= kInlineMaxQuality; }
+  InlineWriteCost* inline_write_cost() const {
+    return GetInlineWriteCost(mode_, static_cast<int>(quality_));
+  }
 
   SET_MEMORY_INFO_NAME(BrotliEncoderContext)
   SET_SELF_SIZE(BrotliEncoderContext)
   SET_NO_MEMORY_INFO()  // state_ is covered through allocation tracking.
 
  private:
+  static constexpr uint32_t kInlineMaxQuality = 4;
+
   bool last_result_ = false;
+  uint32_t quality_ = BROTLI_DEFAULT_QUALITY;
   DeleteFnPtr<BrotliEncoderState, BrotliEncoderDestroyInstance> state_;
 };
 
@@ -279,6 +315,10 @@ class BrotliDecoderContext final : public BrotliContext {
   CompressionError ResetStream();
   CompressionError SetParams(int key, uint32_t value);
   CompressionError GetErrorInfo() const;
+  bool CanWriteInline() const { return true; }
+  InlineWriteCost* inline_write_cost() const {
+    return GetInlineWriteCost(mode_, 0);
+  }
 
   SET_MEMORY_INFO_NAME(BrotliDecoderContext)
   SET_SELF_SIZE(BrotliDecoderContext)
@@ -324,6 +364,13 @@ class ZstdCompressContext final : public ZstdContext {
   void DoThreadPoolWork();
   CompressionError ResetStream();
 
+  // Like brotli, zstd compresses whole blocks at a time, which gets slow
+  // at higher levels.
+  bool CanWriteInline() const { return level_ <= kInlineMaxLevel; }
+  InlineWriteCost* inline_write_cost() const {
+    return GetInlineWriteCost(ZSTD_COMPRESS, level_);
+  }
+
   // Zstd specific:
   CompressionError Init(uint64_t pledged_src_size);
   CompressionError SetParameter(int key, int value);
@@ -336,7 +383,10 @@ class ZstdCompressContext final : public ZstdContext {
   SET_NO_MEMORY_INFO()
 
  private:
+  static constexpr int kInlineMaxLevel = 3;
+
   DeleteFnPtr<ZSTD_CCtx, ZstdCompressContext::FreeZstd> cctx_;
+  int level_ = ZSTD_CLEVEL_DEFAULT;
 
   uint64_t pledged_src_size_ = ZSTD_CONTENTSIZE_UNKNOWN;
 };
@@ -348,6 +398,10 @@ class ZstdDecompressContext final : public ZstdContext {
   // Streaming-related, should be available for all compression libraries:
   void DoThreadPoolWork();
   CompressionError ResetStream();
+  bool CanWriteInline() const { return true; }
+  InlineWriteCost* inline_write_cost() const {
+    return GetInlineWriteCost(ZSTD_DECOMPRESS, 0);
+  }
 
   // Zstd specific:
   CompressionError Init(uint64_t pledged_src_size);
@@ -478,6 +532,7 @@ class CompressionStream : public AsyncWrap, public ThreadPoolWork {
 
     ctx_.SetBuffers(in, in_len, out, out_len);
     ctx_.SetFlush(flush);
+    write_flush_ = flush;
 
     if constexpr (!async) {
       // sync version
@@ -492,9 +547,44 @@ class CompressionStream : public AsyncWrap, public ThreadPoolWork {
     }
 
     // async version
+    if (ShouldWriteInline(flush, in_len, out_len)) {
+      // Cheaper than a round trip through the threadpool. The callback is
+      // still deferred so that it never runs from within write().
+      DoThreadPoolWork();
+      BaseObjectPtr<CompressionStream> strong_ref{this};
+      AsyncWrap::env()->SetImmediate([this, strong_ref](Environment* env) {
+        AfterThreadPoolWork(env->can_call_into_js() ? 0 : UV_ECANCELED);
+      });
+      return;
+    }
     ScheduleWork();
   }
 
+  // Small writes are done on the loop thread as long as the measured cost of
+  // this algorithm and level says they take at most kInlineWriteMaxNs. A
+  // flush also processes the input that earlier writes only buffered, so
+  // that input counts towards its size. Writes that only drain pending
+  // output and writes before the first measurement go to the threadpool.
+  bool ShouldWriteInline(uint32_t flush, uint32_t in_len, uint32_t out_len) {
+    uint64_t in_total = in_len;
+    if (flush != Z_NO_FLUSH) in_total += unflushed_in_;
+    if (in_total == 0 || in_total > kInlineWriteMaxBytes ||
+        !ctx_.CanWriteInline()) {
+      return false;
+    }
+    const InlineWriteCost* cost = ctx_.inline_write_cost();
+    uint64_t ns_per_kb = cost->ns_per_kb.load(std::memory_order_relaxed);
+    if (ns_per_kb == 0) return false;
+    // The work is the larger of input consumed and output produced, the
+    // latter is estimated from the output of earlier writes.
+    uint64_t expected_out = std::min<uint64_t>(
+        out_len,
+        (in_total * cost->out_per_in.load(std::memory_order_relaxed)) >>
+            InlineWriteCost::kOutPerInShift);
+    uint64_t work = std::max<uint64_t>(in_total, expected_out);
+    return work * ns_per_kb / 1024 <= kInlineWriteMaxNs;
+  }
+
   void UpdateWriteResult() {
     ctx_.GetAfterWriteOffsets(&write_result_[1], &write_result_[0]);
   }
@@ -504,7 +594,38 @@ class CompressionStream : public AsyncWrap, public ThreadPoolWork {
   // for a single write() call, until all of the input bytes have
   // been consumed.
   void DoThreadPoolWork() override {
+    uint32_t in_before, out_before, in_after, out_after;
+    ctx_.GetAfterWriteOffsets(&in_before, &out_before);
+    uint64_t start = uv_hrtime();
     ctx_.DoThreadPoolWork();
+    uint64_t elapsed = uv_hrtime() - start;
+    ctx_.GetAfterWriteOffsets(&in_after, &out_after);
+
+    uint64_t consumed = in_before - in_after;
+    uint64_t produced = out_before - out_after;
+    // Only read on the loop thread once the work is done.
+    unflushed_in_ += consumed;
+    if (write_flush_ != Z_NO_FLUSH && in_after == 0 && out_after > 0)
+      unflushed_in_ = 0;
+
+    // Streams of the same kind may be measured on several threads at once,
+    // a racing update is simply lost.
+    InlineWriteCost* cost = ctx_.inline_write_cost();
+    uint64_t work = std::max<uint64_t>({consumed, produced, 1});
+    uint64_t ns_per_kb = std::max<uint64_t>(elapsed * 1024 / work, 1);
+    uint64_t prev = cost->ns_per_kb.load(std::memory_order_relaxed);
+    // Follow a rise in cost right away, such as a block that was compressed
+    // after many cheap writes that only buffered their input, and only
+    // slowly go back to doing writes inline afterwards.
+    if (ns_per_kb < prev) ns_per_kb = (prev * 7 + ns_per_kb) / 8;
+    cost->ns_per_kb.store(ns_per_kb, std::memory_order_relaxed);
+    if (consumed > 0) {
+      uint64_t out_per_in = cost->out_per_in.load(std::memory_order_relaxed);
+      out_per_in = (out_per_in * 3 +
+                    (produced << InlineWriteCost::kOutPerInShift) / consumed) /
+                   4;
+      cost->out_per_in.store(out_per_in, std::memory_order_relaxed);
+    }
   }
 
 
@@ -574,6 +695,7 @@ class CompressionStream : public AsyncWrap, public ThreadPoolWork {
     ASSIGN_OR_RETURN_UNWRAP(&wrap, args.This());
 
     AllocScope alloc_scope(wrap);
+    wrap->unflushed_in_ = 0;
     const CompressionError err = wrap->context()->ResetStream();
     if (err.IsError())
       wrap->EmitError(err);
@@ -666,12 +788,19 @@ class CompressionStream : public AsyncWrap, public ThreadPoolWork {
     }
   }
 
+  // Writes up to this size are candidates for compressing inline.
+  static constexpr uint32_t kInlineWriteMaxBytes = 16 * 1024;
+  static constexpr uint64_t kInlineWriteMaxNs = 50 * 1000;
+
   bool init_done_ = false;
   bool write_in_progress_ = false;
   bool pending_close_ = false;
   bool closed_ = false;
   unsigned int refs_ = 0;
   uint32_t* write_result_ = nullptr;
+  uint32_t write_flush_ = Z_NO_FLUSH;
+  // Input consumed since the last completed flush.
+  uint64_t unflushed_in_ = 0;
   std::atomic<ssize_t> unreported_allocations_{0};
   size_t zlib_memory_ = 0;
 
@@ -1360,6 +1489,7 @@ CompressionError BrotliEncoderContext::Init(brotli_alloc_func alloc,
   alloc_ = alloc;
   free_ = free;
   alloc_opaque_ = opaque;
+  quality_ = BROTLI_DEFAULT_QUALITY;
   state_.reset(BrotliEncoderCreateInstance(alloc, free, opaque));
   if (!state_) {
     return CompressionError("Could not initialize Brotli instance",
@@ -1382,6 +1512,7 @@ CompressionError BrotliEncoderContext::SetParams(int key, uint32_t value) {
                             "ERR_BROTLI_PARAM_SET_FAILED",
                             -1);
   } else {
+    if (key == BROTLI_PARAM_QUALITY) quality_ = value;
     return CompressionError {};
   }
 }
@@ -1509,11 +1640,14 @@ CompressionError ZstdCompressContext::SetParameter(int key, int value) {
     return CompressionError(
         "Setting parameter failed", "ERR_ZSTD_PARAM_SET_FAILED", -1);
   }
+  if (key == ZSTD_c_compressionLevel)
+    level_ = value == 0 ? ZSTD_CLEVEL_DEFAULT : value;
   return {};
 }
 
 CompressionError ZstdCompressContext::Init(uint64_t pledged_src_size) {
   pledged_src_size_ = pledged_src_size;
+  level_ = ZSTD_CLEVEL_DEFAULT;
   cctx_.reset(ZSTD_createCCtx());
   if (!cctx_) {
     return CompressionError("Could not initialize zstd instance",
@@ -245,6 +245,10 @@ void Session::Application::SendPendingData() {
     }
   });
 
+  // Declared after update_stats so that the packets are handed to the socket
+  // before the packet tx time and the timer are updated.
+  Endpoint::SendBatchScope send_batch(&session_->endpoint());
+
   // The maximum size of packet to create.
   const size_t max_packet_size = session_->max_packet_size();
 
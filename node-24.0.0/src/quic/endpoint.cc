@@ -502,6 +502,76 @@ int Endpoint::UDP::Send(const BaseObjectPtr<Packet>& packet) {
   return err;
 }
 
+void Endpoint::UDP::Queue(const BaseObjectPtr<Packet>& packet) {
+  DCHECK(packet);
+  DCHECK(!packet->IsDispatched());
+  pending_.push_back(packet);
+}
+
+void Endpoint::UDP::Complete(const BaseObjectPtr<Packet>& packet, int status) {
+  // The packet never went through uv_udp_send, it only has to be marked as
+  // dispatched so that Done() reports it to its listener.
+  packet->ClearWeak();
+  packet->Dispatched();
+  packet->Done(status);
+}
+
+int Endpoint::UDP::Flush() {
+  static constexpr size_t kMaxBatch = 64;
+  if (pending_.empty()) return 0;
+  std::vector<BaseObjectPtr<Packet>> packets;
+  packets.swap(pending_);
+
+  // The status of each packet up to sent.
+  std::vector<int> status(packets.size(), 0);
+  size_t sent = 0;
+  int err = is_closed_or_closing() ? UV_EBADF : 0;
+  while (err == 0 && sent < packets.size()) {
+    uv_buf_t bufs[kMaxBatch];
+    uv_buf_t* buf_ptrs[kMaxBatch];
+    unsigned int nbufs[kMaxBatch];
+    sockaddr* addrs[kMaxBatch];
+    const size_t count = std::min(packets.size() - sent, kMaxBatch);
+    for (size_t i = 0; i < count; i++) {
+      const BaseObjectPtr<Packet>& packet = packets[sent + i];
+      bufs[i] = *packet;
+      buf_ptrs[i] = &bufs[i];
+      nbufs[i] = 1;
+      addrs[i] = const_cast<sockaddr*>(packet->destination().data());
+    }
+    int n = uv_udp_try_send2(&impl_->handle_,
+                             static_cast<unsigned int>(count),
+                             buf_ptrs,
+                             nbufs,
+                             addrs,
+                             0);
+    if (n == UV_EAGAIN) break;
+    if (n < 0) {
+      // Only the first packet of the batch was refused, for instance because
+      // it does not fit the path MTU or its destination is unreachable. That
+      // says nothing about the others.
+      status[sent++] = n;
+      continue;
+    }
+    sent += n;
+    // The send buffer is full, the rest has to wait for the socket to
+    // become writable again.
+    if (static_cast<size_t>(n) < count) break;
+  }
+
+  // Hand the rest to libuv before completing anything, completing a packet
+  // may end up closing the endpoint.
+  size_t i = sent;
+  for (; err == 0 && i < packets.size(); i++) {
+    // Send() fails the packet itself.
+    err = Send(packets[i]);
+  }
+  for (; i < packets.size(); i++) Complete(packets[i], err);
+  for (i = 0; i < sent; i++) Complete(packets[i], status[i]);
+
+  return err;
+}
+
 void Endpoint::UDP::MemoryInfo(MemoryTracker* tracker) const {
   if (impl_) tracker->TrackField("impl", impl_);
 }
@@ -763,6 +833,12 @@ void Endpoint::Send(const BaseObjectPtr<Packet>& packet) {
   }
   Debug(this, "Sending %s", packet->ToString());
   state_->pending_callbacks++;
+  if (send_batch_depth_ > 0) {
+    udp_.Queue(packet);
+    STAT_INCREMENT_N(Stats, bytes_sent, packet->length());
+    STAT_INCREMENT(Stats, packets_sent);
+    return;
+  }
   int err = udp_.Send(packet);
   if (err != 0) {
     Debug(this, "Sending packet failed with error %d", err);
@@ -773,6 +849,25 @@ void Endpoint::Send(const BaseObjectPtr<Packet>& packet) {
   STAT_INCREMENT(Stats, packets_sent);
 }
 
+void Endpoint::FlushSendBatch() {
+  int err = udp_.Flush();
+  if (err != 0 && !is_closed()) {
+    Debug(this, "Sending packet batch failed with error %d", err);
+    Destroy(CloseContext::SEND_FAILURE, err);
+  }
+}
+
+Endpoint::SendBatchScope::SendBatchScope(Endpoint* endpoint)
+    : endpoint(endpoint) {
+  CHECK_NOT_NULL(endpoint);
+  ++endpoint->send_batch_depth_;
+}
+
+Endpoint::SendBatchScope::~SendBatchScope() {
+  DCHECK_GE(endpoint->send_batch_depth_, 1);
+  if (--endpoint->send_batch_depth_ == 0) endpoint->FlushSendBatch();
+}
+
 void Endpoint::SendRetry(const PathDescriptor& options) {
   // Generating and sending retry packets does consume some system resources,
   // and it is possible for a malicious peer to trigger sending a large number
@@ -11,6 +11,7 @@
 #include <v8.h>
 #include <algorithm>
 #include <optional>
+#include <vector>
 #include "bindingdata.h"
 #include "packet.h"
 #include "session.h"
@@ -197,6 +198,16 @@ class Endpoint final : public AsyncWrap, public Packet::Listener {
 
   void Send(const BaseObjectPtr<Packet>& packet);
 
+  // While a SendBatchScope is active, packets passed to Send() are held back
+  // and handed to the UDP socket together when the outermost scope ends, so
+  // that a whole flight of packets costs a single sendmmsg() call.
+  struct SendBatchScope final {
+    BaseObjectPtr<Endpoint> endpoint;
+    explicit SendBatchScope(Endpoint* endpoint);
+    ~SendBatchScope();
+    DISALLOW_COPY_AND_MOVE(SendBatchScope)
+  };
+
   // Generates and sends a retry packet. This is terminal for the connection.
   // Retry packets are used to force explicit path validation by issuing a token
   // to the peer that it must thereafter include in all subsequent initial
@@ -263,6 +274,15 @@ class Endpoint final : public AsyncWrap, public Packet::Listener {
     void Close();
     int Send(const BaseObjectPtr<Packet>& packet);
 
+    // Queue() holds a packet back until Flush() sends all queued packets with
+    // as few system calls as possible. Whatever does not fit into the socket
+    // send buffer right away is queued with libuv as if it was passed to
+    // Send(). A packet the socket refuses is failed on its own. Returns the
+    // first error of handing a packet to libuv, in which case all packets that
+    // were not sent yet have been failed.
+    void Queue(const BaseObjectPtr<Packet>& packet);
+    int Flush();
+
     // Returns the local UDP socket address to which we are bound,
     // or fail with an assert if we are not bound.
     SocketAddress local_address() const;
@@ -282,7 +302,10 @@ class Endpoint final : public AsyncWrap, public Packet::Listener {
    private:
     class Impl;
 
+    static void Complete(const BaseObjectPtr<Packet>& packet, int status);
+
     BaseObjectWeakPtr<Impl> impl_;
+    std::vector<BaseObjectPtr<Packet>> pending_;
     bool is_bound_ = false;
     bool is_started_ = false;
     bool is_closed_ = false;
@@ -370,6 +393,7 @@ class Endpoint final : public AsyncWrap, public Packet::Listener {
   static void FastRef(v8::Local<v8::Object> receiver, bool on);
 
   void Receive(const uv_buf_t& buf, const SocketAddress& from);
+  void FlushSendBatch();
 
   AliasedStruct<Stats> stats_;
   AliasedStruct<State> state_;
@@ -409,6 +433,7 @@ class Endpoint final : public AsyncWrap, public Packet::Listener {
 
   CloseContext close_context_ = CloseContext::CLOSE;
   int close_status_ = 0;
+  size_t send_batch_depth_ = 0;
 
   friend class UDP;
   friend class Packet;
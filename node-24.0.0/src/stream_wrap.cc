@@ -195,6 +195,21 @@ AsyncWrap* LibuvStreamWrap::GetAsyncWrap() {
 }
 
 
+void LibuvStreamWrap::Close(Local<Value> close_callback) {
+  FlushCorkedWrites();
+  HandleWrap::Close(close_callback);
+}
+
+
+void LibuvStreamWrap::FlushCorkedWritesAtExit(void* arg) {
+  Environment* env = static_cast<Environment*>(arg);
+  for (HandleWrap* handle : *env->handle_wrap_queue()) {
+    if (handle->GetHandle()->type == UV_TCP)
+      static_cast<LibuvStreamWrap*>(handle)->FlushCorkedWrites();
+  }
+}
+
+
 bool LibuvStreamWrap::IsIPCPipe() {
   return is_named_pipe_ipc();
 }
@@ -304,7 +319,8 @@ void LibuvStreamWrap::GetWriteQueueSize(
     return;
   }
 
-  uint32_t write_queue_size = wrap->stream()->write_queue_size;
+  uint32_t write_queue_size =
+      wrap->stream()->write_queue_size + wrap->corked_bytes_;
   info.GetReturnValue().Set(write_queue_size);
 }
 
@@ -335,6 +351,8 @@ WriteWrap* LibuvStreamWrap::CreateWriteWrap(Local<Object> object) {
 
 int LibuvStreamWrap::DoShutdown(ShutdownWrap* req_wrap_) {
   LibuvShutdownWrap* req_wrap = static_cast<LibuvShutdownWrap*>(req_wrap_);
+  // uv_shutdown() waits for the pending writes, but not for staged ones.
+  FlushCorkedWrites();
   return req_wrap->Dispatch(uv_shutdown, stream(), AfterUvShutdown);
 }
 
@@ -359,6 +377,16 @@ int LibuvStreamWrap::DoTryWrite(uv_buf_t** bufs, size_t* count) {
   uv_buf_t* vbufs = *bufs;
   size_t vcount = *count;
 
+  // Once anything was written during this loop iteration, or is still
+  // pending, leave everything to DoWrite(), which stages it.
+  if (ShouldCork(nullptr)) {
+    if (!corked_writes_.empty() || cork_flush_scheduled_ ||
+        stream()->write_queue_size != 0) {
+      return 0;
+    }
+    ScheduleCorkFlush();
+  }
+
   err = uv_try_write(stream(), vbufs, vcount);
   if (err == UV_ENOSYS || err == UV_EAGAIN)
     return 0;
@@ -394,12 +422,100 @@ int LibuvStreamWrap::DoWrite(WriteWrap* req_wrap,
                              size_t count,
                              uv_stream_t* send_handle) {
   LibuvWriteWrap* w = static_cast<LibuvWriteWrap*>(req_wrap);
-  return w->Dispatch(uv_write2,
-                     stream(),
-                     bufs,
-                     count,
-                     send_handle,
-                     AfterUvWrite);
+
+  if (!ShouldCork(send_handle)) {
+    // Keep the order of the writes staged so far.
+    FlushCorkedWrites();
+    return w->Dispatch(uv_write2,
+                       stream(),
+                       bufs,
+                       count,
+                       send_handle,
+                       AfterUvWrite);
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    corked_bufs_.push_back(bufs[i]);
+    corked_bytes_ += bufs[i].len;
+  }
+  corked_writes_.push_back(
+      CorkedWrite{req_wrap, BaseObjectPtr<AsyncWrap>(w->GetAsyncWrap())});
+
+  if (corked_bytes_ >= kCorkFlushThreshold) {
+    FlushCorkedWrites();
+  } else {
+    ScheduleCorkFlush();
+  }
+  return 0;
+}
+
+
+void LibuvStreamWrap::ScheduleCorkFlush() {
+  if (cork_flush_scheduled_)
+    return;
+  cork_flush_scheduled_ = true;
+  env()->SetImmediate(
+      [self = BaseObjectPtr<LibuvStreamWrap>(this)](Environment* env) {
+        self->cork_flush_scheduled_ = false;
+        self->FlushCorkedWrites();
+      });
+}
+
+
+void LibuvStreamWrap::FlushCorkedWrites() {
+  if (corked_writes_.empty())
+    return;
+
+  CorkedBatch batch = std::move(corked_writes_);
+  std::vector<uv_buf_t> bufs = std::move(corked_bufs_);
+  corked_writes_.clear();
+  corked_bufs_.clear();
+  corked_bytes_ = 0;
+
+  if (!IsAlive() || IsClosing())
+    return FailCorkedWrites(std::move(batch), UV_ECANCELED);
+
+  // libuv copies the buffer list, the data itself is kept alive by the
+  // requests.
+  LibuvWriteWrap* leader = static_cast<LibuvWriteWrap*>(batch[0].req_wrap);
+  int err = leader->Dispatch(uv_write,
+                             stream(),
+                             bufs.data(),
+                             bufs.size(),
+                             AfterCorkedUvWrite);
+  if (err != 0)
+    return FailCorkedWrites(std::move(batch), err);
+
+  batch.erase(batch.begin());
+  corked_batches_.push_back(std::move(batch));
+}
+
+
+void LibuvStreamWrap::FailCorkedWrites(CorkedBatch&& batch, int status) {
+  env()->SetImmediate([batch = std::move(batch), status](Environment* env) {
+    HandleScope scope(env->isolate());
+    Context::Scope context_scope(env->context());
+    for (const CorkedWrite& w : batch)
+      w.req_wrap->Done(status);
+  });
+}
+
+
+void LibuvStreamWrap::AfterCorkedUvWrite(uv_write_t* req, int status) {
+  LibuvWriteWrap* req_wrap = static_cast<LibuvWriteWrap*>(
+      LibuvWriteWrap::from_req(req));
+  CHECK_NOT_NULL(req_wrap);
+  LibuvStreamWrap* wrap = static_cast<LibuvStreamWrap*>(req_wrap->stream());
+  // Writes on a stream complete in the order they were made.
+  CHECK(!wrap->corked_batches_.empty());
+  CorkedBatch followers = std::move(wrap->corked_batches_.front());
+  wrap->corked_batches_.pop_front();
+
+  HandleScope scope(req_wrap->env()->isolate());
+  Context::Scope context_scope(req_wrap->env()->context());
+  req_wrap->Done(status);
+  for (const CorkedWrite& w : followers)
+    w.req_wrap->Done(status);
 }
 
 
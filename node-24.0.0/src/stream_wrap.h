@@ -28,6 +28,9 @@
 #include "handle_wrap.h"
 #include "v8.h"
 
+#include <deque>
+#include <vector>
+
 namespace node {
 
 class Environment;
@@ -44,6 +47,13 @@ class LibuvStreamWrap : public HandleWrap, public StreamBase {
   bool IsAlive() override;
   bool IsClosing() override;
   bool IsIPCPipe() override;
+  // Hands the staged writes to libuv before the handle goes away.
+  void Close(
+      v8::Local<v8::Value> close_callback = v8::Local<v8::Value>()) override;
+
+  // Registered with AtExit() for every Environment, so that process.exit()
+  // does not drop writes which are still staged.
+  static void FlushCorkedWritesAtExit(void* arg);
 
   // JavaScript functions
   int ReadStart() override;
@@ -111,6 +121,39 @@ class LibuvStreamWrap : public HandleWrap, public StreamBase {
   static void AfterUvWrite(uv_write_t* req, int status);
   static void AfterUvShutdown(uv_shutdown_t* req, int status);
 
+  // Automatic corking of TCP writes. DoWrite() stages the buffers of a write
+  // instead of handing them to libuv, and everything staged during the
+  // current loop iteration is written with a single uv_write() from a native
+  // immediate, or as soon as kCorkFlushThreshold bytes are staged. The data
+  // stays owned by the write requests, which all complete together, in order.
+  // The first write on an idle stream is tried right away instead, so that a
+  // lone small write is not held back for a loop iteration.
+  struct CorkedWrite {
+    WriteWrap* req_wrap;
+    BaseObjectPtr<AsyncWrap> keep_alive;
+  };
+  using CorkedBatch = std::vector<CorkedWrite>;
+
+  static constexpr size_t kCorkFlushThreshold = 64 * 1024;
+
+  inline bool ShouldCork(uv_stream_t* send_handle) const {
+    return is_tcp() && send_handle == nullptr;
+  }
+  void ScheduleCorkFlush();
+  void FlushCorkedWrites();
+  // Completes the requests from a native immediate, never synchronously from
+  // within a write.
+  void FailCorkedWrites(CorkedBatch&& batch, int status);
+  static void AfterCorkedUvWrite(uv_write_t* req, int status);
+
+  std::vector<uv_buf_t> corked_bufs_;
+  CorkedBatch corked_writes_;
+  size_t corked_bytes_ = 0;
+  bool cork_flush_scheduled_ = false;
+  // Batches handed to libuv, oldest first, without their first request which
+  // is the one uv_write() was dispatched with.
+  std::deque<CorkedBatch> corked_batches_;
+
   uv_stream_t* const stream_;
 
 #ifdef _WIN32
@@ -26,6 +26,7 @@
 #include "env-inl.h"
 #include "handle_wrap.h"
 #include "node_buffer.h"
+#include "node_debug.h"
 #include "node_external_reference.h"
 #include "node_internals.h"
 #include "stream_base-inl.h"
@@ -38,6 +39,7 @@
 namespace node {
 
 using v8::Boolean;
+using v8::CFunction;
 using v8::Context;
 using v8::EscapableHandleScope;
 using v8::Function;
@@ -71,6 +73,13 @@ MaybeLocal<Object> TCPWrap::Instantiate(Environment* env,
 }
 
 
+CFunction TCPWrap::fast_read_start_(CFunction::Make(&TCPWrap::FastReadStart));
+CFunction TCPWrap::fast_read_stop_(CFunction::Make(&TCPWrap::FastReadStop));
+CFunction TCPWrap::fast_set_no_delay_(
+    CFunction::Make(&TCPWrap::FastSetNoDelay));
+CFunction TCPWrap::fast_set_keep_alive_(
+    CFunction::Make(&TCPWrap::FastSetKeepAlive));
+
 void TCPWrap::Initialize(Local<Object> target,
                          Local<Value> unused,
                          Local<Context> context,
@@ -89,6 +98,19 @@ void TCPWrap::Initialize(Local<Object> target,
 
   t->Inherit(LibuvStreamWrap::GetConstructorTemplate(env));
 
+  // Shadows the generic StreamBase methods, which can't have fast variants as
+  // e.g. a JSStream calls into JS when it starts reading.
+  SetFastProtoMethod(isolate,
+                     t,
+                     "readStart",
+                     JSMethod<&TCPWrap::ReadStartJS>,
+                     &fast_read_start_);
+  SetFastProtoMethod(isolate,
+                     t,
+                     "readStop",
+                     JSMethod<&TCPWrap::ReadStopJS>,
+                     &fast_read_stop_);
+
   SetProtoMethod(isolate, t, "open", Open);
   SetProtoMethod(isolate, t, "bind", Bind);
   SetProtoMethod(isolate, t, "listen", Listen);
@@ -103,8 +125,10 @@ void TCPWrap::Initialize(Local<Object> target,
                  t,
                  "getpeername",
                  GetSockOrPeerName<TCPWrap, uv_tcp_getpeername>);
-  SetProtoMethod(isolate, t, "setNoDelay", SetNoDelay);
-  SetProtoMethod(isolate, t, "setKeepAlive", SetKeepAlive);
+  SetFastProtoMethod(isolate, t, "setNoDelay", SetNoDelay, &fast_set_no_delay_);
+  SetFastProtoMethod(
+      isolate, t, "setKeepAlive", SetKeepAlive, &fast_set_keep_alive_);
+  SetProtoMethod(isolate, t, "setIdleTimeout", SetIdleTimeout);
   SetProtoMethod(isolate, t, "reset", Reset);
 
 #ifdef _WIN32
@@ -144,6 +168,15 @@ void TCPWrap::RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(GetSockOrPeerName<TCPWrap, uv_tcp_getpeername>);
   registry->Register(SetNoDelay);
   registry->Register(SetKeepAlive);
+  registry->Register(FastReadStart);
+  registry->Register(FastReadStop);
+  registry->Register(FastSetNoDelay);
+  registry->Register(FastSetKeepAlive);
+  registry->Register(fast_read_start_.GetTypeInfo());
+  registry->Register(fast_read_stop_.GetTypeInfo());
+  registry->Register(fast_set_no_delay_.GetTypeInfo());
+  registry->Register(fast_set_keep_alive_.GetTypeInfo());
+  registry->Register(SetIdleTimeout);
   registry->Register(Reset);
 #ifdef _WIN32
   registry->Register(SetSimultaneousAccepts);
@@ -207,6 +240,57 @@ void TCPWrap::SetKeepAlive(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(err);
 }
 
+int32_t TCPWrap::FastReadStart(Local<Value> receiver) {
+  TRACK_V8_FAST_API_CALL("tcp_wrap.readStart");
+  TCPWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, receiver, UV_EBADF);
+  if (!wrap->IsAlive()) return UV_EINVAL;
+  AsyncHooks::DefaultTriggerAsyncIdScope trigger_scope(wrap);
+  return wrap->ReadStart();
+}
+
+
+int32_t TCPWrap::FastReadStop(Local<Value> receiver) {
+  TRACK_V8_FAST_API_CALL("tcp_wrap.readStop");
+  TCPWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, receiver, UV_EBADF);
+  if (!wrap->IsAlive()) return UV_EINVAL;
+  AsyncHooks::DefaultTriggerAsyncIdScope trigger_scope(wrap);
+  return wrap->ReadStop();
+}
+
+
+int32_t TCPWrap::FastSetNoDelay(Local<Value> receiver, bool enable) {
+  TRACK_V8_FAST_API_CALL("tcp_wrap.setNoDelay");
+  TCPWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, receiver, UV_EBADF);
+  return uv_tcp_nodelay(&wrap->handle_, enable);
+}
+
+
+int32_t TCPWrap::FastSetKeepAlive(Local<Value> receiver,
+                                  bool enable,
+                                  uint32_t delay) {
+  TRACK_V8_FAST_API_CALL("tcp_wrap.setKeepAlive");
+  TCPWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, receiver, UV_EBADF);
+  return uv_tcp_keepalive(&wrap->handle_, enable, delay);
+}
+
+
+// Lets the demikernel shim time out an idle connection instead of a JS timer
+// that is re-armed on every read and write. Reads fail with UV_ETIMEDOUT once
+// it expires, 0 disables it.
+void TCPWrap::SetIdleTimeout(const FunctionCallbackInfo<Value>& args) {
+  TCPWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(
+      &wrap, args.This(), args.GetReturnValue().Set(UV_EBADF));
+  CHECK(args[0]->IsUint32());
+  unsigned int timeout = args[0].As<Uint32>()->Value();
+  int err = uv_tcp_idle_timeout(&wrap->handle_, timeout);
+  args.GetReturnValue().Set(err);
+}
+
 
 #ifdef _WIN32
 void TCPWrap::SetSimultaneousAccepts(const FunctionCallbackInfo<Value>& args) {
@@ -74,6 +74,22 @@ class TCPWrap : public ConnectionWrap<TCPWrap, uv_tcp_t> {
   static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void SetNoDelay(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void SetKeepAlive(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void SetIdleTimeout(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  // Fast API variants of the methods called for every connection, none of
+  // them allocate on the JS heap or call into JS. The write methods are left
+  // out, creating a WriteWrap runs the async hooks.
+  static int32_t FastReadStart(v8::Local<v8::Value> receiver);
+  static int32_t FastReadStop(v8::Local<v8::Value> receiver);
+  static int32_t FastSetNoDelay(v8::Local<v8::Value> receiver, bool enable);
+  static int32_t FastSetKeepAlive(v8::Local<v8::Value> receiver,
+                                  bool enable,
+                                  uint32_t delay);
+
+  static v8::CFunction fast_read_start_;
+  static v8::CFunction fast_read_stop_;
+  static v8::CFunction fast_set_no_delay_;
+  static v8::CFunction fast_set_keep_alive_;
   static void Bind(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Bind6(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Listen(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -938,6 +938,13 @@ void SetProtoMethod(v8::Isolate* isolate,
                     v8::Local<v8::FunctionTemplate> that,
                     const std::string_view name,
                     v8::FunctionCallback callback);
+// Like SetProtoMethod, the receiver of the fast call is checked against the
+// signature of `that` before `c_function` is entered.
+void SetFastProtoMethod(v8::Isolate* isolate,
+                        v8::Local<v8::FunctionTemplate> that,
+                        const std::string_view name,
+                        v8::FunctionCallback slow_callback,
+                        const v8::CFunction* c_function);
 
 void SetInstanceMethod(v8::Isolate* isolate,
                        v8::Local<v8::FunctionTemplate> that,
@@ -0,0 +1,145 @@
+#include "node_buffer_search.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#ifdef NODE_BUFFER_SIMD_SEARCH
+
+using node::Buffer::SearchAVX2;
+using node::Buffer::SearchSSE2;
+
+namespace {
+
+template <typename Char>
+using SearchFn = size_t (*)(const Char*, size_t, const Char*, size_t, size_t);
+
+template <typename Char>
+size_t NaiveSearch(const Char* haystack,
+                   size_t haystack_length,
+                   const Char* needle,
+                   size_t needle_length,
+                   size_t start) {
+  for (size_t i = start; i + needle_length <= haystack_length; i++) {
+    if (memcmp(haystack + i, needle, needle_length * sizeof(Char)) == 0)
+      return i;
+  }
+  return haystack_length;
+}
+
+// Searches a haystack that is full of positions where the first and the last
+// character of the needle match but the rest doesn't, with the needle itself
+// at `pos`. The haystack starts `misalign` bytes into its buffer.
+template <typename Char>
+void CheckSearch(SearchFn<Char> search,
+                 Char base,
+                 size_t haystack_length,
+                 size_t needle_length,
+                 size_t pos,
+                 size_t start,
+                 size_t misalign = 0) {
+  std::vector<Char> needle(needle_length);
+  for (size_t i = 0; i < needle_length; i++)
+    needle[i] = static_cast<Char>(base + i % 7);
+  const Char last = needle[needle_length - 1];
+
+  // Differs from the first character only in its high byte for two-byte
+  // characters.
+  const Char other = static_cast<Char>(sizeof(Char) == 1 ? 'z' : base + 256);
+  // A two character needle can't be matched at both ends only, its first
+  // character is never followed by its last one then.
+  const size_t period = needle_length == 2 ? 4 : needle_length;
+  std::vector<Char> chars(haystack_length);
+  for (size_t i = 0; i < haystack_length; i++) {
+    const size_t j = i % period;
+    chars[i] = j == 0 ? needle[0] : j == period - 1 ? last : other;
+  }
+  if (pos < haystack_length)
+    memcpy(&chars[pos], needle.data(), needle_length * sizeof(Char));
+
+  const size_t bytes = haystack_length * sizeof(Char);
+  std::vector<char> storage(bytes + misalign);
+  memcpy(storage.data() + misalign, chars.data(), bytes);
+  const Char* haystack =
+      reinterpret_cast<const Char*>(storage.data() + misalign);
+
+  const size_t expected = NaiveSearch(
+      haystack, haystack_length, needle.data(), needle_length, start);
+  if (pos < haystack_length && start <= pos) {
+    ASSERT_EQ(expected, pos);
+  }
+  EXPECT_EQ(
+      search(haystack, haystack_length, needle.data(), needle_length, start),
+      expected)
+      << "haystack_length " << haystack_length << ", needle_length "
+      << needle_length << ", pos " << pos << ", start " << start
+      << ", misalign " << misalign;
+}
+
+// `step` is the number of characters the kernel compares at once.
+template <typename Char>
+void CheckKernel(SearchFn<Char> search,
+                 size_t step,
+                 Char base,
+                 size_t misalign = 0) {
+  for (size_t needle_length : {2, 32, 33}) {
+    const size_t len = 4 * step + needle_length;
+    // A match at the start, within the first block, spanning the boundary
+    // between the first two blocks, and at the start of the second one.
+    for (size_t pos : {size_t{0}, step / 2, step - 1, step}) {
+      CheckSearch(search, base, len, needle_length, pos, 0, misalign);
+      // Starting past the match finds nothing, starting at an offset that
+      // isn't a multiple of the step still finds a later match.
+      CheckSearch(search, base, len, needle_length, pos, pos + 1, misalign);
+      CheckSearch(search, base, len, needle_length, pos + 3, 3, misalign);
+    }
+    // No match at all.
+    CheckSearch(search, base, len, needle_length, len, 0, misalign);
+
+    // The vector loop stops two steps in, so a match at the very end is only
+    // found by the scalar tail.
+    const size_t tail_len = 2 * step + needle_length - 1 + step / 2;
+    CheckSearch(search,
+                base,
+                tail_len,
+                needle_length,
+                tail_len - needle_length,
+                0,
+                misalign);
+    CheckSearch(search,
+                base,
+                tail_len,
+                needle_length,
+                tail_len - needle_length,
+                step + 1,
+                misalign);
+  }
+}
+
+}  // namespace
+
+TEST(BufferSearchTest, SSE2OneByte) {
+  CheckKernel<uint8_t>(SearchSSE2<uint8_t>, 16, 'a');
+}
+
+TEST(BufferSearchTest, SSE2TwoByte) {
+  CheckKernel<uint16_t>(SearchSSE2<uint16_t>, 8, 0x3041);
+  // UCS-2 strings of a Buffer can start at an odd byte offset.
+  CheckKernel<uint16_t>(SearchSSE2<uint16_t>, 8, 0x3041, 1);
+}
+
+TEST(BufferSearchTest, AVX2OneByte) {
+  if (!__builtin_cpu_supports("avx2")) GTEST_SKIP() << "no AVX2";
+  CheckKernel<uint8_t>(SearchAVX2<uint8_t>, 32, 'a');
+}
+
+TEST(BufferSearchTest, AVX2TwoByte) {
+  if (!__builtin_cpu_supports("avx2")) GTEST_SKIP() << "no AVX2";
+  CheckKernel<uint16_t>(SearchAVX2<uint16_t>, 16, 0x3041);
+  CheckKernel<uint16_t>(SearchAVX2<uint16_t>, 16, 0x3041, 1);
+}
+
+#endif  // NODE_BUFFER_SIMD_SEARCH
@@ -7,6 +7,8 @@
 #include "openssl/err.h"
 #include "gtest/gtest.h"
 
+#include <thread>
+
 /*
  * This test verifies that a call to NewRootCertDir with the build time
  * configuration option --openssl-system-ca-path set to an missing file, will
@@ -21,3 +23,128 @@ TEST(NodeCrypto, NewRootCertStore) {
                                       "any errors on the OpenSSL error stack\n";
   X509_STORE_free(store);
 }
+
+#ifdef NODE_ASYNC_PRIVATE_KEY
+namespace {
+
+using node::crypto::PrivateKeyOp;
+
+constexpr unsigned char kMessage[] = "async private key";
+
+struct SignJob {
+  EVP_PKEY* key;
+  unsigned char sig[512];
+  size_t siglen;
+};
+
+int Sign(SignJob* job) {
+  ncrypto::EVPMDCtxPointer ctx(EVP_MD_CTX_new());
+  job->siglen = sizeof(job->sig);
+  return EVP_DigestSignInit(
+             ctx.get(), nullptr, EVP_sha256(), nullptr, job->key) == 1 &&
+         EVP_DigestSign(ctx.get(), job->sig, &job->siglen,
+                        kMessage, sizeof(kMessage)) == 1;
+}
+
+int SignInJob(void* arg) {
+  return Sign(*static_cast<SignJob**>(arg));
+}
+
+bool Verify(EVP_PKEY* key, const SignJob& job) {
+  ncrypto::EVPMDCtxPointer ctx(EVP_MD_CTX_new());
+  return EVP_DigestVerifyInit(
+             ctx.get(), nullptr, EVP_sha256(), nullptr, key) == 1 &&
+         EVP_DigestVerify(ctx.get(), job.sig, job.siglen,
+                          kMessage, sizeof(kMessage)) == 1;
+}
+
+// Signs with the async copy of key the way a handshake does: the ASYNC job
+// pauses, the operation runs on another thread and the job is resumed.
+void TestAsyncPrivateKey(EVP_PKEY* key) {
+  ncrypto::EVPKeyPointer async_key = PrivateKeyOp::NewAsyncPrivateKey(key);
+  ASSERT_TRUE(async_key);
+  SignJob job{async_key.get()};
+  SignJob* arg = &job;
+
+  // Outside of a job the operation runs right away.
+  ASSERT_TRUE(Sign(&job));
+  ASSERT_EQ(PrivateKeyOp::TakePending(), nullptr);
+  ASSERT_TRUE(Verify(key, job));
+
+  ASYNC_WAIT_CTX* wait_ctx = ASYNC_WAIT_CTX_new();
+  ASSERT_NE(wait_ctx, nullptr);
+  ASYNC_JOB* async_job = nullptr;
+  int ret = -1;
+  ASSERT_EQ(ASYNC_start_job(
+                &async_job, wait_ctx, &ret, SignInJob, &arg, sizeof(arg)),
+            ASYNC_PAUSE);
+  PrivateKeyOp* op = PrivateKeyOp::TakePending();
+  ASSERT_NE(op, nullptr);
+  std::thread([op]() { op->DoWork(); }).join();
+  ASSERT_EQ(ASYNC_start_job(
+                &async_job, wait_ctx, &ret, SignInJob, &arg, sizeof(arg)),
+            ASYNC_FINISH);
+  EXPECT_EQ(ret, 1);
+  EXPECT_TRUE(Verify(key, job));
+
+  // A canceled operation, as for a destroyed TLSWrap, fails the handshake.
+  ASSERT_EQ(ASYNC_start_job(
+                &async_job, wait_ctx, &ret, SignInJob, &arg, sizeof(arg)),
+            ASYNC_PAUSE);
+  op = PrivateKeyOp::TakePending();
+  ASSERT_NE(op, nullptr);
+  op->DoWork();
+  op->Cancel();
+  ASSERT_EQ(ASYNC_start_job(
+                &async_job, wait_ctx, &ret, SignInJob, &arg, sizeof(arg)),
+            ASYNC_FINISH);
+  EXPECT_EQ(ret, 0);
+
+  ASYNC_WAIT_CTX_free(wait_ctx);
+  ERR_clear_error();
+}
+
+}  // namespace
+
+TEST(NodeCrypto, AsyncPrivateKeyRsa) {
+  ncrypto::EVPKeyPointer key(
+      EVP_PKEY_Q_keygen(nullptr, nullptr, "RSA", static_cast<size_t>(2048)));
+  ASSERT_TRUE(key);
+  TestAsyncPrivateKey(key.get());
+}
+
+TEST(NodeCrypto, AsyncPrivateKeyEc) {
+  ncrypto::EVPKeyPointer key(
+      EVP_PKEY_Q_keygen(nullptr, nullptr, "EC", "P-256"));
+  ASSERT_TRUE(key);
+  TestAsyncPrivateKey(key.get());
+}
+
+TEST(NodeCrypto, AsyncPrivateKeyUnsupportedType) {
+  ncrypto::EVPKeyPointer key(EVP_PKEY_Q_keygen(nullptr, nullptr, "ED25519"));
+  ASSERT_TRUE(key);
+  EXPECT_FALSE(PrivateKeyOp::NewAsyncPrivateKey(key.get()));
+}
+#endif  // NODE_ASYNC_PRIVATE_KEY
+
+// Sessions only resume on SecureContexts of the namespace they were added
+// with.
+TEST(NodeCrypto, SharedSessionCacheNamespaces) {
+  using node::crypto::SharedSessionCache;
+  static constexpr unsigned char kId[] = "shared session cache id";
+
+  SSL_SESSION* sess = SSL_SESSION_new();
+  ASSERT_NE(sess, nullptr);
+  ASSERT_EQ(SSL_SESSION_set1_id(sess, kId, sizeof(kId)), 1);
+  SSL_SESSION_set_time(sess, time(nullptr));
+  SSL_SESSION_set_timeout(sess, 300);
+
+  SharedSessionCache* cache = SharedSessionCache::Get();
+  cache->Add("c1", sess);
+  EXPECT_TRUE(cache->Find("c1", kId, sizeof(kId)));
+  EXPECT_FALSE(cache->Find("c2", kId, sizeof(kId)));
+  // A namespace does not run into the id.
+  EXPECT_FALSE(cache->Find("c", kId, sizeof(kId)));
+  EXPECT_FALSE(cache->Find("", kId, sizeof(kId)));
+  SSL_SESSION_free(sess);
+}
@@ -0,0 +1,79 @@
+#include "gtest/gtest.h"
+#include "node_test_fixture.h"
+
+using v8::Context;
+using v8::Local;
+using v8::String;
+using v8::Value;
+
+class NodeFileTest : public EnvironmentTestFixture {};
+
+#if !defined(_WIN32) && !defined(V8_ENABLE_SANDBOX)
+// readFileMapped() only maps regular files that nobody may write to, and
+// leaves every other file to the caller.
+TEST_F(NodeFileTest, ReadFileMapped) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+
+  SetProcessExitHandler(*env, [&](node::Environment* env_, int exit_code) {
+    EXPECT_EQ(exit_code, 0);
+    node::Stop(*env);
+  });
+
+  node::LoadEnvironment(
+      *env,
+      "const assert = require('assert');\n"
+      "const fs = require('fs');\n"
+      "const os = require('os');\n"
+      "const path = require('path');\n"
+      "const { readFileMapped } = process.binding('fs');\n"
+      "const { O_RDONLY } = fs.constants;\n"
+      "globalThis.fileChecks = 0;\n"
+      "const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'mapped-'));\n"
+      "try {\n"
+      "  const data = Buffer.alloc(64 * 1024 + 3, 'mapped file ');\n"
+      "  const readOnly = path.join(dir, 'read-only');\n"
+      "  fs.writeFileSync(readOnly, data);\n"
+      "  fs.chmodSync(readOnly, 0o444);\n"
+      "  assert.deepStrictEqual(readFileMapped(readOnly, O_RDONLY, 0), data);\n"
+      "  assert.strictEqual(\n"
+      "      readFileMapped(readOnly, O_RDONLY, data.length + 1), undefined);\n"
+      "  globalThis.fileChecks++;\n"
+      "\n"
+      "  const empty = path.join(dir, 'empty');\n"
+      "  fs.writeFileSync(empty, '');\n"
+      "  fs.chmodSync(empty, 0o444);\n"
+      "  assert.strictEqual(readFileMapped(empty, O_RDONLY, 0), undefined);\n"
+      "  globalThis.fileChecks++;\n"
+      "\n"
+      "  // Whoever may write to the file could also truncate it.\n"
+      "  for (const mode of [0o644, 0o464, 0o446]) {\n"
+      "    const writable = path.join(dir, `writable-${mode}`);\n"
+      "    fs.writeFileSync(writable, data);\n"
+      "    fs.chmodSync(writable, mode);\n"
+      "    assert.strictEqual(readFileMapped(writable, O_RDONLY, 0),\n"
+      "                       undefined);\n"
+      "  }\n"
+      "  globalThis.fileChecks++;\n"
+      "\n"
+      "  assert.strictEqual(readFileMapped(dir, O_RDONLY, 0), undefined);\n"
+      "  assert.throws(() => readFileMapped(path.join(dir, 'missing'),\n"
+      "                                    O_RDONLY, 0),\n"
+      "                { code: 'ENOENT' });\n"
+      "  globalThis.fileChecks++;\n"
+      "} finally {\n"
+      "  fs.rmSync(dir, { recursive: true });\n"
+      "}\n");
+
+  EXPECT_EQ(node::SpinEventLoop(*env).FromJust(), 0);
+
+  Local<Context> context = isolate_->GetCurrentContext();
+  Local<Value> checks =
+      context->Global()
+          ->Get(context,
+                String::NewFromUtf8Literal(isolate_, "fileChecks"))
+          .ToLocalChecked();
+  EXPECT_EQ(checks->Int32Value(context).FromJust(), 4);
+}
+#endif  // !defined(_WIN32) && !defined(V8_ENABLE_SANDBOX)
@@ -0,0 +1,96 @@
+#include "node_messaging.h"
+#include "gtest/gtest.h"
+#include "util-inl.h"
+#include "uv.h"
+
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using node::MallocedBuffer;
+using node::worker::IncomingMessageQueue;
+using node::worker::Message;
+
+static std::shared_ptr<Message> DataMessage() {
+  return std::make_shared<Message>(MallocedBuffer<char>(1));
+}
+
+TEST(IncomingMessageQueue, Fifo) {
+  IncomingMessageQueue queue;
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(queue.Pop(), nullptr);
+
+  std::vector<std::shared_ptr<Message>> messages;
+  for (int i = 0; i < 3; i++) {
+    messages.push_back(DataMessage());
+    queue.Push(messages.back());
+  }
+  messages.push_back(std::make_shared<Message>());
+  queue.Push(messages.back());
+  EXPECT_EQ(queue.size(), 4u);
+
+  for (const auto& message : messages) {
+    EXPECT_EQ(queue.Peek(), message.get());
+    EXPECT_EQ(queue.Pop(), message);
+  }
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(queue.size(), 0u);
+}
+
+TEST(IncomingMessageQueue, DestroyNonEmpty) {
+  auto message = DataMessage();
+  {
+    IncomingMessageQueue queue;
+    queue.Push(message);
+    queue.Push(DataMessage());
+  }
+  EXPECT_EQ(message.use_count(), 1);
+}
+
+static constexpr int kProducers = 4;
+static constexpr int kPerProducer = 10000;
+
+struct ProducerArgs {
+  IncomingMessageQueue* queue;
+  std::vector<std::shared_ptr<Message>> messages;
+};
+
+TEST(IncomingMessageQueue, MultipleProducers) {
+  IncomingMessageQueue queue;
+  ProducerArgs args[kProducers];
+  // Which producer pushed a message, and in which position.
+  std::unordered_map<Message*, std::pair<int, int>> origin;
+  for (int p = 0; p < kProducers; p++) {
+    args[p].queue = &queue;
+    for (int i = 0; i < kPerProducer; i++) {
+      args[p].messages.push_back(DataMessage());
+      origin[args[p].messages.back().get()] = {p, i};
+    }
+  }
+
+  uv_thread_t threads[kProducers];
+  for (int p = 0; p < kProducers; p++) {
+    ASSERT_EQ(0, uv_thread_create(&threads[p], [](void* arg) {
+      auto* args = static_cast<ProducerArgs*>(arg);
+      for (auto& message : args->messages)
+        args->queue->Push(std::move(message));
+    }, &args[p]));
+  }
+
+  // Messages of the same producer arrive in order.
+  int next[kProducers] = {};
+  int received = 0;
+  while (received < kProducers * kPerProducer) {
+    std::shared_ptr<Message> message = queue.Pop();
+    if (!message) continue;
+    auto [p, i] = origin.at(message.get());
+    EXPECT_EQ(next[p], i);
+    next[p] = i + 1;
+    received++;
+  }
+
+  for (int p = 0; p < kProducers; p++)
+    uv_thread_join(&threads[p]);
+  EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+#include "node_test_fixture.h"
+
+using v8::Context;
+using v8::Local;
+using v8::String;
+using v8::Value;
+
+class NodeSqliteTest : public EnvironmentTestFixture {};
+
+// Preparing the same SQL again hits the cache right away, without waiting
+// for the earlier StatementSync to be collected. Statements sharing a cached
+// sqlite3_stmt can still interleave their iterations, and schema changes
+// neither wipe the cache nor leave it stale.
+TEST_F(NodeSqliteTest, StatementCacheSharing) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+
+  SetProcessExitHandler(*env, [&](node::Environment* env_, int exit_code) {
+    EXPECT_EQ(exit_code, 0);
+    node::Stop(*env);
+  });
+
+  node::LoadEnvironment(
+      *env,
+      "const assert = require('assert');\n"
+      "const { DatabaseSync } = require('node:sqlite');\n"
+      "globalThis.sqliteChecks = 0;\n"
+      "const db = new DatabaseSync(':memory:', { statementCacheSize: 4 });\n"
+      "const sql = 'SELECT v FROM t WHERE k >= ? ORDER BY k';\n"
+      "db.exec('CREATE TABLE t (k INTEGER, v TEXT)');\n"
+      "const insert = db.prepare('INSERT INTO t VALUES (?, ?)');\n"
+      "for (let i = 0; i < 4; i++) insert.run(i, `v${i}`);\n"
+      "\n"
+      "for (let i = 0; i < 5; i++) {\n"
+      "  assert.strictEqual(db.prepare(sql).all(0).length, 4);\n"
+      "}\n"
+      "let stats = db.statementCacheStats();\n"
+      "assert.strictEqual(stats.hits, 4);\n"
+      "assert.strictEqual(stats.misses, 2);\n"
+      "assert.strictEqual(stats.size, 2);\n"
+      "globalThis.sqliteChecks++;\n"
+      "\n"
+      "// The second iteration moves to a private copy of the statement.\n"
+      "const a = db.prepare(sql);\n"
+      "const b = db.prepare(sql);\n"
+      "const ia = a.iterate(0);\n"
+      "const ib = b.iterate(2);\n"
+      "assert.strictEqual(ia.next().value.v, 'v0');\n"
+      "assert.strictEqual(ib.next().value.v, 'v2');\n"
+      "assert.strictEqual(b.get(3).v, 'v3');\n"
+      "assert.strictEqual(ia.next().value.v, 'v1');\n"
+      "assert.strictEqual(ib.next().done, true);\n"
+      "assert.strictEqual(ia.next().value.v, 'v2');\n"
+      "assert.strictEqual(ia.next().value.v, 'v3');\n"
+      "assert.strictEqual(ia.next().done, true);\n"
+      "assert.strictEqual(ia.next().done, true);\n"
+      "globalThis.sqliteChecks++;\n"
+      "\n"
+      "// Any other call on the same StatementSync ends its iteration.\n"
+      "const c = db.prepare(sql);\n"
+      "const ic = c.iterate(0);\n"
+      "assert.strictEqual(ic.next().value.v, 'v0');\n"
+      "assert.strictEqual(c.get(1).v, 'v1');\n"
+      "assert.strictEqual(ic.next().done, true);\n"
+      "globalThis.sqliteChecks++;\n"
+      "\n"
+      "// Preparing DDL does not drop the cache, running it does not leave\n"
+      "// cached statements stale.\n"
+      "db.prepare('DROP TABLE t');\n"
+      "const star = 'SELECT * FROM t WHERE k = ?';\n"
+      "assert.deepStrictEqual({ ...db.prepare(star).get(0) },\n"
+      "                       { k: 0, v: 'v0' });\n"
+      "db.exec('ALTER TABLE t ADD COLUMN w INTEGER DEFAULT 7');\n"
+      "assert.strictEqual(db.prepare(sql).all(0).length, 4);\n"
+      "assert.deepStrictEqual({ ...db.prepare(star).get(1) },\n"
+      "                       { k: 1, v: 'v1', w: 7 });\n"
+      "stats = db.statementCacheStats();\n"
+      "assert.strictEqual(stats.hits, 9);\n"
+      "assert.strictEqual(stats.misses, 4);\n"
+      "assert.strictEqual(stats.size, 4);\n"
+      "assert.strictEqual(stats.evictions, 0);\n"
+      "globalThis.sqliteChecks++;\n");
+
+  EXPECT_EQ(node::SpinEventLoop(*env).FromJust(), 0);
+
+  Local<Context> context = isolate_->GetCurrentContext();
+  Local<Value> checks =
+      context->Global()
+          ->Get(context,
+                String::NewFromUtf8Literal(isolate_, "sqliteChecks"))
+          .ToLocalChecked();
+  EXPECT_EQ(checks->Int32Value(context).FromJust(), 4);
+}
@@ -0,0 +1,143 @@
+#include "gtest/gtest.h"
+#include "node_options.h"
+#include "node_test_fixture.h"
+#include "node_worker.h"
+
+using node::worker::GetWorkerIsolatePoolStats;
+using node::worker::WorkerIsolatePoolStats;
+using v8::Context;
+using v8::Local;
+using v8::String;
+using v8::Value;
+
+class WorkerIsolatePoolTest : public EnvironmentTestFixture {
+ protected:
+  void TearDown() override {
+    SetPoolSize(0);
+    EnvironmentTestFixture::TearDown();
+  }
+
+  static void SetPoolSize(int64_t size) {
+    node::Mutex::ScopedLock lock(node::per_process::cli_options_mutex);
+    node::per_process::cli_options->worker_isolate_pool_size = size;
+  }
+
+  static WorkerIsolatePoolStats Stats() {
+    WorkerIsolatePoolStats stats{};
+    EXPECT_TRUE(GetWorkerIsolatePoolStats(&stats));
+    return stats;
+  }
+
+  // Runs the event loop until `done` returns true, or gives up after about
+  // ten seconds.
+  template <typename Fn>
+  static bool WaitFor(Fn done) {
+    for (int i = 0; i < 10000; i++) {
+      if (done()) return true;
+      uv_run(&current_loop, UV_RUN_NOWAIT);
+      uv_sleep(1);
+    }
+    return false;
+  }
+
+  void Run(const char* source) {
+    Local<Context> context = isolate_->GetCurrentContext();
+    v8::Script::Compile(context,
+                        String::NewFromUtf8(isolate_, source).ToLocalChecked())
+        .ToLocalChecked()
+        ->Run(context)
+        .ToLocalChecked();
+  }
+
+  int Exited() {
+    Local<Context> context = isolate_->GetCurrentContext();
+    Local<Value> exited =
+        context->Global()
+            ->Get(context, String::NewFromUtf8Literal(isolate_, "exited"))
+            .ToLocalChecked();
+    return exited->Int32Value(context).FromJust();
+  }
+
+  static constexpr const char* kScript =
+      "const assert = require('assert');\n"
+      "const { Worker } = require('worker_threads');\n"
+      "globalThis.exited = 0;\n"
+      "globalThis.startWorker = (resourceLimits) => {\n"
+      "  const worker = new Worker('', { eval: true, resourceLimits });\n"
+      "  worker.on('exit', (code) => {\n"
+      "    assert.strictEqual(code, 0);\n"
+      "    globalThis.exited++;\n"
+      "  });\n"
+      "};\n";
+};
+
+// The first Worker creates its own isolate and starts the pool, the next one
+// takes the pooled isolate, which is then replaced.
+TEST_F(WorkerIsolatePoolTest, HandsOutAndRefills) {
+  SetPoolSize(1);
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+
+  SetProcessExitHandler(*env, [&](node::Environment* env_, int exit_code) {
+    EXPECT_EQ(exit_code, 0);
+    node::Stop(*env);
+  });
+
+  node::LoadEnvironment(*env, kScript);
+  Run("startWorker()");
+  ASSERT_TRUE(WaitFor([] { return Stats().ready == 1; }));
+  EXPECT_EQ(Stats().taken, 0u);
+
+  Run("startWorker()");
+  EXPECT_EQ(Stats().taken, 1u);
+  ASSERT_TRUE(WaitFor([] { return Stats().ready == 1; }));
+  EXPECT_EQ(Stats().taken, 1u);
+
+  EXPECT_EQ(node::SpinEventLoop(*env).FromJust(), 0);
+  EXPECT_EQ(Exited(), 2);
+}
+
+// A Worker with heap limits of its own can't use the pooled isolate, which
+// was created with the default ones.
+TEST_F(WorkerIsolatePoolTest, ResourceLimitsBypassPool) {
+  SetPoolSize(1);
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+
+  SetProcessExitHandler(*env, [&](node::Environment* env_, int exit_code) {
+    EXPECT_EQ(exit_code, 0);
+    node::Stop(*env);
+  });
+
+  node::LoadEnvironment(*env, kScript);
+  Run("startWorker()");
+  ASSERT_TRUE(WaitFor([] { return Stats().ready == 1; }));
+
+  Run("startWorker({ maxOldGenerationSizeMb: 64 })");
+  WorkerIsolatePoolStats stats = Stats();
+  EXPECT_EQ(stats.taken, 0u);
+  EXPECT_EQ(stats.ready, 1u);
+
+  EXPECT_EQ(node::SpinEventLoop(*env).FromJust(), 0);
+  EXPECT_EQ(Exited(), 2);
+}
+
+// Freeing the Environment stops the pool while its thread is still creating
+// an isolate, and waits for it.
+TEST_F(WorkerIsolatePoolTest, ShutdownDuringRefill) {
+  SetPoolSize(4);
+  {
+    const v8::HandleScope handle_scope(isolate_);
+    const Argv argv;
+    Env env{handle_scope, argv};
+
+    node::LoadEnvironment(*env, kScript);
+    Run("startWorker()");
+    ASSERT_TRUE(WaitFor([] { return Stats().refilling; }));
+  }
+
+  WorkerIsolatePoolStats stats;
+  EXPECT_FALSE(GetWorkerIsolatePoolStats(&stats));
+}
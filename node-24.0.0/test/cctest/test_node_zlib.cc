@@ -0,0 +1,190 @@
+#include "gtest/gtest.h"
+#include "node_test_fixture.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <vector>
+
+using v8::Context;
+using v8::Local;
+using v8::String;
+using v8::Value;
+
+class NodeZlibTest : public EnvironmentTestFixture {};
+
+// Small writes are compressed on the loop thread once earlier writes with the
+// same algorithm and level were cheap. Checks that such writes still complete asynchronously and
+// in order, report errors, and that closing a stream with an inline write
+// pending is safe.
+TEST_F(NodeZlibTest, InlineWrites) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+
+  SetProcessExitHandler(*env, [&](node::Environment* env_, int exit_code) {
+    EXPECT_EQ(exit_code, 0);
+    node::Stop(*env);
+  });
+
+  node::LoadEnvironment(
+      *env,
+      "const assert = require('assert');\n"
+      "const zlib = require('zlib');\n"
+      "globalThis.zlibChecks = 0;\n"
+      "const input = Buffer.alloc(64 * 1024, 'inline zlib writes ');\n"
+      "function roundTrip(stream, decompress) {\n"
+      "  const chunks = [];\n"
+      "  let written = 0;\n"
+      "  let done = 0;\n"
+      "  stream.on('data', (chunk) => chunks.push(chunk));\n"
+      "  stream.on('end', () => {\n"
+      "    assert.strictEqual(done, written);\n"
+      "    assert.deepStrictEqual(decompress(Buffer.concat(chunks)), input);\n"
+      "    globalThis.zlibChecks++;\n"
+      "  });\n"
+      "  for (let i = 0; i < input.length; i += 512) {\n"
+      "    let sync = true;\n"
+      "    const index = written++;\n"
+      "    stream.write(input.subarray(i, i + 512), () => {\n"
+      "      assert(!sync);\n"
+      "      assert.strictEqual(index, done++);\n"
+      "    });\n"
+      "    sync = false;\n"
+      "  }\n"
+      "  stream.end();\n"
+      "}\n"
+      "roundTrip(zlib.createDeflate(), zlib.inflateSync);\n"
+      "roundTrip(zlib.createGzip({ level: 9 }), zlib.gunzipSync);\n"
+      "roundTrip(zlib.createBrotliCompress(), zlib.brotliDecompressSync);\n"
+      "roundTrip(zlib.createBrotliCompress({\n"
+      "  params: { [zlib.constants.BROTLI_PARAM_QUALITY]: 1 },\n"
+      "}), zlib.brotliDecompressSync);\n"
+      "\n"
+      "// The error is found by a write that follows cheap, valid ones.\n"
+      "const bad = zlib.deflateSync(input);\n"
+      "bad.fill(0xff, 64);\n"
+      "const inflate = zlib.createInflate();\n"
+      "inflate.on('error', (err) => {\n"
+      "  assert.strictEqual(err.code, 'Z_DATA_ERROR');\n"
+      "  globalThis.zlibChecks++;\n"
+      "});\n"
+      "inflate.resume();\n"
+      "for (let i = 0; i < bad.length; i += 16)\n"
+      "  inflate.write(bad.subarray(i, i + 16));\n"
+      "\n"
+      "// Close with a write in progress, once the stream was measured.\n"
+      "const deflate = zlib.createDeflate();\n"
+      "deflate.write(input.subarray(0, 512), () => {\n"
+      "  deflate.write(input.subarray(512, 1024));\n"
+      "  deflate.close(() => globalThis.zlibChecks++);\n"
+      "});\n");
+
+  EXPECT_EQ(node::SpinEventLoop(*env).FromJust(), 0);
+
+  Local<Context> context = isolate_->GetCurrentContext();
+  Local<Value> checks =
+      context->Global()
+          ->Get(context,
+                String::NewFromUtf8Literal(isolate_, "zlibChecks"))
+          .ToLocalChecked();
+  EXPECT_EQ(checks->Int32Value(context).FromJust(), 6);
+}
+
+// Keeps every threadpool thread busy until Release() is called.
+class ThreadpoolBlocker {
+ public:
+  explicit ThreadpoolBlocker(uv_loop_t* loop) {
+    const char* size = getenv("UV_THREADPOOL_SIZE");
+    threads_ = size != nullptr ? std::clamp(atoi(size), 1, 1024) : 4;
+    CHECK_EQ(0, uv_sem_init(&release_, 0));
+    reqs_.resize(threads_);
+    for (uv_work_t& req : reqs_) {
+      req.data = this;
+      CHECK_EQ(0,
+               uv_queue_work(
+                   loop,
+                   &req,
+                   [](uv_work_t* req) {
+                     auto* self = static_cast<ThreadpoolBlocker*>(req->data);
+                     self->started_++;
+                     uv_sem_wait(&self->release_);
+                   },
+                   [](uv_work_t* req, int status) {}));
+    }
+    while (started_ < threads_) uv_sleep(1);
+  }
+
+  ~ThreadpoolBlocker() { uv_sem_destroy(&release_); }
+
+  void Release() {
+    for (int i = 0; i < threads_; i++) uv_sem_post(&release_);
+  }
+
+ private:
+  int threads_;
+  std::atomic<int> started_{0};
+  uv_sem_t release_;
+  std::vector<uv_work_t> reqs_;
+};
+
+// A fresh stream makes use of the cost measured by earlier streams with the
+// same algorithm and level, so a small one-shot compression, whose only write
+// also finishes the stream, does not need the threadpool.
+TEST_F(NodeZlibTest, OneShotInline) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+
+  SetProcessExitHandler(*env, [&](node::Environment* env_, int exit_code) {
+    EXPECT_EQ(exit_code, 0);
+    node::Stop(*env);
+  });
+
+  // Checks whether the compression finished while the threadpool was busy.
+  struct TimerState {
+    ThreadpoolBlocker* blocker;
+    v8::Isolate* isolate;
+    bool inline_done;
+  };
+  ThreadpoolBlocker blocker(&current_loop);
+  TimerState state{&blocker, isolate_, false};
+  uv_timer_t timer;
+  timer.data = &state;
+  CHECK_EQ(0, uv_timer_init(&current_loop, &timer));
+  CHECK_EQ(0,
+           uv_timer_start(
+               &timer,
+               [](uv_timer_t* timer) {
+                 auto* state = static_cast<TimerState*>(timer->data);
+                 v8::HandleScope handle_scope(state->isolate);
+                 Local<Context> context = state->isolate->GetCurrentContext();
+                 state->inline_done =
+                     context->Global()
+                         ->Get(context,
+                               String::NewFromUtf8Literal(state->isolate,
+                                                          "zlibInline"))
+                         .ToLocalChecked()
+                         ->IsTrue();
+                 state->blocker->Release();
+                 uv_close(reinterpret_cast<uv_handle_t*>(timer), nullptr);
+               },
+               1000,
+               0));
+
+  node::LoadEnvironment(
+      *env,
+      "const assert = require('assert');\n"
+      "const zlib = require('zlib');\n"
+      "const input = Buffer.alloc(64, 'one-shot ');\n"
+      "// Synchronous writes are measured as well.\n"
+      "for (let i = 0; i < 8; i++) zlib.deflateSync(input);\n"
+      "zlib.deflate(input, (err, out) => {\n"
+      "  assert.ifError(err);\n"
+      "  assert.deepStrictEqual(zlib.inflateSync(out), input);\n"
+      "  globalThis.zlibInline = true;\n"
+      "});\n");
+
+  EXPECT_EQ(node::SpinEventLoop(*env).FromJust(), 0);
+  EXPECT_TRUE(state.inline_done);
+}
@@ -1,6 +1,7 @@
 #include "node_internals.h"
 #include "libplatform/libplatform.h"
 
+#include <atomic>
 #include <string>
 #include "gtest/gtest.h"
 #include "node_test_fixture.h"
@@ -60,6 +61,39 @@ TEST_F(PlatformTest, SkipNewTasksInFlushForegroundTasks) {
   EXPECT_FALSE(platform->FlushForegroundTasks(isolate_));
 }
 
+// This task increments the given run counter and posts two copies of itself
+// with one less depth to the worker threads, from a worker thread.
+class FanOutTask : public v8::Task {
+ public:
+  FanOutTask(int depth, std::atomic<int>* run_count, v8::Platform* platform)
+      : depth_(depth), run_count_(run_count), platform_(platform) {}
+
+  // v8::Task implementation
+  void Run() final {
+    run_count_->fetch_add(1);
+    if (depth_ == 0) return;
+    for (int i = 0; i < 2; i++) {
+      platform_->PostTaskOnWorkerThread(
+          v8::TaskPriority::kUserBlocking,
+          std::make_unique<FanOutTask>(depth_ - 1, run_count_, platform_));
+    }
+  }
+
+ private:
+  int depth_;
+  std::atomic<int>* run_count_;
+  v8::Platform* platform_;
+};
+
+TEST_F(PlatformTest, DrainTasksPostedFromWorkerThreads) {
+  std::atomic<int> run_count{0};
+  platform->PostTaskOnWorkerThread(
+      v8::TaskPriority::kUserBlocking,
+      std::make_unique<FanOutTask>(10, &run_count, platform.get()));
+  platform->DrainTasks(isolate_);
+  EXPECT_EQ((1 << 11) - 1, run_count.load());
+}
+
 // Tests the registration of an abstract `IsolatePlatformDelegate` instance as
 // opposed to the more common `uv_loop_s*` version of `RegisterIsolate`.
 TEST_F(NodeZeroIsolateTestFixture, IsolatePlatformDelegateTest) {
@@ -215,3 +215,110 @@ TEST(SocketAddressBlockList, Simple) {
   CHECK(!bl.Apply(addr1));
   CHECK(bl.Apply(addr2));
 }
+
+namespace {
+std::shared_ptr<SocketAddress> MakeAddress(int family, const char* ip) {
+  sockaddr_storage storage;
+  CHECK(SocketAddress::ToSockAddr(family, ip, 0, &storage));
+  return std::make_shared<SocketAddress>(
+      reinterpret_cast<const sockaddr*>(&storage));
+}
+}  // namespace
+
+TEST(SocketAddressBlockList, Masks) {
+  SocketAddressBlockList bl;
+
+  bl.AddSocketAddressMask(MakeAddress(AF_INET, "10.0.0.0"), 8);
+  bl.AddSocketAddressMask(MakeAddress(AF_INET, "10.1.0.0"), 16);
+  bl.AddSocketAddressMask(MakeAddress(AF_INET6, "2001:db8::"), 32);
+
+  CHECK(bl.Apply(MakeAddress(AF_INET, "10.255.0.1")));
+  CHECK(bl.Apply(MakeAddress(AF_INET, "10.1.2.3")));
+  CHECK(!bl.Apply(MakeAddress(AF_INET, "11.0.0.1")));
+  CHECK(bl.Apply(MakeAddress(AF_INET6, "::ffff:10.0.0.1")));
+  CHECK(!bl.Apply(MakeAddress(AF_INET6, "::10.0.0.1")));
+  CHECK(bl.Apply(MakeAddress(AF_INET6, "2001:db8:1::1")));
+  CHECK(!bl.Apply(MakeAddress(AF_INET6, "2001:db9::1")));
+
+  bl.AddSocketAddressMask(MakeAddress(AF_INET, "0.0.0.0"), 0);
+  CHECK(bl.Apply(MakeAddress(AF_INET, "192.168.0.1")));
+  CHECK(bl.Apply(MakeAddress(AF_INET6, "::ffff:192.168.0.1")));
+  CHECK(!bl.Apply(MakeAddress(AF_INET6, "2001:db9::1")));
+}
+
+TEST(SocketAddressBlockList, Ranges) {
+  SocketAddressBlockList bl;
+
+  bl.AddSocketAddressRange(MakeAddress(AF_INET, "10.0.0.10"),
+                           MakeAddress(AF_INET, "10.0.0.20"));
+  bl.AddSocketAddressRange(MakeAddress(AF_INET, "10.0.0.15"),
+                           MakeAddress(AF_INET, "10.0.0.30"));
+  bl.AddSocketAddressRange(MakeAddress(AF_INET6, "::"),
+                           MakeAddress(AF_INET6, "::ffff"));
+
+  CHECK(!bl.Apply(MakeAddress(AF_INET, "10.0.0.9")));
+  CHECK(bl.Apply(MakeAddress(AF_INET, "10.0.0.10")));
+  CHECK(bl.Apply(MakeAddress(AF_INET, "10.0.0.25")));
+  CHECK(bl.Apply(MakeAddress(AF_INET, "10.0.0.30")));
+  CHECK(!bl.Apply(MakeAddress(AF_INET, "10.0.0.31")));
+  CHECK(bl.Apply(MakeAddress(AF_INET6, "::ffff:10.0.0.12")));
+  CHECK(bl.Apply(MakeAddress(AF_INET6, "::1")));
+  // IPv4 addresses never fall into a range of plain IPv6 addresses.
+  CHECK(!bl.Apply(MakeAddress(AF_INET, "0.0.0.1")));
+}
+
+TEST(SocketAddressBlockList, MatchesRules) {
+  auto parent = std::make_shared<SocketAddressBlockList>();
+  parent->AddSocketAddress(MakeAddress(AF_INET, "172.16.0.1"));
+  SocketAddressBlockList bl(parent);
+
+  std::vector<std::unique_ptr<SocketAddressBlockList::Rule>> rules;
+  auto add_mask = [&](int family, const char* ip, int prefix) {
+    auto network = MakeAddress(family, ip);
+    bl.AddSocketAddressMask(network, prefix);
+    rules.push_back(
+        std::make_unique<SocketAddressBlockList::SocketAddressMaskRule>(
+            network, prefix));
+  };
+  auto add_range = [&](int sf, const char* s, int ef, const char* e) {
+    auto start = MakeAddress(sf, s);
+    auto end = MakeAddress(ef, e);
+    bl.AddSocketAddressRange(start, end);
+    rules.push_back(
+        std::make_unique<SocketAddressBlockList::SocketAddressRangeRule>(
+            start, end));
+  };
+
+  add_mask(AF_INET, "192.168.1.0", 24);
+  add_mask(AF_INET6, "::ffff:192.168.0.0", 112);
+  add_mask(AF_INET6, "fe80::", 10);
+  add_range(AF_INET, "1.2.3.4", AF_INET6, "::ffff:1.2.4.0");
+  add_range(AF_INET, "8.8.8.0", AF_INET6, "2001::");
+  add_range(AF_INET6, "fe00::", AF_INET6, "ff00::");
+  bl.AddSocketAddress(MakeAddress(AF_INET6, "::ffff:9.9.9.9"));
+  rules.push_back(
+      std::make_unique<SocketAddressBlockList::SocketAddressRule>(
+          MakeAddress(AF_INET, "9.9.9.9")));
+
+  const std::pair<int, const char*> probes[] = {
+      {AF_INET, "192.168.1.7"},    {AF_INET, "192.168.2.7"},
+      {AF_INET, "192.167.0.1"},    {AF_INET, "1.2.3.3"},
+      {AF_INET, "1.2.3.200"},      {AF_INET, "1.2.4.1"},
+      {AF_INET, "8.8.8.8"},        {AF_INET, "9.9.9.9"},
+      {AF_INET6, "::ffff:9.9.9.9"}, {AF_INET6, "::ffff:8.8.8.8"},
+      {AF_INET6, "::8.8.8.8"},     {AF_INET6, "fe80::1"},
+      {AF_INET6, "fec0::1"},       {AF_INET6, "ff00::"},
+      {AF_INET6, "ff00::1"},       {AF_INET6, "::ffff:192.168.200.1"},
+      {AF_INET6, "1000::"},
+  };
+  for (const auto& [family, ip] : probes) {
+    auto address = MakeAddress(family, ip);
+    bool expected = false;
+    for (const auto& rule : rules)
+      expected = expected || rule->Apply(address);
+    CHECK_EQ(bl.Apply(address), expected);
+  }
+
+  CHECK(bl.Apply(MakeAddress(AF_INET, "172.16.0.1")));
+  CHECK(bl.Apply(MakeAddress(AF_INET6, "::ffff:172.16.0.1")));
+}
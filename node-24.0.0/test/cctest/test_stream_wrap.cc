@@ -0,0 +1,166 @@
+#include "gtest/gtest.h"
+#include "node_debug.h"
+#include "node_test_fixture.h"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <string>
+
+using v8::Context;
+using v8::Local;
+using v8::String;
+using v8::Value;
+
+class StreamWrapTest : public EnvironmentTestFixture {};
+
+// The first write on an idle TCP stream is written right away, later writes
+// of the same loop iteration are staged. Destroying the socket right after
+// the writes still delivers everything to the peer.
+TEST_F(StreamWrapTest, CorkedWritesFlushedOnClose) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+
+  SetProcessExitHandler(*env, [&](node::Environment* env_, int exit_code) {
+    EXPECT_EQ(exit_code, 0);
+    node::Stop(*env);
+  });
+
+  node::LoadEnvironment(
+      *env,
+      "const assert = require('assert');\n"
+      "const net = require('net');\n"
+      "globalThis.streamChecks = 0;\n"
+      "const server = net.createServer((conn) => {\n"
+      "  let data = '';\n"
+      "  conn.setEncoding('latin1');\n"
+      "  conn.on('data', (chunk) => data += chunk);\n"
+      "  conn.on('end', () => {\n"
+      "    assert.strictEqual(data, 'hello world');\n"
+      "    globalThis.streamChecks++;\n"
+      "    server.close();\n"
+      "  });\n"
+      "});\n"
+      "server.listen(0, '127.0.0.1', () => {\n"
+      "  const { port } = server.address();\n"
+      "  const socket = net.connect(port, '127.0.0.1', () => {\n"
+      "    socket.write('hello');\n"
+      "    assert.strictEqual(socket._handle.writeQueueSize, 0);\n"
+      "    socket.write(' world');\n"
+      "    assert.strictEqual(socket._handle.writeQueueSize, 6);\n"
+      "    socket.destroy();\n"
+      "    globalThis.streamChecks++;\n"
+      "  });\n"
+      "});\n");
+
+  EXPECT_EQ(node::SpinEventLoop(*env).FromJust(), 0);
+
+  Local<Context> context = isolate_->GetCurrentContext();
+  Local<Value> checks =
+      context->Global()
+          ->Get(context,
+                String::NewFromUtf8Literal(isolate_, "streamChecks"))
+          .ToLocalChecked();
+  EXPECT_EQ(checks->Int32Value(context).FromJust(), 2);
+}
+
+#ifdef DEBUG
+// Once optimized, calls to readStart(), readStop(), setNoDelay() and
+// setKeepAlive() on a TCP handle take the V8 fast API path.
+TEST_F(StreamWrapTest, TCPFastApiCalls) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+
+  SetProcessExitHandler(*env, [&](node::Environment* env_, int exit_code) {
+    EXPECT_EQ(exit_code, 0);
+    node::Stop(*env);
+  });
+
+  node::LoadEnvironment(
+      *env,
+      "const assert = require('assert');\n"
+      "const net = require('net');\n"
+      "function hot(handle) {\n"
+      "  let err = 0;\n"
+      "  for (let i = 0; i < 100000; i++) {\n"
+      "    err |= handle.readStop() | handle.readStart();\n"
+      "    err |= handle.setNoDelay(true) | handle.setKeepAlive(true, 1);\n"
+      "  }\n"
+      "  return err;\n"
+      "}\n"
+      "const server = net.createServer((conn) => conn.destroy());\n"
+      "server.listen(0, '127.0.0.1', () => {\n"
+      "  const { port } = server.address();\n"
+      "  const socket = net.connect(port, '127.0.0.1', () => {\n"
+      "    assert.strictEqual(hot(socket._handle), 0);\n"
+      "    socket.destroy();\n"
+      "    server.close();\n"
+      "  });\n"
+      "});\n");
+
+  EXPECT_EQ(node::SpinEventLoop(*env).FromJust(), 0);
+
+  EXPECT_GT(node::debug::GetV8FastApiCallCount("tcp_wrap.readStart"), 0);
+  EXPECT_GT(node::debug::GetV8FastApiCallCount("tcp_wrap.readStop"), 0);
+  EXPECT_GT(node::debug::GetV8FastApiCallCount("tcp_wrap.setNoDelay"), 0);
+  EXPECT_GT(node::debug::GetV8FastApiCallCount("tcp_wrap.setKeepAlive"), 0);
+}
+#endif  // DEBUG
+
+#ifndef _WIN32  // Uses a POSIX socket as the peer.
+// Writes which are still staged when process.exit() is called have reached
+// the peer by the time the process exit handler runs.
+TEST_F(StreamWrapTest, CorkedWritesFlushedOnExit) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(listener, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ASSERT_EQ(bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)),
+            0);
+  ASSERT_EQ(listen(listener, 1), 0);
+  socklen_t addrlen = sizeof(addr);
+  ASSERT_EQ(
+      getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &addrlen), 0);
+
+  std::string received;
+  SetProcessExitHandler(*env, [&](node::Environment* env_, int exit_code) {
+    EXPECT_EQ(exit_code, 0);
+    int conn = accept(listener, nullptr, nullptr);
+    EXPECT_GE(conn, 0);
+    char buf[16];
+    ssize_t n;
+    while ((n = recv(conn, buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+      received.append(buf, n);
+    close(conn);
+    node::Stop(*env);
+  });
+
+  std::string script =
+      "const net = require('net');\n"
+      "const socket = net.connect(" +
+      std::to_string(ntohs(addr.sin_port)) +
+      ", '127.0.0.1', () => {\n"
+      "  socket.write('first');\n"
+      "  socket.write(' second');\n"
+      "  socket.write(' third');\n"
+      "  process.exit(0);\n"
+      "});\n";
+  node::LoadEnvironment(*env, script.c_str());
+
+  EXPECT_TRUE(node::SpinEventLoop(*env).IsNothing());
+  close(listener);
+
+  EXPECT_EQ(received, "first second third");
+}
+#endif  // _WIN32